@@ -0,0 +1,285 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <subdev/bios.h>
+#include <subdev/bios/bit.h>
+#include <subdev/bios/dcb.h>
+#include <subdev/bios/gpio.h>
+#include <subdev/bios/i2c.h>
+#include <subdev/bios/perf.h>
+#include <subdev/bios/pll.h>
+#include <subdev/bios/vmap.h>
+#include <subdev/bios/volt.h>
+
+/* Counts the VBIOS image reads made by the table lookups that a device
+ * performs while initialising, with and without the table index built at
+ * load time, for each of the ROM images given on the command line.  The
+ * results of each lookup are hashed, and must match between the two.
+ *
+ * The image accessors here take the place of the library's own.
+ */
+static unsigned long bench_rd;
+static u64 bench_hash;
+
+static bool
+bench_addr(struct nvkm_bios *bios, u32 *addr, u8 size)
+{
+	if (*addr > bios->image0_size && bios->imaged_addr) {
+		*addr -= bios->image0_size;
+		*addr += bios->imaged_addr;
+	}
+	return *addr + size < bios->size;
+}
+
+u8
+nvbios_rd08(struct nvkm_bios *bios, u32 addr)
+{
+	bench_rd++;
+	if (bench_addr(bios, &addr, 1))
+		return bios->data[addr];
+	return 0x00;
+}
+
+u16
+nvbios_rd16(struct nvkm_bios *bios, u32 addr)
+{
+	bench_rd++;
+	if (bench_addr(bios, &addr, 2))
+		return get_unaligned_le16(&bios->data[addr]);
+	return 0x0000;
+}
+
+u32
+nvbios_rd32(struct nvkm_bios *bios, u32 addr)
+{
+	bench_rd++;
+	if (bench_addr(bios, &addr, 4))
+		return get_unaligned_le32(&bios->data[addr]);
+	return 0x00000000;
+}
+
+static void
+bench_mix(const void *data, size_t size)
+{
+	const u8 *byte = data;
+	while (size--)
+		bench_hash = (bench_hash ^ *byte++) * 0x100000001b3ULL;
+}
+
+#define MIX(v) ({ typeof(v) _v = (v); bench_mix(&_v, sizeof(_v)); _v; })
+
+static void
+bench_init(struct nvkm_bios *bios)
+{
+	static const u8 gpio[] = {
+		DCB_GPIO_PANEL_POWER, DCB_GPIO_VID0, DCB_GPIO_VID1,
+		DCB_GPIO_VID2, DCB_GPIO_VID3, DCB_GPIO_VID4, DCB_GPIO_VID5,
+		DCB_GPIO_VID6, DCB_GPIO_VID7, DCB_GPIO_VID_PWM, DCB_GPIO_FAN,
+		DCB_GPIO_FAN_SENSE, DCB_GPIO_TVDAC0, DCB_GPIO_TVDAC1,
+		DCB_GPIO_THERM_EXT_POWER_EVENT, DCB_GPIO_POWER_ALERT,
+		DCB_GPIO_EXT_POWER_LOW, DCB_GPIO_LOGO_LED_PWM,
+		0x07, 0x08, 0x51, 0x52, 0x5e, 0x5f, 0x60, 0x61, /* HPD */
+	};
+	static const u32 pll[] = {
+		PLL_CORE, PLL_SHADER, PLL_UNK03, PLL_MEMORY, PLL_VDEC,
+		PLL_UNK40, PLL_UNK41, PLL_UNK42, PLL_VPLL0, PLL_VPLL1,
+		PLL_VPLL2, PLL_VPLL3,
+	};
+	struct dcb_output outp;
+	struct dcb_gpio_func func;
+	struct dcb_i2c_entry i2c;
+	struct nvbios_perfE perfE;
+	struct nvbios_pll limits;
+	struct nvbios_volt_entry voltE;
+	struct nvbios_volt volt;
+	struct nvbios_vmap_entry vmapE;
+	struct nvbios_vmap vmap;
+	struct bit_entry bit;
+	u8  ver, hdr, cnt, len;
+	int i, j;
+
+	for (i = 0; i < 0x80; i++) {
+		if (!bit_entry(bios, i, &bit))
+			MIX(bit);
+	}
+
+	/* Output/connector/I2C setup, and per-output lookups by type. */
+	for (i = 0; (MIX(dcb_outp_parse(bios, i, &ver, &len, &outp))); i++) {
+		MIX(outp);
+		MIX(dcb_outp_match(bios, outp.hasht, outp.hashm,
+				   &ver, &len, &outp));
+	}
+
+	for (i = 0; i < 16; i++) {
+		if (!dcb_i2c_parse(bios, i, &i2c))
+			MIX(i2c);
+	}
+
+	/* GPIO functions, looked up once per subdev that wants them. */
+	for (j = 0; j < 4; j++) {
+		for (i = 0; i < ARRAY_SIZE(gpio); i++) {
+			if (MIX(dcb_gpio_match(bios, 0, gpio[i], 0xff,
+					       &ver, &len, &func)))
+				MIX(func);
+		}
+	}
+
+	for (i = 0; i < ARRAY_SIZE(pll); i++) {
+		if (!nvbios_pll_parse(bios, pll[i], &limits))
+			MIX(limits);
+	}
+
+	for (i = 0; (MIX(nvbios_perfEp(bios, i, &ver, &hdr, &cnt, &len,
+					&perfE))); i++)
+		MIX(perfE);
+
+	MIX(nvbios_volt_parse(bios, &ver, &hdr, &cnt, &len, &volt));
+	MIX(volt);
+	for (i = 0; i < cnt; i++) {
+		if (nvbios_volt_entry_parse(bios, i, &ver, &len, &voltE))
+			MIX(voltE);
+	}
+
+	MIX(nvbios_vmap_parse(bios, &ver, &hdr, &cnt, &len, &vmap));
+	MIX(vmap);
+	for (i = 0; i < cnt; i++) {
+		if (nvbios_vmap_entry_parse(bios, i, &ver, &len, &vmapE))
+			MIX(vmapE);
+	}
+}
+
+static int
+bench_card_type(u32 chipset)
+{
+	switch (chipset & 0x1f0) {
+	case 0x000: return NV_04;
+	case 0x010: return NV_10;
+	case 0x020: return NV_20;
+	case 0x030: return NV_30;
+	case 0x040:
+	case 0x060: return NV_40;
+	case 0x050:
+	case 0x080:
+	case 0x090:
+	case 0x0a0: return NV_50;
+	case 0x0c0:
+	case 0x0d0: return NV_C0;
+	case 0x0e0:
+	case 0x0f0:
+	case 0x100: return NV_E0;
+	case 0x110:
+	case 0x120: return GM100;
+	case 0x130: return GP100;
+	case 0x140: return GV100;
+	default:
+		return TU100;
+	}
+}
+
+static int
+bench(const char *path, u32 chipset, int loops)
+{
+	struct device dev = { .name = "bench" };
+	struct nvkm_device device = {
+		.dev = &dev,
+		.dbgopt = "error",
+		.chipset = chipset,
+		.card_type = bench_card_type(chipset),
+	};
+	struct nvkm_subdev *subdev;
+	struct nvkm_bios *bios;
+	unsigned long rd[2];
+	char cfgopt[256];
+	u64 hash[2];
+	s64 time[2];
+	int ret, i, j;
+
+	snprintf(cfgopt, sizeof(cfgopt), "NvBios=%s", path);
+	device.cfgopt = cfgopt;
+
+	bench_rd = 0;
+	ret = nvkm_bios_new(&device, NVKM_SUBDEV_VBIOS, &bios);
+	subdev = bios ? &bios->subdev : NULL;
+	if (ret) {
+		fprintf(stderr, "%s: %d\n", path, ret);
+		nvkm_subdev_del(&subdev);
+		return ret;
+	}
+	device.bios = bios;
+
+	printf("%s: %d bytes, index built with %lu reads\n",
+	       path, bios->size, bench_rd);
+
+	for (i = 0; i < 2; i++) {
+		bios->index.valid = i;
+		bench_rd = 0;
+		bench_hash = 0xcbf29ce484222325ULL;
+		bench_init(bios);
+		rd[i] = bench_rd;
+		hash[i] = bench_hash;
+
+		time[i] = ktime_to_ns(ktime_get());
+		for (j = 0; j < loops; j++)
+			bench_init(bios);
+		time[i] = ktime_to_ns(ktime_get()) - time[i];
+
+		printf("  %-8s: %lu reads/init, %lldns/init\n",
+		       i ? "indexed" : "walked", rd[i], time[i] / loops);
+	}
+
+	nvkm_subdev_del(&subdev);
+	if (hash[0] != hash[1]) {
+		fprintf(stderr, "%s: lookup results differ\n", path);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	u32 chipset = 0x0e4;
+	int loops = 1000;
+	int ret, c, i;
+
+	while ((c = getopt(argc, argv, "c:l:")) != -1) {
+		switch (c) {
+		case 'c': chipset = strtol(optarg, NULL, 0); break;
+		case 'l': loops = strtol(optarg, NULL, 0); break;
+		default:
+			return 1;
+		}
+	}
+
+	if (loops < 1 || optind >= argc) {
+		fprintf(stderr, "usage: %s [-c chipset] [-l loops] rom...\n",
+			argv[0]);
+		return 1;
+	}
+
+	for (i = optind; i < argc; i++) {
+		if ((ret = bench(argv[i], chipset, loops)))
+			return ret;
+	}
+
+	return 0;
+}
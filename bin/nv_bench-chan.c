@@ -0,0 +1,438 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <nvif/chan.h>
+#include <nvif/client.h>
+#include <nvif/device.h>
+#include <nvif/driver.h>
+#include <nvif/push906f.h>
+
+#include <nvhw/class/cl906f.h>
+
+/* Measures submission through nvif_chan against a simulated channel.
+ * The simulator stands in for host: it reads GP_PUT from a calloc()'d
+ * USERD, fetches GPFIFO entries, decodes the methods in each segment,
+ * executes semaphore releases, and moves GP_GET and GET along as it goes.
+ *
+ * By default it runs from the doorbell, leaving up to 'lag' entries
+ * outstanding so the ring fills and wraps, and catches up completely
+ * whenever nvif_chan polls the clock while waiting.  With -t it's a
+ * separate thread instead.
+ *
+ * Each submission is a run of SET_REFERENCE methods carrying a running
+ * count, which the simulator checks, so any pushbuffer space handed out
+ * again before the GPU was done with it shows up as an error.  The fake
+ * device's client counts ioctls, which should stay at zero throughout.
+ */
+#define BENCH_ADDR 0x0000004000000000ULL
+
+static struct {
+	struct nvif_client client;
+	struct nvif_parent parent;
+	struct nvif_device device;
+	u32 reference;
+	u64 ioctls;
+	u64 doorbells;
+} bench;
+
+static struct {
+	u32 *userd;
+	u8 *ptr;
+	u64 size;
+	u32 *gpfifo;
+	u32 gpfifo_nr;
+	s64 cost_ns;
+
+	u32 gp_get;
+	u32 lag;
+	bool threaded;
+	pthread_t thread;
+	volatile bool fini;
+
+	u64 entries;
+	u64 methods;
+	u32 reference;
+	u32 sem_hi;
+	u32 sem_lo;
+	u32 sem_data;
+	int errors;
+} sim;
+
+static void *
+sim_addr(u64 addr, u64 size)
+{
+	if (addr < BENCH_ADDR || addr + size > BENCH_ADDR + sim.size) {
+		sim.errors++;
+		return NULL;
+	}
+	return sim.ptr + (addr - BENCH_ADDR);
+}
+
+static void
+sim_mthd(int subc, u32 mthd, u32 data)
+{
+	s64 time;
+	u32 *sem;
+
+	sim.methods++;
+	if (sim.cost_ns) {
+		time = ktime_to_ns(ktime_get());
+		while (ktime_to_ns(ktime_get()) - time < sim.cost_ns);
+	}
+
+	if (subc != 0)
+		return;
+
+	switch (mthd) {
+	case NV906F_SEMAPHOREA: sim.sem_hi = data & 0xff; break;
+	case NV906F_SEMAPHOREB: sim.sem_lo = data; break;
+	case NV906F_SEMAPHOREC: sim.sem_data = data; break;
+	case NV906F_SEMAPHORED:
+		if (NVVAL_GET(data, NV906F, SEMAPHORED, OPERATION) !=
+		    NV906F_SEMAPHORED_OPERATION_RELEASE) {
+			sim.errors++;
+			break;
+		}
+		sem = sim_addr((u64)sim.sem_hi << 32 | sim.sem_lo, 4);
+		if (sem) {
+			mb();
+			iowrite32_native(sim.sem_data, sem);
+		}
+		break;
+	case NV906F_SET_REFERENCE:
+		if (data != sim.reference++)
+			sim.errors++;
+		break;
+	default:
+		break;
+	}
+}
+
+static void
+sim_exec(u64 addr, u32 size)
+{
+	u32 *data = sim_addr(addr, size * 4);
+	u32 hdr, mthd, count;
+	int subc, op;
+
+	if (!data)
+		return;
+
+	while (size) {
+		hdr = *data++;
+		size--;
+
+		mthd = NVVAL_GET(hdr, NV906F, DMA, METHOD_ADDRESS) << 2;
+		subc = NVVAL_GET(hdr, NV906F, DMA, METHOD_SUBCHANNEL);
+		count = NVVAL_GET(hdr, NV906F, DMA, METHOD_COUNT);
+		op = NVVAL_GET(hdr, NV906F, DMA, SEC_OP);
+
+		if (op == NV906F_DMA_SEC_OP_IMMD_DATA_METHOD) {
+			sim_mthd(subc, mthd, count);
+			continue;
+		}
+
+		if (count > size || (op != NV906F_DMA_SEC_OP_INC_METHOD &&
+				     op != NV906F_DMA_SEC_OP_NON_INC_METHOD &&
+				     op != NV906F_DMA_SEC_OP_ONE_INC)) {
+			sim.errors++;
+			return;
+		}
+
+		size -= count;
+		while (count--) {
+			sim_mthd(subc, mthd, *data++);
+			if (op == NV906F_DMA_SEC_OP_INC_METHOD ||
+			    op == NV906F_DMA_SEC_OP_ONE_INC) {
+				if (op == NV906F_DMA_SEC_OP_ONE_INC)
+					op = NV906F_DMA_SEC_OP_NON_INC_METHOD;
+				mthd += 4;
+			}
+		}
+	}
+}
+
+/* Processes GPFIFO entries until no more than 'keep' are outstanding. */
+static void
+sim_run(u32 keep)
+{
+	u32 gp_put, *entry;
+	u64 addr, end;
+	u32 size;
+
+	gp_put = ioread32_native(&sim.userd[0x8c / 4]);
+	mb();
+
+	while (((gp_put - sim.gp_get) & (sim.gpfifo_nr - 1)) > keep) {
+		entry = &sim.gpfifo[sim.gp_get * 2];
+		addr = (u64)(entry[1] & 0x000000ff) << 32 | entry[0];
+		size = (entry[1] >> 10) & 0x001fffff;
+		sim.entries++;
+
+		/* Host has the entry, but not necessarily its methods. */
+		sim.gp_get = (sim.gp_get + 1) & (sim.gpfifo_nr - 1);
+		iowrite32_native(sim.gp_get, &sim.userd[0x88 / 4]);
+
+		sim_exec(addr, size);
+
+		end = addr + size * 4;
+		mb();
+		iowrite32_native(lower_32_bits(end), &sim.userd[0x44 / 4]);
+		iowrite32_native(upper_32_bits(end), &sim.userd[0x60 / 4]);
+	}
+}
+
+static void *
+sim_thread(void *priv)
+{
+	while (!sim.fini) {
+		if (ioread32_native(&sim.userd[0x8c / 4]) == sim.gp_get) {
+			sched_yield();
+			continue;
+		}
+		sim_run(0);
+	}
+
+	return NULL;
+}
+
+static int
+bench_ioctl(void *priv, bool super, void *data, u32 size, void **hack)
+{
+	bench.ioctls++;
+	return -ENODEV;
+}
+
+static const struct nvif_driver
+bench_driver = {
+	.name = "bench",
+	.ioctl = bench_ioctl,
+};
+
+static void
+bench_printf(struct nvif_object *object, const char *fmt, ...)
+{
+}
+
+static const struct nvif_parent_func
+bench_parent = {
+	.debugf = bench_printf,
+	.errorf = bench_printf,
+};
+
+static void
+bench_doorbell(struct nvif_user *user, u32 token)
+{
+	bench.doorbells++;
+	if (!sim.threaded)
+		sim_run(sim.lag);
+}
+
+/* Anyone polling the clock is waiting on the GPU, so let it catch up. */
+static u64
+bench_time(struct nvif_user *user)
+{
+	if (!sim.threaded)
+		sim_run(0);
+	return ktime_to_ns(ktime_get());
+}
+
+static const struct nvif_user_func
+bench_user = {
+	.doorbell = bench_doorbell,
+	.time = bench_time,
+};
+
+/* 'loops' submissions of 'dwords' each, with a fence every 'fence' of
+ * them, and then waits for the last fence.
+ */
+static int
+bench_submit(struct nvif_chan *chan, int loops, u32 dwords, int fence)
+{
+	struct nvif_push *push = &chan->push;
+	u64 ioctls = bench.ioctls, doorbells = bench.doorbells;
+	u64 entries = sim.entries;
+	u32 data[2048], seqno = 0;
+	int ret, i, j, fences = 0;
+	s64 time;
+
+	time = ktime_to_ns(ktime_get());
+	for (i = 0; i < loops; i++) {
+		ret = PUSH_WAIT(push, dwords + 1);
+		if (ret)
+			return ret;
+
+		for (j = 0; j < dwords; j++)
+			data[j] = bench.reference++;
+		PUSH_NINC(push, NV906F, SET_REFERENCE, data, dwords);
+		PUSH_KICK(push);
+
+		if (fence && (i + 1) % fence == 0) {
+			ret = nvif_chan_fence(chan, &seqno);
+			if (ret)
+				return ret;
+			fences++;
+		}
+	}
+
+	if (!fences || loops % fence) {
+		ret = nvif_chan_fence(chan, &seqno);
+		if (ret)
+			return ret;
+		fences++;
+	}
+
+	ret = nvif_chan_fence_wait(chan, seqno);
+	if (ret)
+		return ret;
+	time = ktime_to_ns(ktime_get()) - time;
+
+	printf("%5d %6d %8d %8llu %8llu %6llu %10lld %8lld %10lld\n",
+	       dwords, fence, loops, sim.entries - entries,
+	       bench.doorbells - doorbells, bench.ioctls - ioctls,
+	       time / 1000, time / loops,
+	       time ? (s64)loops * 1000000000 / time : 0);
+	return 0;
+}
+
+/* Round-trip of an empty fence. */
+static int
+bench_fence(struct nvif_chan *chan, int loops)
+{
+	u32 seqno;
+	int ret, i;
+	s64 time;
+
+	time = ktime_to_ns(ktime_get());
+	for (i = 0; i < loops; i++) {
+		ret = nvif_chan_fence(chan, &seqno);
+		if (ret == 0)
+			ret = nvif_chan_fence_wait(chan, seqno);
+		if (ret)
+			return ret;
+	}
+	time = ktime_to_ns(ktime_get()) - time;
+
+	printf("%d fence round-trips in %lldus, %lldns/fence\n",
+	       loops, time / 1000, time / loops);
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct nvif_object userd = {};
+	struct nvif_chan chan;
+	u32 push_size = 0x10000, gpfifo_nr = 1024;
+	int loops = 1000000, ret, c, i;
+	static const u32 sizes[] = { 2, 16, 128, 1024 };
+	static const int fences[] = { 0, 1, 64 };
+
+	sim.lag = 64;
+	while ((c = getopt(argc, argv, "c:g:l:p:q:t")) != -1) {
+		switch (c) {
+		case 'c': sim.cost_ns = strtol(optarg, NULL, 0); break;
+		case 'g': gpfifo_nr = strtol(optarg, NULL, 0); break;
+		case 'l': loops = strtol(optarg, NULL, 0); break;
+		case 'p': push_size = strtol(optarg, NULL, 0); break;
+		case 'q': sim.lag = strtol(optarg, NULL, 0); break;
+		case 't': sim.threaded = true; break;
+		default:
+			return 1;
+		}
+	}
+
+	if (loops < 1 || push_size < 0x4000)
+		return 1;
+
+	/* Enough of a client and device for nvif_chan. */
+	nvif_parent_ctor(&bench_parent, &bench.parent);
+	bench.client.object.parent = &bench.parent;
+	bench.client.object.client = &bench.client;
+	bench.client.object.name = "bench";
+	bench.client.driver = &bench_driver;
+	bench.device.object.parent = &bench.parent;
+	bench.device.object.client = &bench.client;
+	bench.device.object.name = "benchDevice";
+	bench.device.user.func = &bench_user;
+
+	sim.size = push_size + gpfifo_nr * 8 + NVIF_CHAN_FENCE_SIZE;
+	sim.ptr = calloc(1, sim.size);
+	sim.userd = calloc(1, 0x200);
+	if (!sim.ptr || !sim.userd)
+		return -ENOMEM;
+	sim.gpfifo = (u32 *)(sim.ptr + push_size);
+	sim.gpfifo_nr = gpfifo_nr;
+	userd.map.ptr = sim.userd;
+
+	ret = nvif_chan_ctor(&bench.device, "benchChan", &userd, 0, sim.ptr,
+			     BENCH_ADDR, push_size, gpfifo_nr, &chan);
+	if (ret) {
+		fprintf(stderr, "chan: %d\n", ret);
+		return ret;
+	}
+
+	if (sim.threaded)
+		pthread_create(&sim.thread, NULL, sim_thread, NULL);
+
+	printf("pushbuf 0x%x bytes, %d GPFIFO entries, %lldns/method, ",
+	       push_size, gpfifo_nr, sim.cost_ns);
+	if (sim.threaded)
+		printf("threaded\n");
+	else
+		printf("lag %d\n", sim.lag);
+	printf("%5s %6s %8s %8s %8s %6s %10s %8s %10s\n", "dwords", "fence",
+	       "submits", "entries", "doorbell", "ioctl", "us", "ns/sub",
+	       "sub/s");
+	for (i = 0; i < ARRAY_SIZE(sizes) * ARRAY_SIZE(fences); i++) {
+		u32 dwords = sizes[i / ARRAY_SIZE(fences)];
+		int fence = fences[i % ARRAY_SIZE(fences)];
+		int nr = loops / (dwords >= 128 ? dwords / 16 : 1);
+
+		if (dwords + 1 >= push_size / 8)
+			continue;
+
+		ret = bench_submit(&chan, nr, dwords, fence);
+		if (ret) {
+			fprintf(stderr, "submit: %d\n", ret);
+			goto done;
+		}
+	}
+
+	ret = bench_fence(&chan, loops / 10 ? loops / 10 : 1);
+	if (ret)
+		fprintf(stderr, "fence: %d\n", ret);
+
+done:
+	if (sim.threaded) {
+		sim.fini = true;
+		pthread_join(sim.thread, NULL);
+	}
+
+	printf("%llu methods, %d errors, %llu ioctls\n",
+	       sim.methods, sim.errors, bench.ioctls);
+	assert(ret || (sim.errors == 0 && bench.ioctls == 0));
+
+	nvif_chan_dtor(&chan);
+	free(sim.userd);
+	free(sim.ptr);
+	return ret;
+}
@@ -0,0 +1,309 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <core/client.h>
+#include <core/ramht.h>
+#include <engine/dma.h>
+
+#include <nvif/cl0002.h>
+#include <nvif/class.h>
+
+#include "../drm/nouveau/nvkm/engine/dma/priv.h"
+#include "../drm/nouveau/nvkm/subdev/instmem/priv.h"
+
+/* Models channel creation on nv04-style hardware, where ctxdmas can live
+ * anywhere in instance memory: each client has its own VRAM and GART DMA
+ * objects covering the same ranges, and each loop tears down one client's
+ * channel and creates it again, binding both into the shared RAMHT.
+ */
+static u64 bench_words, bench_objs, bench_bytes, bench_peak, bench_addr;
+
+struct bench_instobj {
+	struct nvkm_instobj base;
+	struct nvkm_instmem *imem;
+	u32 *data;
+	u32 size;
+	u64 addr;
+};
+#define bench_instobj(p) container_of((p), struct bench_instobj, base.memory)
+
+static enum nvkm_memory_target
+bench_instobj_target(struct nvkm_memory *memory)
+{
+	return NVKM_MEM_TARGET_INST;
+}
+
+static u64
+bench_instobj_addr(struct nvkm_memory *memory)
+{
+	return bench_instobj(memory)->addr;
+}
+
+static u64
+bench_instobj_size(struct nvkm_memory *memory)
+{
+	return bench_instobj(memory)->size;
+}
+
+static u32
+bench_instobj_rd32(struct nvkm_memory *memory, u64 offset)
+{
+	return bench_instobj(memory)->data[offset / 4];
+}
+
+static void
+bench_instobj_wr32(struct nvkm_memory *memory, u64 offset, u32 data)
+{
+	bench_words++;
+	bench_instobj(memory)->data[offset / 4] = data;
+}
+
+static const struct nvkm_memory_ptrs
+bench_instobj_ptrs = {
+	.rd32 = bench_instobj_rd32,
+	.wr32 = bench_instobj_wr32,
+};
+
+static void __iomem *
+bench_instobj_acquire(struct nvkm_memory *memory)
+{
+	return NULL;
+}
+
+static void
+bench_instobj_release(struct nvkm_memory *memory)
+{
+}
+
+static void *
+bench_instobj_dtor(struct nvkm_memory *memory)
+{
+	struct bench_instobj *iobj = bench_instobj(memory);
+	nvkm_instobj_dtor(iobj->imem, &iobj->base);
+	bench_objs--;
+	bench_bytes -= iobj->size;
+	free(iobj->data);
+	return iobj;
+}
+
+static const struct nvkm_memory_func
+bench_instobj_func = {
+	.dtor = bench_instobj_dtor,
+	.target = bench_instobj_target,
+	.addr = bench_instobj_addr,
+	.size = bench_instobj_size,
+	.acquire = bench_instobj_acquire,
+	.release = bench_instobj_release,
+};
+
+static int
+bench_instobj_new(struct nvkm_instmem *imem, u32 size, u32 align, bool zero,
+		  struct nvkm_memory **pmemory)
+{
+	struct bench_instobj *iobj;
+
+	if (!(iobj = kzalloc(sizeof(*iobj), GFP_KERNEL)))
+		return -ENOMEM;
+	*pmemory = &iobj->base.memory;
+
+	nvkm_instobj_ctor(&bench_instobj_func, imem, &iobj->base);
+	iobj->base.memory.ptrs = &bench_instobj_ptrs;
+	iobj->imem = imem;
+	iobj->size = size;
+	iobj->addr = bench_addr;
+	bench_addr += ALIGN(size, 0x10);
+	if (!(iobj->data = calloc(1, size)))
+		return -ENOMEM;
+
+	bench_objs++;
+	bench_bytes += size;
+	bench_peak = max(bench_peak, bench_bytes);
+	return 0;
+}
+
+static const struct nvkm_instmem_func
+bench_instmem = {
+	.memory_new = bench_instobj_new,
+	.zero = true,
+};
+
+struct bench_client {
+	struct nvkm_client client;
+	struct nvkm_dmaobj *dmaobj[2];
+	int cookie[2];
+};
+
+static void
+bench_dmaobj_new(struct nvkm_dma *dma, struct bench_client *bench, int i,
+		 u8 target, u64 limit)
+{
+	struct nv_dma_v0 args = {
+		.target = target,
+		.access = NV_DMA_V0_ACCESS_RDWR,
+		.limit = limit,
+	};
+	struct nvkm_oclass oclass = {
+		.base.oclass = NV_DMA_IN_MEMORY,
+		.client = &bench->client,
+		.parent = &bench->client.object,
+		.handle = 0xbeef0201 + i,
+	};
+	int ret;
+
+	ret = dma->func->class_new(dma, &oclass, &args, sizeof(args),
+				   &bench->dmaobj[i]);
+	assert(ret == 0);
+}
+
+static void
+bench_chan_new(struct nvkm_ramht *ramht, struct bench_client *bench, int chid)
+{
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		bench->cookie[i] = nvkm_ramht_insert(ramht,
+						     &bench->dmaobj[i]->object,
+						     chid, 4, 0xbeef0201 + i,
+						     0x80000000 | chid << 24);
+		assert(bench->cookie[i] > 0);
+	}
+}
+
+static void
+bench_chan_del(struct nvkm_ramht *ramht, struct bench_client *bench)
+{
+	nvkm_ramht_remove(ramht, bench->cookie[0]);
+	nvkm_ramht_remove(ramht, bench->cookie[1]);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct device dev = { .name = "bench" };
+	struct nvkm_device device = {
+		.dev = &dev,
+		.dbgopt = "fatal",
+	};
+	struct bench_client *bench;
+	struct nvkm_instmem *imem;
+	struct nvkm_subdev *subdev;
+	struct nvkm_ramht *ramht;
+	struct nvkm_dma *dma;
+	int chans = 16, loops = 100000;
+	u64 objs, bytes;
+	int ret, c, i;
+	s64 time;
+
+	while ((c = getopt(argc, argv, "c:l:")) != -1) {
+		switch (c) {
+		case 'c': chans = strtol(optarg, NULL, 0); break;
+		case 'l': loops = strtol(optarg, NULL, 0); break;
+		default:
+			return 1;
+		}
+	}
+
+	if (chans < 1 || chans > 16 || loops < 1)
+		return 1;
+
+	if (!(imem = kzalloc(sizeof(*imem), GFP_KERNEL)))
+		return -ENOMEM;
+	nvkm_instmem_ctor(&bench_instmem, &device, NVKM_SUBDEV_INSTMEM, imem);
+	device.imem = imem;
+	subdev = &imem->subdev;
+
+	ret = nv04_dma_new(&device, NVKM_ENGINE_DMAOBJ, &dma);
+	if (ret)
+		return ret;
+
+	ret = nvkm_ramht_new(&device, 0x8000, 0, NULL, &ramht);
+	if (ret)
+		return ret;
+
+	if (!(bench = calloc(chans, sizeof(*bench))))
+		return -ENOMEM;
+
+	objs = bench_objs;
+	bytes = bench_bytes;
+	bench_peak = 0;
+
+	for (i = 0; i < chans; i++) {
+		struct nvkm_client *client = &bench[i].client;
+		snprintf(client->name, sizeof(client->name), "bench%d", i);
+		client->object.client = client;
+		client->super = true;
+		bench_dmaobj_new(dma, &bench[i], 0, NV_DMA_V0_TARGET_VRAM,
+				 (256 << 20) - 1);
+		bench_dmaobj_new(dma, &bench[i], 1, NV_DMA_V0_TARGET_PCI,
+				 (512 << 20) - 1);
+		bench_chan_new(ramht, &bench[i], i);
+	}
+
+	printf("%d channels: %lld ctxdma objects, %lld bytes of instmem\n",
+	       chans, bench_objs - objs, bench_bytes - bytes);
+
+	bench_words = 0;
+	time = ktime_to_ns(ktime_get());
+	for (i = 0; i < loops; i++) {
+		bench_chan_del(ramht, &bench[i % chans]);
+		bench_chan_new(ramht, &bench[i % chans], i % chans);
+	}
+	time = ktime_to_ns(ktime_get()) - time;
+
+	printf("%d channel cycles in %lldus, %lldns/cycle, %lld channels/s, "
+	       "%lld words written\n", loops, time / 1000, time / loops,
+	       time ? (s64)loops * 1000000000 / time : 0, bench_words);
+	printf("peak %lld bytes of instmem beyond the RAMHT\n",
+	       bench_peak - bytes);
+
+	/* every channel's entries must point at a valid VRAM/GART ctxdma */
+	for (i = 0; i < chans; i++) {
+		struct nvkm_gpuobj *vram = nvkm_ramht_search(ramht, i, 0xbeef0201);
+		struct nvkm_gpuobj *gart = nvkm_ramht_search(ramht, i, 0xbeef0202);
+		assert(vram && gart && vram->addr != gart->addr);
+		nvkm_kmap(vram);
+		assert((nvkm_ro32(vram, 0x00) & 0x00033000) == 0x00003000);
+		assert(nvkm_ro32(vram, 0x04) == (256 << 20) - 1);
+		nvkm_done(vram);
+		nvkm_kmap(gart);
+		assert((nvkm_ro32(gart, 0x00) & 0x00033000) == 0x00023000);
+		assert(nvkm_ro32(gart, 0x04) == (512 << 20) - 1);
+		nvkm_done(gart);
+	}
+
+	for (i = 0; i < chans; i++) {
+		struct nvkm_object *object;
+		bench_chan_del(ramht, &bench[i]);
+		object = &bench[i].dmaobj[0]->object;
+		nvkm_object_del(&object);
+		object = &bench[i].dmaobj[1]->object;
+		nvkm_object_del(&object);
+	}
+	nvkm_ramht_del(&ramht);
+	free(bench);
+
+	subdev = &dma->engine.subdev;
+	nvkm_subdev_del(&subdev);
+	assert(bench_objs == 0);
+	subdev = &imem->subdev;
+	nvkm_subdev_del(&subdev);
+	return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <core/event.h>
+#include <core/notify.h>
+
+#include <nvif/event.h>
+
+/* Models a FIFO-style uevent: one index per channel, with a number of
+ * subscribers per channel, and measures the cost of raising an event
+ * on a single channel.
+ */
+static unsigned long bench_recv;
+
+static int
+bench_ctor(struct nvkm_object *object, void *data, u32 size,
+	   struct nvkm_notify *notify)
+{
+	notify->size  = sizeof(struct nvif_notify_uevent_rep);
+	notify->types = 1;
+	notify->index = *(int *)data;
+	return 0;
+}
+
+static const struct nvkm_event_func
+bench_event = {
+	.ctor = bench_ctor,
+};
+
+static int
+bench_func(struct nvkm_notify *notify)
+{
+	bench_recv++;
+	return NVKM_NOTIFY_KEEP;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct nvif_notify_uevent_rep rep = {};
+	struct nvkm_event event;
+	struct nvkm_notify *notify;
+	int chans = 4096, subs = 1, loops = 1000000;
+	int ret, c, i;
+	s64 time;
+
+	while ((c = getopt(argc, argv, "c:l:s:")) != -1) {
+		switch (c) {
+		case 'c': chans = strtol(optarg, NULL, 0); break;
+		case 'l': loops = strtol(optarg, NULL, 0); break;
+		case 's': subs = strtol(optarg, NULL, 0); break;
+		default:
+			return 1;
+		}
+	}
+
+	if (chans < 1 || subs < 1 || loops < 1)
+		return 1;
+
+	ret = nvkm_event_init(&bench_event, 1, chans, &event);
+	if (ret)
+		return ret;
+
+	notify = calloc(chans * subs, sizeof(*notify));
+	if (!notify)
+		return -ENOMEM;
+
+	for (i = 0; i < chans * subs; i++) {
+		int index = i % chans;
+		ret = nvkm_notify_init(NULL, &event, bench_func, false,
+				       &index, sizeof(index), sizeof(rep),
+				       &notify[i]);
+		if (ret)
+			return ret;
+		nvkm_notify_get(&notify[i]);
+	}
+
+	time = ktime_to_ns(ktime_get());
+	for (i = 0; i < loops; i++)
+		nvkm_event_send(&event, 1, i % chans, &rep, sizeof(rep));
+	time = ktime_to_ns(ktime_get()) - time;
+
+	printf("%d channels, %d notifiers\n", chans, chans * subs);
+	printf("%d sends in %lldus, %lldns/send, %lu notifications\n",
+	       loops, time / 1000, time / loops, bench_recv);
+	assert(bench_recv == (unsigned long)loops * subs);
+
+	for (i = 0; i < chans * subs; i++)
+		nvkm_notify_fini(&notify[i]);
+	nvkm_event_fini(&event);
+	free(notify);
+	return 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <nvif/os.h>
+
+#include "../lib/priv.h"
+
+/* Requests each of the named firmware images a number of times, the way
+ * several devices and subdevs would at startup, and reports what the
+ * firmware cache had to do to satisfy them.
+ */
+int
+main(int argc, char **argv)
+{
+	struct os_firmware_stats stats;
+	const struct firmware *fw;
+	int loops = 8, ret, c, i, j;
+	s64 time;
+
+	while ((c = getopt(argc, argv, "l:")) != -1) {
+		switch (c) {
+		case 'l': loops = strtol(optarg, NULL, 0); break;
+		default:
+			return 1;
+		}
+	}
+
+	if (loops < 1 || optind >= argc) {
+		fprintf(stderr, "usage: %s [-l loops] firmware...\n", argv[0]);
+		return 1;
+	}
+
+	time = ktime_to_ns(ktime_get());
+	for (i = 0; i < loops; i++) {
+		for (j = optind; j < argc; j++) {
+			ret = request_firmware(&fw, argv[j], NULL);
+			if (ret) {
+				fprintf(stderr, "%s: %d\n", argv[j], ret);
+				return 1;
+			}
+			release_firmware(fw);
+		}
+	}
+	time = ktime_to_ns(ktime_get()) - time;
+
+	os_firmware_stats(&stats);
+	printf("%d requests in %lldus, %lldns/request\n", loops * (argc - optind),
+	       time / 1000, time / (loops * (argc - optind)));
+	printf("%llu hits, %llu misses, %llu bytes mapped\n",
+	       stats.hits, stats.misses, stats.mapped);
+	os_firmware_fini();
+	return 0;
+}
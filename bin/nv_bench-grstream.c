@@ -0,0 +1,362 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <engine/gr.h>
+
+#include "../drm/nouveau/nvkm/engine/gr/ctxgf100.h"
+
+/* Compiles the register packs of each Fermi/Kepler/Maxwell GR into write
+ * streams, reports how much smaller they are than the packs, and times
+ * replaying them against walking the packs, into a plain memory BAR0.
+ * Both must leave the same register contents behind.
+ *
+ * The compiler lives here rather than in nvkm, as a CPU replay of the
+ * stream is no faster than the pack walk init already does.
+ */
+#define BENCH_BAR0 0x1000000
+
+/* A pack flattened into the register writes it makes, with runs of
+ * consecutive registers and repeated values merged.  Each op starts with
+ * the register address, with the op type in its low bits:
+ *
+ *   SINGLE: addr|0, data
+ *   FILL  : addr|1, count, pitch, data
+ *   LIST  : addr|2, count, data[count] (consecutive registers)
+ */
+#define BENCH_STREAM_SINGLE 0
+#define BENCH_STREAM_FILL   1
+#define BENCH_STREAM_LIST   2
+
+struct bench_stream {
+	u32 *data;
+	u32 size; /* in words */
+	u32 writes;
+};
+
+struct bench_stream_op {
+	u32 type;
+	u32 addr;
+	u32 count;
+	u32 pitch;
+	u32 data;
+};
+
+static void
+bench_stream_put(struct bench_stream *stream, u32 data)
+{
+	if (stream->data)
+		stream->data[stream->size] = data;
+	stream->size++;
+}
+
+/* Writes out the op being built.  LIST data has been written as it was
+ * added, so only its count needs filling in.
+ */
+static void
+bench_stream_end(struct bench_stream *stream,
+		    struct bench_stream_op *op, u32 list)
+{
+	switch (op->type) {
+	case BENCH_STREAM_SINGLE:
+		bench_stream_put(stream, op->addr | op->type);
+		bench_stream_put(stream, op->data);
+		break;
+	case BENCH_STREAM_FILL:
+		bench_stream_put(stream, op->addr | op->type);
+		bench_stream_put(stream, op->count);
+		bench_stream_put(stream, op->pitch);
+		bench_stream_put(stream, op->data);
+		break;
+	case BENCH_STREAM_LIST:
+		if (stream->data)
+			stream->data[list + 1] = op->count;
+		break;
+	default:
+		break;
+	}
+
+	op->type = ~0;
+}
+
+static u32
+bench_stream_add(struct bench_stream *stream,
+		    struct bench_stream_op *op, u32 list, u32 addr, u32 data)
+{
+	stream->writes++;
+
+	switch (op->type) {
+	case BENCH_STREAM_LIST:
+		if (addr == op->addr + op->count * 4) {
+			bench_stream_put(stream, data);
+			op->count++;
+			return list;
+		}
+		break;
+	case BENCH_STREAM_SINGLE:
+		if (addr == op->addr + 4 && data != op->data) {
+			list = stream->size;
+			bench_stream_put(stream, op->addr |
+					    BENCH_STREAM_LIST);
+			bench_stream_put(stream, 0);
+			bench_stream_put(stream, op->data);
+			bench_stream_put(stream, data);
+			op->type = BENCH_STREAM_LIST;
+			op->count = 2;
+			return list;
+		}
+		if (addr != op->addr && data == op->data) {
+			op->type = BENCH_STREAM_FILL;
+			op->pitch = addr - op->addr;
+			op->count = 2;
+			return list;
+		}
+		break;
+	case BENCH_STREAM_FILL:
+		if (addr == op->addr + op->count * op->pitch &&
+		    data == op->data) {
+			op->count++;
+			return list;
+		}
+		break;
+	default:
+		break;
+	}
+
+	bench_stream_end(stream, op, list);
+	op->type = BENCH_STREAM_SINGLE;
+	op->addr = addr;
+	op->data = data;
+	return list;
+}
+
+static void
+bench_stream_build(const struct gf100_gr_pack *p,
+		      struct bench_stream *stream)
+{
+	struct bench_stream_op op = { .type = ~0 };
+	const struct gf100_gr_pack *pack;
+	const struct gf100_gr_init *init;
+	u32 list = 0;
+
+	stream->size = 0;
+	stream->writes = 0;
+
+	pack_for_each_init(init, pack, p) {
+		u32 next = init->addr + init->count * init->pitch;
+		u32 addr = init->addr;
+		while (addr < next) {
+			list = bench_stream_add(stream, &op, list,
+						   addr, init->data);
+			addr += init->pitch;
+		}
+	}
+
+	bench_stream_end(stream, &op, list);
+}
+
+static int
+bench_stream_new(const struct gf100_gr_pack *p,
+		    struct bench_stream *stream)
+{
+	stream->data = NULL;
+	bench_stream_build(p, stream);
+	if (!stream->size)
+		return 0;
+
+	stream->data = kvmalloc_array(stream->size, sizeof(*stream->data),
+				      GFP_KERNEL);
+	if (!stream->data)
+		return -ENOMEM;
+
+	bench_stream_build(p, stream);
+	return 0;
+}
+
+static void
+bench_stream_del(struct bench_stream *stream)
+{
+	kvfree(stream->data);
+	stream->data = NULL;
+	stream->size = 0;
+}
+
+static void
+bench_stream(struct gf100_gr *gr, const struct bench_stream *stream)
+{
+	struct nvkm_device *device = gr->base.engine.subdev.device;
+	const u32 *data = stream->data;
+	const u32 *end = data + stream->size;
+
+	while (data < end) {
+		u32 addr = data[0] & ~3;
+		u32 count, pitch;
+
+		switch (data[0] & 3) {
+		case BENCH_STREAM_SINGLE:
+			nvkm_wr32(device, addr, data[1]);
+			data += 2;
+			break;
+		case BENCH_STREAM_FILL:
+			for (count = data[1], pitch = data[2]; count--;
+			     addr += pitch)
+				nvkm_wr32(device, addr, data[3]);
+			data += 4;
+			break;
+		case BENCH_STREAM_LIST:
+			count = data[1];
+			data += 2;
+			while (count--) {
+				nvkm_wr32(device, addr, *data++);
+				addr += 4;
+			}
+			break;
+		default:
+			WARN_ON(1);
+			return;
+		}
+	}
+}
+
+static const struct {
+	const char *name;
+	int (*new)(struct nvkm_device *, int, struct nvkm_gr **);
+} bench_chips[] = {
+	{ "gf100", gf100_gr_new },
+	{ "gf104", gf104_gr_new },
+	{ "gf108", gf108_gr_new },
+	{ "gf110", gf110_gr_new },
+	{ "gf117", gf117_gr_new },
+	{ "gf119", gf119_gr_new },
+	{ "gk104", gk104_gr_new },
+	{ "gk110", gk110_gr_new },
+	{ "gk110b", gk110b_gr_new },
+	{ "gk208", gk208_gr_new },
+	{ "gm107", gm107_gr_new },
+};
+
+static u32
+bench_pack_size(const struct gf100_gr_pack *p)
+{
+	const struct gf100_gr_pack *pack;
+	const struct gf100_gr_init *init;
+	u32 size = 0;
+
+	pack_for_each_init(init, pack, p)
+		size += sizeof(*init);
+	return size;
+}
+
+static void
+bench(struct gf100_gr *gr, const char *name, const struct gf100_gr_pack *p,
+      int loops)
+{
+	struct nvkm_device *device = gr->base.engine.subdev.device;
+	struct bench_stream stream;
+	u8 *pack_bar0, *stream_bar0;
+	s64 pack_time, stream_time;
+	int ret, i;
+
+	if (!p)
+		return;
+
+	ret = bench_stream_new(p, &stream);
+	assert(ret == 0);
+
+	pack_bar0 = calloc(1, BENCH_BAR0);
+	stream_bar0 = calloc(1, BENCH_BAR0);
+	assert(pack_bar0 && stream_bar0);
+
+	device->pri = (void __iomem *)pack_bar0;
+	pack_time = ktime_to_ns(ktime_get());
+	for (i = 0; i < loops; i++)
+		gf100_gr_mmio(gr, p);
+	pack_time = ktime_to_ns(ktime_get()) - pack_time;
+
+	device->pri = (void __iomem *)stream_bar0;
+	stream_time = ktime_to_ns(ktime_get());
+	for (i = 0; i < loops; i++)
+		bench_stream(gr, &stream);
+	stream_time = ktime_to_ns(ktime_get()) - stream_time;
+
+	printf("  %-6s: %5d writes, pack %6d bytes %7lldns, "
+	       "stream %6d bytes %7lldns\n", name, stream.writes,
+	       bench_pack_size(p), pack_time / loops,
+	       (int)(stream.size * sizeof(u32)), stream_time / loops);
+	assert(!memcmp(pack_bar0, stream_bar0, BENCH_BAR0));
+
+	device->pri = NULL;
+	free(stream_bar0);
+	free(pack_bar0);
+	bench_stream_del(&stream);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct device dev = { .name = "bench" };
+	struct nvkm_device device = {
+		.dev = &dev,
+		.dbgopt = "fatal",
+	};
+	int loops = 1000;
+	int ret, c, i;
+
+	while ((c = getopt(argc, argv, "l:")) != -1) {
+		switch (c) {
+		case 'l': loops = strtol(optarg, NULL, 0); break;
+		default:
+			return 1;
+		}
+	}
+
+	if (loops < 1)
+		return 1;
+
+	for (i = 0; i < ARRAY_SIZE(bench_chips); i++) {
+		const struct gf100_grctx_func *grctx;
+		struct nvkm_gr *base = NULL;
+		struct nvkm_subdev *subdev;
+		struct gf100_gr *gr;
+
+		ret = bench_chips[i].new(&device, NVKM_ENGINE_GR, &base);
+		if (ret == 0) {
+			gr = gf100_gr(base);
+			grctx = gr->func->grctx;
+			printf("%s:\n", bench_chips[i].name);
+			bench(gr, "mmio", gr->func->mmio, loops);
+			bench(gr, "hub", grctx->hub, loops);
+			bench(gr, "gpc_0", grctx->gpc_0, loops);
+			bench(gr, "gpc_1", grctx->gpc_1, loops);
+			bench(gr, "zcull", grctx->zcull, loops);
+			bench(gr, "tpc", grctx->tpc, loops);
+			bench(gr, "ppc", grctx->ppc, loops);
+		} else {
+			printf("%s: %d\n", bench_chips[i].name, ret);
+		}
+
+		if (base) {
+			subdev = &base->engine.subdev;
+			nvkm_subdev_del(&subdev);
+		}
+	}
+
+	return 0;
+}
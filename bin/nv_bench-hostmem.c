@@ -0,0 +1,217 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <core/memory.h>
+#include <subdev/mmu.h>
+
+#include "../drm/nouveau/nvkm/subdev/mmu/mem.h"
+#include "../drm/nouveau/nvkm/subdev/mmu/vmm.h"
+
+/* Allocates host memory objects of 1MiB-1GiB with nvkm_mem_new_type(),
+ * against allocating and mapping them a page at a time, and reports the
+ * page size each object can be mapped at, and the PTEs it then takes on
+ * a VMM with large host pages (GK20A-style 128KiB) against 4KiB ones.
+ *
+ * There's no bus in userspace, so the device is marked 'dma_virt' and
+ * CPU addresses stand in for DMA addresses.
+ */
+static const struct nvkm_vmm_page
+bench_page[] = {
+	{ 17, NULL, NVKM_VMM_PAGE_xxHC },
+	{ 12, NULL, NVKM_VMM_PAGE_xxHx },
+	{}
+};
+
+static u32 *bench_pt;
+
+static void __iomem *
+bench_pt_acquire(struct nvkm_memory *memory)
+{
+	return bench_pt;
+}
+
+static void
+bench_pt_release(struct nvkm_memory *memory)
+{
+}
+
+static const struct nvkm_memory_func
+bench_pt_func = {
+	.acquire = bench_pt_acquire,
+	.release = bench_pt_release,
+};
+
+static void
+bench_pt_wr32(struct nvkm_memory *memory, u64 offset, u32 data)
+{
+	bench_pt[offset / 4] = data;
+}
+
+static const struct nvkm_memory_ptrs
+bench_pt_ptrs = {
+	.wr32 = bench_pt_wr32,
+};
+
+/* Writes large-page PTEs for DMA addresses that come in 128KiB chunks,
+ * starting part-way into the array the way nvkm_vmm_map() does for a
+ * non-zero offset, and checks each PTE points at the start of its page.
+ */
+static void
+bench_pgt_dma(struct nvkm_mmu *mmu)
+{
+	const int chunks = 8, pages = 1 << (17 - PAGE_SHIFT);
+	struct nvkm_vmm vmm = { .mmu = mmu, .name = "bench" };
+	struct nvkm_memory memory = { .func = &bench_pt_func,
+				      .ptrs = &bench_pt_ptrs };
+	struct nvkm_mmu_pt pt = { .memory = &memory };
+	struct nvkm_vmm_map map = { .page = &bench_page[0] };
+	struct page *page[chunks];
+	dma_addr_t dma[chunks * pages];
+	int i, j;
+
+	for (i = 0; i < chunks; i++) {
+		page[i] = alloc_pages(GFP_KERNEL, 17 - PAGE_SHIFT);
+		assert(page[i]);
+		for (j = 0; j < pages; j++)
+			dma[i * pages + j] = (unsigned long)page[i]->addr +
+					     ((u64)j << PAGE_SHIFT);
+	}
+
+	bench_pt = calloc(chunks, 8);
+	assert(bench_pt);
+
+	map.dma = dma + pages;
+	map.off = 0;
+	map.next = 1ULL << (17 - 8);
+	gf100_vmm_pgt_dma(&vmm, &pt, 0, chunks - 1, &map);
+
+	for (i = 0; i < chunks - 1; i++) {
+		u64 data = bench_pt[i * 2] | (u64)bench_pt[i * 2 + 1] << 32;
+		assert(data == dma[(i + 1) * pages] >> 8);
+	}
+	assert(map.dma == dma + chunks * pages);
+
+	free(bench_pt);
+	for (i = 0; i < chunks; i++)
+		__free_pages(page[i], 17 - PAGE_SHIFT);
+}
+
+/* What nvkm_mem_new_host() used to do. */
+static int
+bench_pages(struct device *dev, u64 size)
+{
+	u64 pages = size >> PAGE_SHIFT, i;
+	struct page **page;
+	dma_addr_t *dma;
+	int ret = 0;
+
+	page = kvmalloc_array(pages, sizeof(*page), GFP_KERNEL);
+	dma = kvmalloc_array(pages, sizeof(*dma), GFP_KERNEL);
+	if (!page || !dma) {
+		ret = -ENOMEM;
+		goto done;
+	}
+
+	for (i = 0; i < pages; i++) {
+		if (!(page[i] = alloc_pages(GFP_USER | __GFP_ZERO, 0))) {
+			ret = -ENOMEM;
+			break;
+		}
+
+		dma[i] = dma_map_page(dev, page[i], 0, PAGE_SIZE,
+				      DMA_BIDIRECTIONAL);
+		if (dma_mapping_error(dev, dma[i])) {
+			__free_pages(page[i], 0);
+			ret = -ENOMEM;
+			break;
+		}
+	}
+
+	while (i--) {
+		dma_unmap_page(dev, dma[i], PAGE_SIZE, DMA_BIDIRECTIONAL);
+		__free_pages(page[i], 0);
+	}
+
+done:
+	kvfree(dma);
+	kvfree(page);
+	return ret;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct device dev = { .name = "bench", .dma_virt = true };
+	struct nvkm_device device = { .dev = &dev, .dbgopt = "fatal" };
+	struct nvkm_mmu mmu = {
+		.dma_bits = 40,
+		.heap_nr = 1,
+		.heap[0] = { NVKM_MEM_HOST, ~0ULL },
+		.type_nr = 1,
+		.type[0] = { NVKM_MEM_HOST | NVKM_MEM_MAPPABLE |
+			     NVKM_MEM_COHERENT, 0 },
+	};
+	u64 size, max = 1ULL << 30;
+	int ret, c;
+
+	while ((c = getopt(argc, argv, "m:")) != -1) {
+		switch (c) {
+		case 'm': max = strtoull(optarg, NULL, 0); break;
+		default:
+			return 1;
+		}
+	}
+
+	mmu.subdev.device = &device;
+	bench_pgt_dma(&mmu);
+
+	printf("%10s %12s %12s %5s %10s %10s\n", "size", "pages(us)",
+	       "chunks(us)", "page", "ptes(4K)", "ptes(lg)");
+	for (size = 1 << 20; size <= max; size <<= 2) {
+		const struct nvkm_vmm_page *page = bench_page;
+		struct nvkm_memory *memory = NULL;
+		s64 t0, t1;
+
+		t0 = ktime_to_ns(ktime_get());
+		ret = bench_pages(&dev, size);
+		t0 = ktime_to_ns(ktime_get()) - t0;
+		if (ret)
+			return ret;
+
+		t1 = ktime_to_ns(ktime_get());
+		ret = nvkm_mem_new_type(&mmu, 0, PAGE_SHIFT, size, NULL, 0,
+					&memory);
+		t1 = ktime_to_ns(ktime_get()) - t1;
+		if (ret)
+			return ret;
+
+		assert(nvkm_memory_size(memory) == size);
+		while (page->shift > nvkm_memory_page(memory))
+			page++;
+
+		printf("%10llu %12lld %12lld %5d %10llu %10llu\n", size,
+		       t0 / 1000, t1 / 1000, nvkm_memory_page(memory),
+		       size >> PAGE_SHIFT, size >> page->shift);
+		nvkm_memory_unref(&memory);
+	}
+
+	return 0;
+}
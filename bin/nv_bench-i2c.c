@@ -0,0 +1,144 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "../drm/nouveau/nvkm/subdev/i2c/bus.h"
+
+#include "../lib/priv.h"
+
+/* Measures the bit rate achieved by the software I2C implementation, and
+ * the accuracy of the delays it requests, against a simulated bus with a
+ * single slave that acknowledges every byte written to it.
+ */
+struct bench_wire {
+	int scl;
+	int sda;
+	int ack;
+	int bits;
+};
+
+static struct bench_wire wire = { 1, 1, 1 };
+
+static void
+bench_drive_scl(struct nvkm_i2c_bus *bus, int state)
+{
+	if (wire.scl && !state) {
+		/* Slave drives ACK during the ninth clock of each byte. */
+		if (++wire.bits == 8)
+			wire.ack = 0;
+		else
+		if (wire.bits == 9) {
+			wire.ack = 1;
+			wire.bits = 0;
+		}
+	}
+	wire.scl = state;
+}
+
+static void
+bench_drive_sda(struct nvkm_i2c_bus *bus, int state)
+{
+	if (wire.scl && wire.sda && !state) {
+		/* START condition, the falling edge of SCL that follows
+		 * isn't the end of a bit.
+		 */
+		wire.bits = -1;
+		wire.ack = 1;
+	}
+	wire.sda = state;
+}
+
+static int
+bench_sense_scl(struct nvkm_i2c_bus *bus)
+{
+	return wire.scl;
+}
+
+static int
+bench_sense_sda(struct nvkm_i2c_bus *bus)
+{
+	return wire.sda && wire.ack;
+}
+
+static const struct nvkm_i2c_bus_func
+bench_bus = {
+	.drive_scl = bench_drive_scl,
+	.drive_sda = bench_drive_sda,
+	.sense_scl = bench_sense_scl,
+	.sense_sda = bench_sense_sda,
+};
+
+static void
+bench_site(const struct nvos_delay_site *site, void *priv)
+{
+	if (!site->calls)
+		return;
+
+	printf("  %s:%d: %lld calls, req %lldns, act %lldns, max late %lldns\n",
+	       site->file, site->line, site->calls, site->nsec_req / site->calls,
+	       site->nsec_act / site->calls, site->nsec_max);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct nvkm_i2c_bus bus = { .func = &bench_bus };
+	u8 data[16] = {};
+	struct i2c_msg msg = {
+		.addr = 0x50,
+		.buf = data,
+		.len = sizeof(data),
+	};
+	int loops = 100, ret, c, i;
+	s64 time, bits;
+
+	while ((c = getopt(argc, argv, "l:")) != -1) {
+		switch (c) {
+		case 'l': loops = strtol(optarg, NULL, 0); break;
+		default:
+			return 1;
+		}
+	}
+
+	if (loops < 1)
+		return 1;
+
+	/* Warm up, so the delay calibration isn't part of the measurement. */
+	nvkm_i2c_bit_xfer(&bus, &msg, 1);
+	os_delay_reset();
+
+	time = ktime_to_ns(ktime_get());
+	for (i = 0; i < loops; i++) {
+		ret = nvkm_i2c_bit_xfer(&bus, &msg, 1);
+		if (ret != 1) {
+			fprintf(stderr, "xfer %d: %d\n", i, ret);
+			return 1;
+		}
+	}
+	time = ktime_to_ns(ktime_get()) - time;
+
+	/* Address byte and data, plus ACKs. */
+	bits = (s64)loops * (1 + sizeof(data)) * 9;
+	printf("%d xfers of %zd bytes in %lldus, %lld bits/s\n",
+	       loops, sizeof(data), time / 1000,
+	       time ? bits * 1000000000 / time : 0);
+	os_delay_stats(bench_site, NULL);
+	return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <nvif/client.h>
+#include <nvif/class.h>
+#include <nvif/if0000.h>
+
+#include "util.h"
+
+/* Measures the raw ioctl rate against the null driver.  A number of child
+ * client objects are created to populate the object lookup, and each
+ * iteration then targets a different one of them.  With more than one
+ * thread, all threads share the one client.
+ */
+struct bench {
+	struct nvif_object *object;
+	int objects;
+	int loops;
+	int start;
+	void (*func)(struct nvif_object *);
+	pthread_t thread;
+};
+
+static void *
+bench_thread(void *priv)
+{
+	struct bench *bench = priv;
+	int i;
+
+	for (i = 0; i < bench->loops; i++)
+		bench->func(&bench->object[(bench->start + i) % bench->objects]);
+
+	return NULL;
+}
+
+static void
+bench(const char *name, struct nvif_object *object, int objects, int loops,
+      int threads, void (*func)(struct nvif_object *))
+{
+	struct bench bench[threads];
+	s64 time, total = (s64)loops * threads;
+	int i;
+
+	time = ktime_to_ns(ktime_get());
+	for (i = 0; i < threads; i++) {
+		bench[i].object = object;
+		bench[i].objects = objects;
+		bench[i].loops = loops;
+		bench[i].start = i * objects / threads;
+		bench[i].func = func;
+		if (threads > 1) {
+			pthread_create(&bench[i].thread, NULL,
+				       bench_thread, &bench[i]);
+		} else
+			bench_thread(&bench[i]);
+	}
+
+	for (i = 0; threads > 1 && i < threads; i++)
+		pthread_join(bench[i].thread, NULL);
+	time = ktime_to_ns(ktime_get()) - time;
+
+	printf("%-6s: %lld ioctls in %lldus, %lldns/ioctl, %lld ioctls/s\n",
+	       name, total, time / 1000, time / total,
+	       time ? total * 1000000000 / time : 0);
+}
+
+static void
+bench_rd(struct nvif_object *object)
+{
+	nvif_rd32(object, 0x000000);
+}
+
+static void
+bench_wr(struct nvif_object *object)
+{
+	nvif_wr32(object, 0x000000, 0x00000000);
+}
+
+static void
+bench_mthd(struct nvif_object *object)
+{
+	struct nvif_client_devlist_v0 args = {};
+	nvif_mthd(object, NVIF_CLIENT_V0_DEVLIST, &args, sizeof(args));
+}
+
+int
+main(int argc, char **argv)
+{
+	struct nvif_client client;
+	struct nvif_object *object;
+	int objects = 256, loops = 1000000, threads = 1;
+	int ret, c, i;
+
+	while ((c = getopt(argc, argv, "l:n:t:"U_GETOPT)) != -1) {
+		switch (c) {
+		case 'l':
+			loops = strtol(optarg, NULL, 0);
+			break;
+		case 'n':
+			objects = strtol(optarg, NULL, 0);
+			break;
+		case 't':
+			threads = strtol(optarg, NULL, 0);
+			break;
+		default:
+			if (!u_option(c))
+				return 1;
+			break;
+		}
+	}
+
+	if (objects < 1 || loops < 1 || threads < 1)
+		return 1;
+
+	ret = u_client("null", argv[0], "fatal", false, false, 0, &client);
+	if (ret)
+		return ret;
+
+	object = calloc(objects, sizeof(*object));
+	if (!object)
+		return -ENOMEM;
+
+	for (i = 0; i < objects; i++) {
+		struct nvif_client_v0 args = { .device = ~0ULL };
+		snprintf(args.name, sizeof(args.name), "bench%d", i);
+		ret = nvif_object_ctor(&client.object, "benchObject", i,
+				       NVIF_CLASS_CLIENT, &args, sizeof(args),
+				       &object[i]);
+		if (ret) {
+			fprintf(stderr, "object %d: %d\n", i, ret);
+			goto done;
+		}
+	}
+
+	printf("%d objects, %d thread(s)\n", objects, threads);
+	bench("rd32", object, objects, loops, threads, bench_rd);
+	bench("wr32", object, objects, loops, threads, bench_wr);
+	bench("mthd", object, objects, loops, threads, bench_mthd);
+
+done:
+	while (i--)
+		nvif_object_dtor(&object[i]);
+	free(object);
+	nvif_client_dtor(&client);
+	return ret;
+}
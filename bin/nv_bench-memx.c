@@ -0,0 +1,261 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "../drm/nouveau/nvkm/subdev/fb/ramfuc.h"
+#include "../drm/nouveau/nvkm/subdev/pmu/priv.h"
+
+/* Alternates memory reclocks between two frequencies against a stand-in
+ * for the PMU's MEMX process, which executes the uploaded scripts against
+ * a memory-backed BAR0.  Run with and without the script cache, the two
+ * must leave the same register contents behind.
+ *
+ * The reclock script is modelled on gt215's: read-modify-writes of the
+ * memory controller and PLL registers, with timings and PLL coefficients
+ * derived from the target frequency and the current register values.
+ */
+#define BENCH_BAR0 0x1000000
+#define BENCH_REGS 48
+
+static struct {
+	u32 dmem[0x1000];
+	u32 base;
+	u32 size;
+	int builds;
+	int uploads;
+	int words;
+	int execs;
+} pmu;
+
+struct bench_ramfuc {
+	struct ramfuc base;
+	struct ramfuc_reg r_0x004000;
+	struct ramfuc_reg r_0x004004;
+	struct ramfuc_reg r_0x100220[9];
+	struct ramfuc_reg r_0x1002c0;
+	struct ramfuc_reg r_0x100760;
+	struct ramfuc_reg r_reg[BENCH_REGS];
+};
+
+static void
+bench_load_dmem(struct nvkm_falcon *falcon, void *data, u32 start, u32 size,
+		u8 port)
+{
+	assert(start >= pmu.base && start + size <= pmu.base + pmu.size);
+	memcpy(&pmu.dmem[start / 4], data, size);
+	pmu.uploads++;
+	pmu.words += size / 4;
+}
+
+static const struct nvkm_falcon_func
+bench_flcn = {
+	.load_dmem = bench_load_dmem,
+};
+
+static int
+bench_send(struct nvkm_pmu *base, u32 reply[2], u32 process, u32 message,
+	   u32 data0, u32 data1)
+{
+	struct nvkm_device *device = base->subdev.device;
+	u32 addr, mthd, size, i;
+
+	assert(process == PROC_MEMX);
+	switch (message) {
+	case MEMX_MSG_INFO:
+		assert(data0 == MEMX_INFO_DATA);
+		reply[0] = pmu.base;
+		reply[1] = pmu.size;
+		return 0;
+	case MEMX_MSG_EXEC:
+		for (addr = data0 / 4; addr < data1 / 4; addr += size) {
+			mthd = pmu.dmem[addr] & 0xffff;
+			size = pmu.dmem[addr++] >> 16;
+			switch (mthd) {
+			case MEMX_WR32:
+				for (i = 0; i < size; i += 2) {
+					nvkm_wr32(device, pmu.dmem[addr + i],
+						  pmu.dmem[addr + i + 1]);
+				}
+				break;
+			case MEMX_WAIT:
+			case MEMX_DELAY:
+			case MEMX_ENTER:
+			case MEMX_LEAVE:
+				break;
+			default:
+				assert(0);
+				break;
+			}
+		}
+		reply[0] = 0;
+		reply[1] = 0;
+		pmu.execs++;
+		return 0;
+	default:
+		assert(0);
+		return -EINVAL;
+	}
+}
+
+static const struct nvkm_pmu_func
+bench_pmu = {
+	.send = bench_send,
+};
+
+static void
+bench_calc(struct bench_ramfuc *fuc, struct nvkm_fb *fb, u32 from, u32 freq,
+	   bool cache)
+{
+	u32 data, timing[9];
+	int i;
+
+	if (cache && ram_cached(fuc, fb, from, freq, 0) == 0)
+		return;
+
+	assert(ram_init(fuc, fb) == 0);
+	if (cache)
+		ram_key(fuc, from, freq, 0);
+	pmu.builds++;
+
+	for (i = 0; i < 9; i++) {
+		data = ram_rd32(fuc, 0x100220[i]);
+		timing[i] = (data & 0xffff0000) | ((freq / 1000 * (i + 3)) &
+						   0x0000ffff);
+	}
+
+	ram_mask(fuc, 0x004000, 0x00000008, 0x00000008);
+	ram_nsec(fuc, 2000);
+	ram_block(fuc);
+	ram_wait(fuc, 0x100300, 0x00000001, 0x00000000, 10000);
+	ram_mask(fuc, 0x004004, 0x00ffffff, (freq / 27000) << 8 | 1);
+	ram_mask(fuc, 0x004000, 0x00000001, 0x00000001);
+	ram_wait(fuc, 0x004000, 0x00020000, 0x00020000, 64000);
+	ram_mask(fuc, 0x004000, 0x00000008, 0x00000000);
+	ram_nsec(fuc, 20000);
+
+	for (i = 0; i < 9; i++)
+		ram_mask(fuc, 0x100220[i], 0xffffffff, timing[i]);
+
+	for (i = 0; i < BENCH_REGS; i++) {
+		data = ram_rd32(fuc, reg[i]);
+		ram_mask(fuc, reg[i], 0x0000ffff, (data >> 16) ^ freq ^ i);
+		if ((i % 8) == 7)
+			ram_nsec(fuc, 1000);
+	}
+
+	ram_mask(fuc, 0x100760, 0x22222222, freq <= 750000 ? 0x22222222 : 0);
+	ram_mask(fuc, 0x1002c0, 0x00000ff0, (freq / 100000) << 4);
+	ram_nsec(fuc, 1000);
+	ram_unblock(fuc);
+}
+
+static s64
+bench(struct nvkm_fb *fb, int loops, bool cache, u8 *bar0)
+{
+	struct nvkm_device *device = fb->subdev.device;
+	static const u32 freq[] = { 405000, 800000 };
+	struct bench_ramfuc fuc = {};
+	u32 from = 0;
+	s64 time;
+	int i;
+
+	memset(bar0, 0x00, BENCH_BAR0);
+	memset(&pmu, 0x00, sizeof(pmu));
+	pmu.base = 0x400;
+	pmu.size = 0x800;
+	device->pri = (void __iomem *)bar0;
+
+	fuc.r_0x004000 = ramfuc_reg(0x004000);
+	fuc.r_0x004004 = ramfuc_reg(0x004004);
+	for (i = 0; i < 9; i++)
+		fuc.r_0x100220[i] = ramfuc_reg(0x100220 + (i * 4));
+	fuc.r_0x1002c0 = ramfuc_reg2(0x1002c0, 0x1002c8);
+	fuc.r_0x100760 = ramfuc_stride(0x100760, 4, 0x3);
+	for (i = 0; i < BENCH_REGS; i++)
+		fuc.r_reg[i] = ramfuc_reg(0x100800 + (i * 4));
+
+	time = ktime_to_ns(ktime_get());
+	for (i = 0; i < loops; i++) {
+		const u32 to = freq[i & 1];
+		bench_calc(&fuc, fb, from, to, cache);
+		assert(ramfuc_exec(&fuc.base, true) == 0);
+		from = to;
+	}
+	time = ktime_to_ns(ktime_get()) - time;
+
+	assert(pmu.execs == loops);
+	printf("%-8s: %d reclocks, %d scripts built, %d uploads of %d words, "
+	       "%lldns/reclock\n", cache ? "cached" : "uncached", loops,
+	       pmu.builds, pmu.uploads, pmu.words / pmu.uploads,
+	       time / loops);
+	return time;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct device dev = { .name = "bench" };
+	struct nvkm_device device = {
+		.dev = &dev,
+		.dbgopt = "fatal",
+	};
+	static const struct nvkm_subdev_func func = {};
+	struct nvkm_pmu *base;
+	struct nvkm_fb fb = {};
+	u8 *bar0[2];
+	int loops = 100000;
+	int c;
+
+	while ((c = getopt(argc, argv, "l:")) != -1) {
+		switch (c) {
+		case 'l': loops = strtol(optarg, NULL, 0); break;
+		default:
+			return 1;
+		}
+	}
+
+	if (loops < 1)
+		return 1;
+
+	if (!(base = kzalloc(sizeof(*base), GFP_KERNEL)))
+		return -ENOMEM;
+	nvkm_subdev_ctor(&func, &device, NVKM_SUBDEV_PMU, &base->subdev);
+	nvkm_falcon_ctor(&bench_flcn, &base->subdev, "pmu", 0x10a000,
+			 &base->falcon);
+	base->func = &bench_pmu;
+	mutex_init(&base->memx.mutex);
+	INIT_LIST_HEAD(&base->memx.cache);
+	device.pmu = base;
+	fb.subdev.device = &device;
+
+	bar0[0] = malloc(BENCH_BAR0);
+	bar0[1] = malloc(BENCH_BAR0);
+	assert(bar0[0] && bar0[1]);
+
+	bench(&fb, loops, false, bar0[0]);
+	bench(&fb, loops, true, bar0[1]);
+	assert(!memcmp(bar0[0], bar0[1], BENCH_BAR0));
+
+	nvkm_memx_cache_fini(base);
+	free(bar0[1]);
+	free(bar0[0]);
+	kfree(base);
+	return 0;
+}
@@ -0,0 +1,244 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <core/client.h>
+#include <nvif/class.h>
+#include <nvif/client.h>
+#include <nvif/driver.h>
+#include <nvif/if0008.h>
+#include <nvif/ioctl.h>
+#include <nvif/mmu.h>
+
+#include "../drm/nouveau/nvkm/subdev/mmu/ummu.h"
+
+/* Counts the ioctls it takes nvif_mmu_ctor() to get from nothing to a
+ * usable set of heap/type/kind tables, against a GF100-shaped MMU, with
+ * and without the server understanding NVIF_MMU_V0_INFO.  The transport
+ * is a minimal nvif driver that hands each ioctl straight to nvkm_ummu.
+ */
+static struct {
+	struct nvkm_device *device;
+	struct nvkm_object *ummu[2];
+	struct nvkm_client client;
+	bool old;
+	int ioctls;
+} bench;
+
+/* Finds the nvkm_ummu behind an nvif handle, or a free slot for 0. */
+static struct nvkm_object **
+bench_ummu(u64 handle)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bench.ummu); i++) {
+		if (handle ? bench.ummu[i] && bench.ummu[i]->object == handle :
+			     !bench.ummu[i])
+			return &bench.ummu[i];
+	}
+
+	return NULL;
+}
+
+static int
+bench_ioctl(void *priv, bool super, void *data, u32 size, void **hack)
+{
+	struct nvif_ioctl_v0 *args = data;
+	void *argv = args->data;
+	u32 argc = size - sizeof(*args);
+	struct nvkm_oclass oclass = { .client = &bench.client };
+	struct nvkm_object **pummu, *ummu;
+	int ret, i;
+
+	bench.ioctls++;
+
+	if (args->type == NVIF_IOCTL_V0_NEW) {
+		struct nvif_ioctl_new_v0 *new = argv;
+		if (!(pummu = bench_ummu(0)))
+			return -ENOSPC;
+		oclass.object = new->object;
+		return nvkm_ummu_new(bench.device, &oclass, new->data,
+				     argc - sizeof(*new), pummu);
+	}
+
+	if (!(pummu = bench_ummu(args->object)))
+		return -ENOENT;
+	ummu = *pummu;
+
+	switch (args->type) {
+	case NVIF_IOCTL_V0_SCLASS: {
+		struct nvif_ioctl_sclass_v0 *sclass = argv;
+		for (i = 0; ; i++) {
+			ret = ummu->func->sclass(ummu, i, &oclass);
+			if (ret)
+				break;
+			if (i < sclass->count) {
+				sclass->oclass[i].oclass = oclass.base.oclass;
+				sclass->oclass[i].minver = oclass.base.minver;
+				sclass->oclass[i].maxver = oclass.base.maxver;
+			}
+		}
+		sclass->count = i;
+		return 0;
+	}
+	case NVIF_IOCTL_V0_MTHD: {
+		struct nvif_ioctl_mthd_v0 *mthd = argv;
+		if (bench.old && mthd->method == NVIF_MMU_V0_INFO)
+			return -EINVAL;
+		return nvkm_object_mthd(ummu, mthd->method, mthd->data,
+					argc - sizeof(*mthd));
+	}
+	case NVIF_IOCTL_V0_DEL:
+		nvkm_object_del(pummu);
+		return 0;
+	default:
+		return -ENOSYS;
+	}
+}
+
+static const struct nvif_driver
+bench_driver = {
+	.name = "bench",
+	.ioctl = bench_ioctl,
+};
+
+static const struct nvkm_mmu_func
+bench_mmu = {
+	.dma_bits = 40,
+	.mmu = {{ -1, -1, NVIF_CLASS_MMU_GF100}},
+	.mem = {{ -1,  0, NVIF_CLASS_MEM_GF100}},
+	.vmm = {{ -1, -1, NVIF_CLASS_VMM_GF100}},
+	.kind = gf100_mmu_kind,
+};
+
+static void
+bench_mmu_init(struct nvkm_mmu *mmu)
+{
+	static const u8 types[] = {
+		0x00 | NVKM_MEM_KIND,
+		0x00 | NVKM_MEM_KIND | NVKM_MEM_MAPPABLE,
+		0x01 | NVKM_MEM_KIND | NVKM_MEM_MAPPABLE | NVKM_MEM_COHERENT,
+		0x01 | NVKM_MEM_KIND | NVKM_MEM_MAPPABLE | NVKM_MEM_UNCACHED,
+		0x02 | NVKM_MEM_KIND | NVKM_MEM_MAPPABLE | NVKM_MEM_COHERENT,
+		0x02 | NVKM_MEM_KIND | NVKM_MEM_MAPPABLE | NVKM_MEM_UNCACHED,
+		0x03 | NVKM_MEM_MAPPABLE | NVKM_MEM_COHERENT,
+	};
+	int i;
+
+	mmu->func = &bench_mmu;
+	mmu->dma_bits = bench_mmu.dma_bits;
+	mmu->heap[mmu->heap_nr].type = NVKM_MEM_VRAM | NVKM_MEM_COMP |
+				       NVKM_MEM_DISP;
+	mmu->heap[mmu->heap_nr++].size = 2ULL << 30;
+	mmu->heap[mmu->heap_nr].type = NVKM_MEM_HOST;
+	mmu->heap[mmu->heap_nr++].size = ~0ULL;
+	mmu->heap[mmu->heap_nr].type = NVKM_MEM_HOST;
+	mmu->heap[mmu->heap_nr++].size = ~0ULL;
+	mmu->heap[mmu->heap_nr].type = NVKM_MEM_VRAM | NVKM_MEM_DISP;
+	mmu->heap[mmu->heap_nr++].size = 256ULL << 20;
+
+	for (i = 0; i < ARRAY_SIZE(types); i++) {
+		mmu->type[i].heap = types[i] & 0x0f;
+		mmu->type[i].type = mmu->heap[mmu->type[i].heap].type |
+				    (types[i] & 0xf0);
+	}
+	mmu->type_nr = i;
+}
+
+static int
+bench_ctor(struct nvif_client *client, bool old, struct nvif_mmu *mmu,
+	   int *ioctls, s64 *time)
+{
+	int ret;
+
+	bench.old = old;
+	bench.ioctls = 0;
+	*time = ktime_to_ns(ktime_get());
+	ret = nvif_mmu_ctor(&client->object, "benchMmu", NVIF_CLASS_MMU_GF100,
+			    mmu);
+	*time = ktime_to_ns(ktime_get()) - *time;
+	*ioctls = bench.ioctls;
+	return ret;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct nvif_client client = {};
+	struct nvif_mmu new, old;
+	struct nvkm_mmu mmu = {};
+	struct device dev = { .name = "bench" };
+	struct nvkm_device device = { .dev = &dev, .mmu = &mmu };
+	int loops = 10000, kinds = 0, ret, c, i, n[2];
+	s64 t[2], total[2] = {};
+
+	while ((c = getopt(argc, argv, "l:")) != -1) {
+		switch (c) {
+		case 'l': loops = strtol(optarg, NULL, 0); break;
+		default:
+			return 1;
+		}
+	}
+
+	if (loops < 1)
+		return 1;
+
+	bench_mmu_init(&mmu);
+	bench.device = &device;
+	bench.client.super = true;
+	client.object.client = &client;
+	client.object.name = "benchClient";
+	client.driver = &bench_driver;
+	client.super = true;
+
+	for (i = 0; i < loops; i++) {
+		ret = bench_ctor(&client, false, &new, &n[0], &t[0]);
+		if (ret)
+			return ret;
+		total[0] += t[0];
+
+		ret = bench_ctor(&client, true, &old, &n[1], &t[1]);
+		if (ret)
+			return ret;
+		total[1] += t[1];
+
+		if (i == 0) {
+			assert(new.heap_nr == old.heap_nr &&
+			       new.type_nr == old.type_nr &&
+			       new.kind_nr == old.kind_nr &&
+			       new.kind_inv == old.kind_inv);
+			assert(!memcmp(new.heap, old.heap, new.heap_nr *
+				       sizeof(*new.heap)));
+			assert(!memcmp(new.type, old.type, new.type_nr *
+				       sizeof(*new.type)));
+			assert(!memcmp(new.kind, old.kind, new.kind_nr));
+			kinds = new.kind_nr;
+		}
+
+		nvif_mmu_dtor(&new);
+		nvif_mmu_dtor(&old);
+	}
+
+	printf("%d heaps, %d types, %d kinds\n",
+	       mmu.heap_nr, mmu.type_nr, kinds);
+	printf("info: %d ioctls, %lldns/ctor\n", n[0], total[0] / loops);
+	printf("old : %d ioctls, %lldns/ctor\n", n[1], total[1] / loops);
+	return 0;
+}
@@ -0,0 +1,464 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <nvif/class.h>
+#include <nvif/client.h>
+#include <nvif/driver.h>
+#include <nvif/if0008.h>
+#include <nvif/if000a.h>
+#include <nvif/if000c.h>
+#include <nvif/ioctl.h>
+#include <nvif/mem.h>
+#include <nvif/mmu.h>
+#include <nvif/pool.h>
+#include <nvif/vmm.h>
+
+/* Allocation churn through nvif_pool, against allocating every buffer as
+ * its own nvif_mem mapped into the VMM, for VRAM and a host-coherent
+ * mappable type.  There is no GPU behind this: a simulated MMU answers
+ * the ioctls, backs memory objects with malloc() and hands out VMM
+ * addresses from a bump allocator, so what's measured is the client-side
+ * cost and the number of round trips into the server.
+ */
+struct sim_object {
+	struct list_head head;
+	u64 handle;
+	s32 oclass;
+	void *data;
+};
+
+static struct {
+	struct list_head objects;
+	u64 vmm_addr;
+	long ioctls;
+} sim = {
+	.objects = LIST_HEAD_INIT(sim.objects),
+};
+
+static struct sim_object *
+sim_object(u64 handle)
+{
+	struct sim_object *object;
+
+	list_for_each_entry(object, &sim.objects, head) {
+		if (object->handle == handle) {
+			/* Keep recently-used objects near the front. */
+			list_move(&object->head, &sim.objects);
+			return object;
+		}
+	}
+
+	return NULL;
+}
+
+static int
+sim_new(struct sim_object *parent, struct nvif_ioctl_new_v0 *args, u32 argc)
+{
+	struct sim_object *object;
+	void *data = NULL;
+
+	switch (args->oclass) {
+	case NVIF_CLASS_MMU_GF100: {
+		struct nvif_mmu_v0 *mmu = (void *)args->data;
+		if (parent)
+			return -EINVAL;
+		mmu->dmabits = 40;
+		mmu->heap_nr = 2;
+		mmu->type_nr = 3;
+		mmu->kind_nr = 0;
+		break;
+	}
+	case NVIF_CLASS_MEM_GF100: {
+		struct nvif_mem_v0 *mem = (void *)args->data;
+		if (!parent || parent->oclass != NVIF_CLASS_MMU_GF100 ||
+		    mem->type >= 3 || !mem->size)
+			return -EINVAL;
+		mem->size = ALIGN(mem->size, 1ULL << mem->page);
+		mem->addr = 0;
+		if (!(data = malloc(mem->size)))
+			return -ENOMEM;
+		break;
+	}
+	case NVIF_CLASS_VMM_GF100: {
+		struct nvif_vmm_v0 *vmm = (void *)args->data;
+		if (!parent || parent->oclass != NVIF_CLASS_MMU_GF100)
+			return -EINVAL;
+		vmm->page_nr = 2;
+		vmm->addr = 0;
+		vmm->size = 1ULL << 40;
+		break;
+	}
+	default:
+		return -EINVAL;
+	}
+
+	if (!(object = calloc(1, sizeof(*object)))) {
+		free(data);
+		return -ENOMEM;
+	}
+	object->handle = args->object;
+	object->oclass = args->oclass;
+	object->data = data;
+	list_add(&object->head, &sim.objects);
+	return 0;
+}
+
+static int
+sim_mthd(struct sim_object *object, struct nvif_ioctl_mthd_v0 *args, u32 argc)
+{
+	switch (object ? object->oclass : 0) {
+	case NVIF_CLASS_MMU_GF100:
+		if (args->method == NVIF_MMU_V0_INFO) {
+			static const u8 types[] = {
+				0x00, NVIF_MMU_INFO_V0_TYPE_VRAM,
+				0x00, NVIF_MMU_INFO_V0_TYPE_VRAM |
+				      NVIF_MMU_INFO_V0_TYPE_MAPPABLE,
+				0x01, NVIF_MMU_INFO_V0_TYPE_HOST |
+				      NVIF_MMU_INFO_V0_TYPE_MAPPABLE |
+				      NVIF_MMU_INFO_V0_TYPE_COHERENT,
+			};
+			struct nvif_mmu_info_v0 *info = (void *)args->data;
+			u64 heap[] = { 2ULL << 30, ~0ULL };
+			memcpy(info->data, heap, sizeof(heap));
+			memcpy(info->data + sizeof(heap), types, sizeof(types));
+			info->kind_inv = 0;
+			return 0;
+		}
+		break;
+	case NVIF_CLASS_VMM_GF100:
+		switch (args->method) {
+		case NVIF_VMM_V0_PAGE: {
+			struct nvif_vmm_page_v0 *page = (void *)args->data;
+			page->shift = page->index ? 12 : 16;
+			page->sparse = 0;
+			page->vram = 1;
+			page->host = page->index != 0;
+			page->comp = 0;
+			return 0;
+		}
+		case NVIF_VMM_V0_GET: {
+			struct nvif_vmm_get_v0 *get = (void *)args->data;
+			get->addr = ALIGN(sim.vmm_addr, 1ULL << get->page);
+			sim.vmm_addr = get->addr + get->size;
+			return 0;
+		}
+		case NVIF_VMM_V0_MAP: {
+			struct nvif_vmm_map_v0 *map = (void *)args->data;
+			return sim_object(map->memory) ? 0 : -ENOENT;
+		}
+		case NVIF_VMM_V0_PUT:
+		case NVIF_VMM_V0_UNMAP:
+			return 0;
+		default:
+			break;
+		}
+		break;
+	default:
+		break;
+	}
+
+	return -EINVAL;
+}
+
+static int
+sim_ioctl(void *priv, bool super, void *data, u32 size, void **hack)
+{
+	struct nvif_ioctl_v0 *args = data;
+	struct sim_object *object = NULL;
+	u32 argc = size - sizeof(*args);
+
+	sim.ioctls++;
+
+	if (args->object && !(object = sim_object(args->object)))
+		return -ENOENT;
+
+	switch (args->type) {
+	case NVIF_IOCTL_V0_NEW:
+		return sim_new(object, (void *)args->data, argc);
+	case NVIF_IOCTL_V0_SCLASS: {
+		struct nvif_ioctl_sclass_v0 *sclass = (void *)args->data;
+		static const s32 oclass[] = {
+			NVIF_CLASS_MEM_GF100,
+			NVIF_CLASS_VMM_GF100,
+		};
+		int i;
+
+		if (!object || object->oclass != NVIF_CLASS_MMU_GF100)
+			return -EINVAL;
+		for (i = 0; i < sclass->count && i < ARRAY_SIZE(oclass); i++) {
+			sclass->oclass[i].oclass = oclass[i];
+			sclass->oclass[i].minver = -1;
+			sclass->oclass[i].maxver = -1;
+		}
+		sclass->count = ARRAY_SIZE(oclass);
+		return 0;
+	}
+	case NVIF_IOCTL_V0_MTHD:
+		return sim_mthd(object, (void *)args->data, argc);
+	case NVIF_IOCTL_V0_MAP: {
+		struct nvif_ioctl_map_v0 *map = (void *)args->data;
+		if (!object || !object->data)
+			return -EINVAL;
+		map->type = NVIF_IOCTL_MAP_V0_VA;
+		map->handle = (unsigned long)object->data;
+		map->length = 0;
+		return 0;
+	}
+	case NVIF_IOCTL_V0_UNMAP:
+		return 0;
+	case NVIF_IOCTL_V0_DEL:
+		if (object) {
+			list_del(&object->head);
+			free(object->data);
+			free(object);
+		}
+		return 0;
+	default:
+		return -ENOSYS;
+	}
+}
+
+static const struct nvif_driver
+sim_driver = {
+	.name = "sim",
+	.ioctl = sim_ioctl,
+};
+
+/* The same operations as nvif_pool, one buffer at a time. */
+struct bench_buf {
+	struct nvif_pool_alloc alloc;
+	struct nvif_mem mem;
+	struct nvif_vma vma;
+	u32 seed;
+};
+
+static int
+bench_direct_get(struct nvif_pool *pool, u32 size, struct bench_buf *buf)
+{
+	int ret;
+
+	ret = nvif_mem_ctor(pool->mmu, "benchMem", pool->mmu->mem, pool->type,
+			    pool->page, size, NULL, 0, &buf->mem);
+	if (ret)
+		return ret;
+
+	if (pool->type & NVIF_MEM_MAPPABLE) {
+		ret = nvif_object_map(&buf->mem.object, NULL, 0);
+		if (ret)
+			goto fail_mem;
+	}
+
+	ret = nvif_vmm_get(pool->vmm, ADDR, false, buf->mem.page, 0,
+			   buf->mem.size, &buf->vma);
+	if (ret)
+		goto fail_mem;
+
+	ret = nvif_vmm_map(pool->vmm, buf->vma.addr, buf->mem.size, NULL, 0,
+			   &buf->mem, 0);
+	if (ret)
+		goto fail_vma;
+
+	buf->alloc.mem = &buf->mem;
+	buf->alloc.addr = buf->vma.addr;
+	buf->alloc.ptr = buf->mem.object.map.ptr;
+	buf->alloc.size = size;
+	return 0;
+
+fail_vma:
+	nvif_vmm_put(pool->vmm, &buf->vma);
+fail_mem:
+	nvif_mem_dtor(&buf->mem);
+	return ret;
+}
+
+static void
+bench_direct_put(struct nvif_pool *pool, struct bench_buf *buf)
+{
+	nvif_vmm_unmap(pool->vmm, buf->vma.addr);
+	nvif_vmm_put(pool->vmm, &buf->vma);
+	nvif_mem_dtor(&buf->mem);
+}
+
+static u32
+bench_rand(u32 *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+/* Mostly small buffers of 64B-16KiB, with the odd 128KiB one. */
+static u32
+bench_size(u32 *state)
+{
+	u32 r = bench_rand(state);
+	if (r % 100 == 0)
+		return 128 << 10;
+	return (64 << (r % 9)) + ((r >> 8) & 63);
+}
+
+static void
+bench_fill(struct bench_buf *buf, u32 seed)
+{
+	u32 *ptr = buf->alloc.ptr;
+	int i;
+
+	buf->seed = seed;
+	for (i = 0; ptr && i < buf->alloc.size / 4; i++)
+		ptr[i] = seed + i;
+}
+
+static void
+bench_check(struct bench_buf *buf)
+{
+	u32 *ptr = buf->alloc.ptr;
+	int i;
+
+	for (i = 0; ptr && i < buf->alloc.size / 4; i++)
+		assert(ptr[i] == buf->seed + i);
+}
+
+static int
+bench(const char *name, struct nvif_pool *pool, bool direct, int live,
+      int loops)
+{
+	struct bench_buf *buf;
+	u32 state = 0x1234567;
+	long ioctls;
+	s64 time;
+	int ret = 0, i;
+
+	if (!(buf = calloc(live, sizeof(*buf))))
+		return -ENOMEM;
+
+	ioctls = sim.ioctls;
+	time = ktime_to_ns(ktime_get());
+	for (i = 0; i < live + loops; i++) {
+		struct bench_buf *b = &buf[bench_rand(&state) % live];
+		u32 size = bench_size(&state);
+
+		if (b->alloc.size) {
+			bench_check(b);
+			if (direct)
+				bench_direct_put(pool, b);
+			else
+				nvif_pool_put(pool, &b->alloc);
+		}
+
+		if (direct)
+			ret = bench_direct_get(pool, size, b);
+		else
+			ret = nvif_pool_get(pool, size, &b->alloc);
+		if (ret)
+			break;
+		bench_fill(b, i);
+	}
+
+	for (i = 0; i < live; i++) {
+		if (!buf[i].alloc.size)
+			continue;
+		bench_check(&buf[i]);
+		if (direct)
+			bench_direct_put(pool, &buf[i]);
+		else
+			nvif_pool_put(pool, &buf[i].alloc);
+	}
+	time = ktime_to_ns(ktime_get()) - time;
+	ioctls = sim.ioctls - ioctls;
+
+	printf("%-5s %-6s: %d allocs, %ld ioctls, %ld.%02ld ioctls/alloc, "
+	       "%lldns/alloc, %d slabs held\n", name,
+	       direct ? "direct" : "pool", live + loops, ioctls,
+	       ioctls / (live + loops), ioctls * 100 / (live + loops) % 100,
+	       time / (live + loops), direct ? 0 : pool->slab_nr);
+	free(buf);
+	return ret;
+}
+
+int
+main(int argc, char **argv)
+{
+	static const struct {
+		const char *name;
+		u8 type;
+		u8 page;
+	} types[] = {
+		{ "vram", NVIF_MEM_VRAM, 16 },
+		{ "host", NVIF_MEM_HOST | NVIF_MEM_MAPPABLE |
+			  NVIF_MEM_COHERENT, 12 },
+	};
+	struct nvif_client client = {};
+	struct nvif_mmu mmu;
+	struct nvif_vmm vmm;
+	struct nvif_pool pool;
+	int live = 256, loops = 100000, slab = 1 << 20;
+	int ret, c, i;
+
+	while ((c = getopt(argc, argv, "l:n:s:")) != -1) {
+		switch (c) {
+		case 'l': loops = strtol(optarg, NULL, 0); break;
+		case 'n': live = strtol(optarg, NULL, 0); break;
+		case 's': slab = strtol(optarg, NULL, 0); break;
+		default:
+			return 1;
+		}
+	}
+
+	if (live < 1 || loops < 1)
+		return 1;
+
+	client.object.client = &client;
+	client.object.name = "benchClient";
+	client.driver = &sim_driver;
+
+	ret = nvif_mmu_ctor(&client.object, "benchMmu", NVIF_CLASS_MMU_GF100,
+			    &mmu);
+	if (ret)
+		return ret;
+
+	ret = nvif_vmm_ctor(&mmu, "benchVmm", NVIF_CLASS_VMM_GF100, false,
+			    0, 0, NULL, 0, &vmm);
+	if (ret)
+		return ret;
+
+	printf("%d live buffers, %d slab bytes\n", live, slab);
+	for (i = 0; i < ARRAY_SIZE(types); i++) {
+		ret = nvif_pool_ctor(&mmu, &vmm, "benchPool", types[i].type,
+				     types[i].page, slab, &pool);
+		if (ret)
+			break;
+
+		ret = bench(types[i].name, &pool, true, live, loops);
+		if (ret == 0)
+			ret = bench(types[i].name, &pool, false, live, loops);
+		nvif_pool_trim(&pool);
+		assert(pool.slab_nr == 0);
+		nvif_pool_dtor(&pool);
+		if (ret)
+			break;
+	}
+
+	nvif_vmm_dtor(&vmm);
+	nvif_mmu_dtor(&mmu);
+	assert(list_empty(&sim.objects));
+	return ret;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "util.h"
+
+/* Measures library startup against the number of GPUs, using the null
+ * driver's NvNullDevices, with NvNullProbeDelay standing in for the time
+ * each GPU spends in BIOS shadowing and devinit.  Each count is run with
+ * the devices constructed one at a time, and on the worker pool, and the
+ * device list is checked to come back in bus order either way.
+ */
+static int
+bench_probe(int nr, int threads, long delay)
+{
+	struct nvif_client_devlist_v0 *args;
+	struct nvif_client client;
+	char cfg[64];
+	int ret, i;
+	s64 time;
+
+	snprintf(cfg, sizeof(cfg), "NvNullDevices=%d,NvNullProbeDelay=%ld",
+		 nr, delay);
+	u_cfg = cfg;
+	os_device_threads = threads;
+
+	time = ktime_to_ns(ktime_get());
+	ret = u_client("null", "bench", "fatal", false, false, 0, &client);
+	if (ret)
+		return ret;
+	time = ktime_to_ns(ktime_get()) - time;
+
+	args = u_device_list(&client);
+	if (!args || args->count != nr) {
+		fprintf(stderr, "%d devices, expected %d\n",
+			args ? args->count : -1, nr);
+		ret = -ENODEV;
+	}
+
+	for (i = 0; ret == 0 && i < nr; i++) {
+		if (args->device[i] != (u64)i << 16) {
+			fprintf(stderr, "device %d: %016llx\n",
+				i, args->device[i]);
+			ret = -EINVAL;
+		}
+	}
+
+	free(args);
+	nvif_client_dtor(&client);
+
+	if (ret == 0) {
+		printf("%4d %7d %10lld %10lld\n", nr, threads,
+		       time / 1000, time / 1000 / nr);
+	}
+	return ret;
+}
+
+int
+main(int argc, char **argv)
+{
+	int pool = os_device_threads, max = 16, nr, ret, c;
+	long delay = 50000;
+
+	while ((c = getopt(argc, argv, "n:p:")) != -1) {
+		switch (c) {
+		case 'n': max = strtol(optarg, NULL, 0); break;
+		case 'p': delay = strtol(optarg, NULL, 0); break;
+		default:
+			return 1;
+		}
+	}
+
+	if (max < 1 || max > 255 || delay < 0)
+		return 1;
+
+	printf("%ldus per device\n", delay);
+	printf("%4s %7s %10s %10s\n", "gpus", "threads", "us", "us/gpu");
+	for (nr = 1; nr <= max; nr *= 2) {
+		ret = bench_probe(nr, 1, delay);
+		if (ret == 0)
+			ret = bench_probe(nr, pool, delay);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
@@ -0,0 +1,284 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <core/ramht.h>
+
+#include "../drm/nouveau/nvkm/subdev/instmem/priv.h"
+
+/* Models the nv04-style RAMHT shared by all 16 channels: the channels
+ * are kept populated with the objects a channel normally gets, and each
+ * loop destroys one channel and creates it again.  The RAMHT lives in a
+ * host-memory instmem that counts maps and words written.
+ */
+static const struct {
+	u32 handle;
+	u32 context;
+} bench_objs[] = {
+	{ 0xbeef0201, 0x00000000 }, /* VRAM ctxdma */
+	{ 0xbeef0202, 0x00000000 }, /* GART ctxdma */
+	{ 0xbeef0301, 0x00000000 }, /* SW */
+	{ 0xbeef0039, 0x00010000 }, /* M2MF */
+	{ 0xbeef0062, 0x00010000 }, /* surf2d */
+	{ 0xbeef0097, 0x00010000 }, /* 3D */
+};
+
+static u64 bench_maps, bench_words;
+
+struct bench_instobj {
+	struct nvkm_instobj base;
+	struct nvkm_instmem *imem;
+	u32 *data;
+	u32 size;
+};
+#define bench_instobj(p) container_of((p), struct bench_instobj, base.memory)
+
+static enum nvkm_memory_target
+bench_instobj_target(struct nvkm_memory *memory)
+{
+	return NVKM_MEM_TARGET_INST;
+}
+
+static u64
+bench_instobj_addr(struct nvkm_memory *memory)
+{
+	return 0;
+}
+
+static u64
+bench_instobj_size(struct nvkm_memory *memory)
+{
+	return bench_instobj(memory)->size;
+}
+
+static u32
+bench_instobj_rd32(struct nvkm_memory *memory, u64 offset)
+{
+	return bench_instobj(memory)->data[offset / 4];
+}
+
+static void
+bench_instobj_wr32(struct nvkm_memory *memory, u64 offset, u32 data)
+{
+	bench_words++;
+	bench_instobj(memory)->data[offset / 4] = data;
+}
+
+static const struct nvkm_memory_ptrs
+bench_instobj_ptrs = {
+	.rd32 = bench_instobj_rd32,
+	.wr32 = bench_instobj_wr32,
+};
+
+static void __iomem *
+bench_instobj_acquire(struct nvkm_memory *memory)
+{
+	bench_maps++;
+	return NULL;
+}
+
+static void
+bench_instobj_release(struct nvkm_memory *memory)
+{
+}
+
+static void *
+bench_instobj_dtor(struct nvkm_memory *memory)
+{
+	struct bench_instobj *iobj = bench_instobj(memory);
+	nvkm_instobj_dtor(iobj->imem, &iobj->base);
+	free(iobj->data);
+	return iobj;
+}
+
+static const struct nvkm_memory_func
+bench_instobj_func = {
+	.dtor = bench_instobj_dtor,
+	.target = bench_instobj_target,
+	.addr = bench_instobj_addr,
+	.size = bench_instobj_size,
+	.acquire = bench_instobj_acquire,
+	.release = bench_instobj_release,
+};
+
+static int
+bench_instobj_new(struct nvkm_instmem *imem, u32 size, u32 align, bool zero,
+		  struct nvkm_memory **pmemory)
+{
+	struct bench_instobj *iobj;
+
+	if (!(iobj = kzalloc(sizeof(*iobj), GFP_KERNEL)))
+		return -ENOMEM;
+	*pmemory = &iobj->base.memory;
+
+	nvkm_instobj_ctor(&bench_instobj_func, imem, &iobj->base);
+	iobj->base.memory.ptrs = &bench_instobj_ptrs;
+	iobj->imem = imem;
+	iobj->size = size;
+	if (!(iobj->data = calloc(1, size)))
+		return -ENOMEM;
+	return 0;
+}
+
+static const struct nvkm_instmem_func
+bench_instmem = {
+	.memory_new = bench_instobj_new,
+	.zero = true,
+};
+
+static void
+bench_chan_new(struct nvkm_ramht *ramht, int chid, int *cookie)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bench_objs); i++) {
+		cookie[i] = nvkm_ramht_insert(ramht, NULL, chid, 4,
+					      bench_objs[i].handle,
+					      bench_objs[i].context |
+					      0x80000000 | chid << 24);
+		assert(cookie[i] > 0);
+	}
+}
+
+static void
+bench_chan_del(struct nvkm_ramht *ramht, int *cookie)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bench_objs); i++)
+		nvkm_ramht_remove(ramht, cookie[i]);
+}
+
+/* Everything the host copy claims is present must be in the RAMHT the
+ * GPU sees, and everything else must be empty.
+ */
+static void
+bench_check(struct nvkm_ramht *ramht, int chans)
+{
+	struct bench_instobj *iobj = bench_instobj(ramht->gpuobj->memory);
+	int chid, i, co;
+
+	for (chid = 0; chid < chans; chid++) {
+		for (i = 0; i < ARRAY_SIZE(bench_objs); i++) {
+			assert(nvkm_ramht_insert(ramht, NULL, chid, 4,
+						 bench_objs[i].handle, 0) ==
+			       -EEXIST);
+		}
+		assert(!nvkm_ramht_search(ramht, chid, 0xcafe0000));
+	}
+
+	for (co = 0; co < ramht->size; co++) {
+		if (ramht->data[co].chid < 0) {
+			assert(iobj->data[co * 2 + 0] == 0);
+			assert(iobj->data[co * 2 + 1] == 0);
+			continue;
+		}
+		assert(iobj->data[co * 2 + 0] == ramht->data[co].handle);
+		assert(iobj->data[co * 2 + 1] == ramht->data[co].context);
+	}
+}
+
+static void
+bench(struct nvkm_ramht *ramht, int (*cookie)[6], int chans, int loops)
+{
+	s64 time;
+	int i;
+
+	bench_maps = bench_words = 0;
+	time = ktime_to_ns(ktime_get());
+	for (i = 0; i < loops; i++) {
+		int chid = i % chans;
+		bench_chan_del(ramht, cookie[chid]);
+		bench_chan_new(ramht, chid, cookie[chid]);
+	}
+	time = ktime_to_ns(ktime_get()) - time;
+
+	printf("cycle : %d channel cycles in %lldus, %lldns/cycle, "
+	       "%lld maps, %lld words written\n",
+	       loops, time / 1000, time / loops, bench_maps, bench_words);
+	bench_check(ramht, chans);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct device dev = { .name = "bench" };
+	struct nvkm_device device = {
+		.dev = &dev,
+		.dbgopt = "fatal",
+	};
+	struct nvkm_instmem *imem;
+	struct nvkm_subdev *subdev;
+	struct nvkm_ramht *ramht;
+	int chans = 16, loops = 100000;
+	int (*cookie)[6];
+	int ret, c, i;
+	s64 time;
+
+	while ((c = getopt(argc, argv, "c:l:")) != -1) {
+		switch (c) {
+		case 'c': chans = strtol(optarg, NULL, 0); break;
+		case 'l': loops = strtol(optarg, NULL, 0); break;
+		default:
+			return 1;
+		}
+	}
+
+	if (chans < 1 || chans > 16 || loops < 1)
+		return 1;
+
+	if (!(imem = kzalloc(sizeof(*imem), GFP_KERNEL)))
+		return -ENOMEM;
+	nvkm_instmem_ctor(&bench_instmem, &device, NVKM_SUBDEV_INSTMEM, imem);
+	device.imem = imem;
+	subdev = &imem->subdev;
+
+	ret = nvkm_ramht_new(&device, 0x8000, 0, NULL, &ramht);
+	if (ret)
+		return ret;
+
+	cookie = calloc(chans, sizeof(*cookie));
+	if (!cookie)
+		return -ENOMEM;
+
+	for (i = 0; i < chans; i++)
+		bench_chan_new(ramht, i, cookie[i]);
+
+	printf("%d channels, %d entries of %d\n", chans,
+	       chans * (int)ARRAY_SIZE(bench_objs), ramht->size);
+	bench(ramht, cookie, chans, loops);
+
+	time = ktime_to_ns(ktime_get());
+	for (i = 0; i < loops; i++) {
+		int chid = i % chans;
+		u32 handle = bench_objs[i % ARRAY_SIZE(bench_objs)].handle;
+		nvkm_ramht_search(ramht, chid, handle);
+	}
+	time = ktime_to_ns(ktime_get()) - time;
+	printf("search: %d lookups in %lldus, %lldns/lookup\n",
+	       loops, time / 1000, time / loops);
+
+	for (i = 0; i < chans; i++)
+		bench_chan_del(ramht, cookie[i]);
+	nvkm_ramht_del(&ramht);
+	nvkm_subdev_del(&subdev);
+	free(cookie);
+	return 0;
+}
@@ -0,0 +1,320 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <subdev/bios.h>
+#include <subdev/bios/extdev.h>
+#include <subdev/bios/iccsense.h>
+#include <subdev/bios/power_budget.h>
+#include <subdev/i2c.h>
+#include <subdev/iccsense.h>
+
+#include "../drm/nouveau/nvkm/subdev/therm/priv.h"
+
+/* Runs the sensor polling against a simulated board for a number of
+ * (virtual) seconds, and counts the I2C traffic and sensor register
+ * reads caused by a hwmon-style reader plus the fan/threshold loops.
+ *
+ * The board has an INA3221 (3 rails) and an INA3221 (2 rails) on the
+ * primary bus, and an INA219 on the secondary bus.
+ */
+static u64 sim_time;
+static unsigned long sim_xfers, sim_msgs, sim_temps, sim_fans;
+static int sim_nack = -1;
+
+static struct sim_ina {
+	u8 type;
+	u8 addr;
+	u8 bus;
+	u8 ptr;
+	u16 reg[256];
+} sim_ina[] = {
+	{ NVBIOS_EXTDEV_INA3221, 0x40 << 1, 0 },
+	{ NVBIOS_EXTDEV_INA219 , 0x45 << 1, 1 },
+	{ NVBIOS_EXTDEV_INA3221, 0x41 << 1, 0 },
+};
+
+static struct pwr_rail_t
+sim_rail[] = {
+	{ 1, 0, 3, {{ 5, true }, { 5, true }, { 10, true }}, 0x7127 },
+	{ 1, 1, 1, {{ 2, true }}, 0x399f },
+	{ 1, 2, 2, {{ 5, true }, { 5, true }}, 0x7127 },
+};
+
+/* Interpose the timer and VBIOS/I2C lookups the subdevs use. */
+u64
+nvkm_timer_read(struct nvkm_timer *tmr)
+{
+	return sim_time;
+}
+
+int
+nvbios_power_budget_header(struct nvkm_bios *bios,
+			   struct nvbios_power_budget *budget)
+{
+	return -ENODEV;
+}
+
+int
+nvbios_iccsense_parse(struct nvkm_bios *bios, struct nvbios_iccsense *iccsense)
+{
+	iccsense->nr_entry = ARRAY_SIZE(sim_rail);
+	iccsense->rail = sim_rail;
+	return 0;
+}
+
+int
+nvbios_extdev_parse(struct nvkm_bios *bios, int idx,
+		    struct nvbios_extdev_func *func)
+{
+	if (idx >= ARRAY_SIZE(sim_ina))
+		return -EINVAL;
+	func->type = sim_ina[idx].type;
+	func->addr = sim_ina[idx].addr;
+	func->bus = sim_ina[idx].bus;
+	return 0;
+}
+
+static int
+sim_xfer(struct i2c_adapter *adap, struct i2c_msg *msg, int num)
+{
+	int bus = adap->owner, i, j;
+
+	sim_xfers++;
+	for (i = 0; i < num; i++, sim_msgs++) {
+		struct sim_ina *ina = NULL;
+
+		for (j = 0; j < ARRAY_SIZE(sim_ina); j++) {
+			if (sim_ina[j].bus == bus &&
+			    sim_ina[j].addr >> 1 == msg[i].addr)
+				ina = &sim_ina[j];
+		}
+
+		if (!ina || ina - sim_ina == sim_nack)
+			return -EIO;
+
+		if (msg[i].flags & I2C_M_RD) {
+			msg[i].buf[0] = ina->reg[ina->ptr] >> 8;
+			msg[i].buf[1] = ina->reg[ina->ptr];
+		} else {
+			ina->ptr = msg[i].buf[0];
+			if (msg[i].len == 3)
+				ina->reg[ina->ptr] = msg[i].buf[1] << 8 |
+						     msg[i].buf[2];
+		}
+	}
+
+	return num;
+}
+
+static const struct i2c_algorithm
+sim_algo = {
+	.master_xfer = sim_xfer,
+};
+
+static struct nvkm_i2c_bus
+sim_bus[] = {
+	{ .i2c = { .algo = &sim_algo, .owner = 0 } },
+	{ .i2c = { .algo = &sim_algo, .owner = 1 } },
+};
+
+struct nvkm_i2c_bus *
+nvkm_i2c_bus_find(struct nvkm_i2c *i2c, int id)
+{
+	switch (id) {
+	case NVKM_I2C_BUS_PRI: return &sim_bus[0];
+	case NVKM_I2C_BUS_SEC: return &sim_bus[1];
+	default:
+		return NULL;
+	}
+}
+
+static int
+sim_temp_get(struct nvkm_therm *therm)
+{
+	sim_temps++;
+	return 50 + (sim_time / 1000000000ULL) % 20;
+}
+
+static int
+sim_fan_sense(struct nvkm_therm *therm)
+{
+	sim_fans++;
+	return 1500;
+}
+
+static const struct nvkm_therm_func
+sim_therm = {
+	.temp_get = sim_temp_get,
+	.fan_sense = sim_fan_sense,
+};
+
+/* Programs the sensors with a new set of readings, and returns the
+ * power that should be reported for them.
+ */
+static int
+sim_load(u64 seed)
+{
+	int power = 0, i, r;
+
+	for (i = 0; i < ARRAY_SIZE(sim_rail); i++) {
+		struct pwr_rail_t *rail = &sim_rail[i];
+		struct sim_ina *ina = &sim_ina[rail->extdev_id];
+
+		for (r = 0; r < rail->resistor_count; r++) {
+			int mohm = rail->resistors[r].mohm;
+			u16 vshunt = 0x100 + (seed * 7 + i * 3 + r) % 0x400;
+			u16 vbus = 0x6000 + (seed * 13 + i + r * 5) % 0x1000;
+
+			if (ina->type == NVBIOS_EXTDEV_INA3221) {
+				ina->reg[1 + r * 2] = vshunt;
+				ina->reg[2 + r * 2] = vbus;
+				power += (vbus >> 3) * (vshunt >> 3) * 320 / mohm;
+			} else {
+				ina->reg[1] = vshunt;
+				ina->reg[2] = vbus;
+				power += (vbus >> 3) * vshunt * 40 / mohm;
+			}
+		}
+	}
+
+	return power;
+}
+
+static int
+sim_run(int period, int rate, int seconds, bool verbose)
+{
+	struct device dev = { .name = "bench" };
+	struct nvkm_device device = {
+		.dev = &dev,
+		.dbgopt = "fatal",
+	};
+	struct nvkm_bios bios = {};
+	struct nvkm_i2c i2c = {};
+	struct nvkm_iccsense *iccsense = NULL;
+	struct nvkm_therm *therm = NULL;
+	struct nvkm_subdev *subdev;
+	char cfgopt[64];
+	u64 step = 1000000, end = seconds * 1000000000ULL;
+	u64 rd = 1000000000ULL / rate, pd = period * 1000000ULL;
+	int ret, power = 0;
+
+	snprintf(cfgopt, sizeof(cfgopt), "NvSensorPeriod=%d", period);
+	device.cfgopt = cfgopt;
+	device.bios = &bios;
+	device.i2c = &i2c;
+	sim_time = 1;
+	sim_nack = -1;
+	sim_ina[0].reg[0xff] = 0x3220;
+	sim_ina[0].reg[0xfe] = 0x5449;
+	sim_ina[2].reg[0xff] = 0x3220;
+	sim_ina[2].reg[0xfe] = 0x5449;
+
+	ret = gf100_iccsense_new(&device, NVKM_SUBDEV_ICCSENSE, &iccsense);
+	if (ret == 0) {
+		device.iccsense = iccsense;
+		ret = nvkm_subdev_init(&iccsense->subdev);
+	}
+	if (ret == 0)
+		ret = nvkm_therm_new_(&sim_therm, &device, NVKM_SUBDEV_THERM,
+				      &therm);
+	if (ret)
+		goto done;
+
+	sim_xfers = sim_msgs = sim_temps = sim_fans = 0;
+
+	for (; sim_time < end; sim_time += step) {
+		/* the sensor polling, on its own time base */
+		if (pd && sim_time % pd == 1) {
+			power = sim_load(sim_time / pd);
+			nvkm_therm_sample(therm);
+		}
+
+		/* hwmon-style reader */
+		if (sim_time % rd == 1) {
+			if (!pd)
+				power = sim_load(sim_time / rd);
+			assert(nvkm_therm_temp_get(therm) >= 50);
+			assert(nvkm_therm_fan_sense(therm) == 1500);
+			assert(nvkm_iccsense_read_all(iccsense) == power);
+		}
+
+		/* fan management and threshold polling, once a second */
+		if (sim_time % 1000000000ULL == 1) {
+			assert(nvkm_therm_temp_get(therm) >= 50);
+			assert(nvkm_therm_temp_get(therm) >= 50);
+		}
+	}
+
+	if (verbose) {
+		printf("period %4dms, reader %dHz: "
+		       "%lu i2c xfers/s (%lu msgs/s), "
+		       "%lu temp reads/s, %lu fan reads/s\n",
+		       period, rate,
+		       sim_xfers / seconds, sim_msgs / seconds,
+		       sim_temps / seconds, sim_fans / seconds);
+	}
+
+	/* A sensor that stops responding shouldn't take the others, or the
+	 * power reading, down with it.
+	 */
+	power = sim_load(0);
+	assert(nvkm_iccsense_sample(iccsense) == power);
+	sim_nack = 1;
+	sim_xfers = 0;
+	assert(nvkm_iccsense_sample(iccsense) == power);
+	assert(sim_xfers == 4); /* PRI batch, SEC batch, SEC rail retry */
+	sim_nack = -1;
+	power = sim_load(2);
+	assert(nvkm_iccsense_sample(iccsense) == power);
+
+done:
+	subdev = therm ? &therm->subdev : NULL;
+	nvkm_subdev_del(&subdev);
+	subdev = iccsense ? &iccsense->subdev : NULL;
+	nvkm_subdev_del(&subdev);
+	return ret;
+}
+
+int
+main(int argc, char **argv)
+{
+	int period = 1000, rate = 10, seconds = 60;
+	int ret, c;
+
+	while ((c = getopt(argc, argv, "p:r:s:")) != -1) {
+		switch (c) {
+		case 'p': period = strtol(optarg, NULL, 0); break;
+		case 'r': rate = strtol(optarg, NULL, 0); break;
+		case 's': seconds = strtol(optarg, NULL, 0); break;
+		default:
+			return 1;
+		}
+	}
+
+	if (period < 0 || period > 4000 || rate < 1 || 1000 % rate ||
+	    seconds < 1)
+		return 1;
+
+	ret = sim_run(0, rate, seconds, true);
+	if (ret == 0 && period)
+		ret = sim_run(period, rate, seconds, true);
+	return ret;
+}
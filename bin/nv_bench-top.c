@@ -0,0 +1,269 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <core/device.h>
+
+#include "../drm/nouveau/nvkm/subdev/top/priv.h"
+
+/* Builds a synthetic PTOP device table, of the size seen on Volta and
+ * Turing boards, and measures top-level interrupt dispatch against a
+ * walk of the device list.  Every lookup is checked against the walk.
+ */
+static const struct {
+	enum nvkm_devidx index;
+	u32 addr;
+	int fault;
+	int engine;
+	int runlist;
+	int reset;
+	int intr;
+} bench_device[] = {
+	{ NVKM_ENGINE_GR    , 0x400000,  0,  0,  0, 12, 12 },
+	{ NVKM_ENGINE_CE0   , 0x104000, 15,  1,  1,  6,  5 },
+	{ NVKM_ENGINE_CE1   , 0x104000, 16,  2,  2,  7,  6 },
+	{ NVKM_ENGINE_CE2   , 0x104000, 17,  3,  3, 21, 22 },
+	{ NVKM_ENGINE_CE3   , 0x104000, 18,  4,  3, 21, 22 },
+	{ NVKM_ENGINE_CE4   , 0x104000, 19,  5,  4, 21, 22 },
+	{ NVKM_ENGINE_CE5   , 0x104000, 20,  6,  4, 21, 22 },
+	{ NVKM_ENGINE_CE6   , 0x104000, 21,  7,  5, 21, 22 },
+	{ NVKM_ENGINE_CE7   , 0x104000, 22,  8,  5, 21, 22 },
+	{ NVKM_ENGINE_CE8   , 0x104000, 23,  9,  6, 21, 22 },
+	{ NVKM_ENGINE_NVDEC0, 0x084000, 10, 10,  7, 15, 15 },
+	{ NVKM_ENGINE_NVENC0, 0x1c8000, 11, 11,  8, 18, 16 },
+	{ NVKM_ENGINE_NVENC1, 0x1c9000, 12, 12,  9, 19, 17 },
+	{ NVKM_ENGINE_SEC2  , 0x840000, 14, 13, 10, 14, 14 },
+	{ NVKM_SUBDEV_GSP   , 0x110000, -1, -1, -1, 20, 20 },
+	{ NVKM_SUBDEV_NR    , 0x140000, -1, -1, -1, 25, 25 },
+	{ NVKM_SUBDEV_NR    , 0x141000, -1, -1, -1, 26, 26 },
+	{ NVKM_SUBDEV_NR    , 0x142000, -1, -1, -1, 27, 27 },
+	{ NVKM_SUBDEV_NR    , 0x9a0000, -1, -1, -1, -1, -1 },
+	{ NVKM_SUBDEV_NR    , 0x820000, -1, -1, -1, 28, -1 },
+	{ NVKM_SUBDEV_NR    , 0x1b0000, -1, -1, -1, -1, 29 },
+	{ NVKM_SUBDEV_NR    , 0x000000, -1, -1, -1, -1, -1 },
+};
+
+static int
+bench_oneinit(struct nvkm_top *top)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bench_device); i++) {
+		struct nvkm_top_device *info = nvkm_top_device_new(top);
+		if (!info)
+			return -ENOMEM;
+		info->index = bench_device[i].index;
+		info->addr = bench_device[i].addr;
+		info->fault = bench_device[i].fault;
+		info->engine = bench_device[i].engine;
+		info->runlist = bench_device[i].runlist;
+		info->reset = bench_device[i].reset;
+		info->intr = bench_device[i].intr;
+	}
+
+	return 0;
+}
+
+static const struct nvkm_top_func
+bench_top = {
+	.oneinit = bench_oneinit,
+};
+
+/* The list walks the lookup tables replaced. */
+static struct nvkm_top_device *
+walk_index(struct nvkm_top *top, enum nvkm_devidx index, bool reset, bool intr,
+	   bool fault)
+{
+	struct nvkm_top_device *info;
+
+	list_for_each_entry(info, &top->device, head) {
+		if (info->index == index && (!reset || info->reset >= 0) &&
+		    (!intr || info->intr >= 0) && (!fault || info->fault >= 0))
+			return info;
+	}
+
+	return NULL;
+}
+
+static enum nvkm_devidx
+walk_fault(struct nvkm_top *top, int fault)
+{
+	struct nvkm_top_device *info;
+
+	list_for_each_entry(info, &top->device, head) {
+		if (info->fault == fault)
+			return info->index;
+	}
+
+	return NVKM_SUBDEV_NR;
+}
+
+static struct nvkm_top_device *
+walk_engine(struct nvkm_top *top, int index)
+{
+	struct nvkm_top_device *info;
+	int n = 0;
+
+	list_for_each_entry(info, &top->device, head) {
+		if (info->engine >= 0 && info->runlist >= 0 && n++ == index)
+			return info;
+	}
+
+	return NULL;
+}
+
+static u32
+walk_intr(struct nvkm_top *top, u32 intr, u64 *psubdevs)
+{
+	struct nvkm_top_device *info;
+	u64 subdevs = 0;
+	u32 handled = 0;
+
+	list_for_each_entry(info, &top->device, head) {
+		if (info->index != NVKM_SUBDEV_NR && info->intr >= 0) {
+			if (intr & BIT(info->intr)) {
+				subdevs |= BIT_ULL(info->index);
+				handled |= BIT(info->intr);
+			}
+		}
+	}
+
+	*psubdevs = subdevs;
+	return intr & ~handled;
+}
+
+static void
+bench_check(struct nvkm_device *device, struct nvkm_top *top)
+{
+	struct nvkm_top_device *info;
+	u64 subdevs[2];
+	int i, runl, engn;
+
+	for (i = 0; i <= NVKM_SUBDEV_NR; i++) {
+		info = walk_index(top, i, false, false, false);
+		assert(nvkm_top_addr(device, i) == (info ? info->addr : 0));
+		info = walk_index(top, i, true, false, false);
+		assert(nvkm_top_reset(device, i) ==
+		       (info ? BIT(info->reset) : 0));
+		info = walk_index(top, i, false, true, false);
+		assert(nvkm_top_intr_mask(device, i) ==
+		       (info ? BIT(info->intr) : 0));
+		info = walk_index(top, i, false, false, true);
+		assert(nvkm_top_fault_id(device, i) ==
+		       (info ? info->fault : -ENOENT));
+	}
+
+	for (i = -2; i < 160; i++)
+		assert(nvkm_top_fault(device, i) == walk_fault(top, i));
+
+	for (i = 0; i < 80; i++) {
+		info = walk_engine(top, i);
+		if (!info) {
+			assert((int)nvkm_top_engine(device, i, &runl, &engn) < 0);
+			continue;
+		}
+		assert(nvkm_top_engine(device, i, &runl, &engn) == info->index);
+		assert(runl == info->runlist && engn == info->engine);
+	}
+
+	for (i = 0; i < 4096; i++) {
+		u32 intr = i < 32 ? BIT(i) : (u32)(i * 2654435761U);
+		assert(nvkm_top_intr(device, intr, &subdevs[0]) ==
+		       walk_intr(top, intr, &subdevs[1]));
+		assert(subdevs[0] == subdevs[1]);
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	struct device dev = { .name = "bench" };
+	struct nvkm_device device = {
+		.dev = &dev,
+		.dbgopt = "fatal",
+	};
+	struct nvkm_subdev *subdev;
+	struct nvkm_top *top;
+	u32 intr[256], stat = 0;
+	u64 subdevs, mask = 0;
+	int loops = 10000000;
+	int ret, c, i;
+	s64 time[2];
+
+	while ((c = getopt(argc, argv, "l:")) != -1) {
+		switch (c) {
+		case 'l': loops = strtol(optarg, NULL, 0); break;
+		default:
+			return 1;
+		}
+	}
+
+	if (loops < 1)
+		return 1;
+
+	ret = nvkm_top_new_(&bench_top, &device, NVKM_SUBDEV_TOP, &top);
+	if (ret)
+		return ret;
+	subdev = &top->subdev;
+	device.top = top;
+
+	ret = nvkm_subdev_init(subdev);
+	if (ret)
+		goto done;
+
+	bench_check(&device, top);
+
+	/* Mostly a single engine pending, sometimes two, and now and then
+	 * a bit nobody in PTOP claims.
+	 */
+	for (i = 0; i < ARRAY_SIZE(intr); i++) {
+		intr[i] = BIT(bench_device[(i * 7) % 16].intr);
+		if (i % 4 == 0)
+			intr[i] |= BIT(bench_device[(i * 3) % 14].intr);
+		if (i % 16 == 0)
+			intr[i] |= BIT(30);
+	}
+
+	time[0] = ktime_to_ns(ktime_get());
+	for (i = 0; i < loops; i++) {
+		stat |= walk_intr(top, intr[i % ARRAY_SIZE(intr)], &subdevs);
+		mask |= subdevs;
+	}
+	time[0] = ktime_to_ns(ktime_get()) - time[0];
+
+	time[1] = ktime_to_ns(ktime_get());
+	for (i = 0; i < loops; i++) {
+		stat |= nvkm_top_intr(&device, intr[i % ARRAY_SIZE(intr)],
+				      &subdevs);
+		mask |= subdevs;
+	}
+	time[1] = ktime_to_ns(ktime_get()) - time[1];
+
+	printf("%d PTOP devices, %d dispatches (stat %08x subdevs %016llx)\n",
+	       (int)ARRAY_SIZE(bench_device), loops, stat, mask);
+	printf("walked : %lldus, %lldns/intr\n", time[0] / 1000,
+	       time[0] / loops);
+	printf("indexed: %lldus, %lldns/intr\n", time[1] / 1000,
+	       time[1] / loops);
+
+done:
+	nvkm_subdev_del(&subdev);
+	return ret;
+}
@@ -0,0 +1,565 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <core/client.h>
+#include <core/memory.h>
+#include <nvif/class.h>
+#include <nvif/client.h>
+#include <nvif/driver.h>
+#include <nvif/if000c.h>
+#include <nvif/ioctl.h>
+#include <nvif/mem.h>
+#include <nvif/mmu.h>
+#include <nvif/vmm.h>
+
+#include "../drm/nouveau/nvkm/subdev/instmem/priv.h"
+#include "../drm/nouveau/nvkm/subdev/mmu/ummu.h"
+#include "../drm/nouveau/nvkm/subdev/mmu/umem.h"
+#include "../drm/nouveau/nvkm/subdev/mmu/uvmm.h"
+#include "../drm/nouveau/nvkm/subdev/mmu/vmm.h"
+
+/* Binds 4KiB ranges of a host memory object into a GF100-layout VMM,
+ * one NVIF_VMM_V0_MAP/UNMAP per range (both, for a remap) against
+ * NVIF_VMM_V0_BIND, and reports the ioctls, TLB flushes and time each
+ * takes.  The transport is a minimal nvif driver that hands ioctls
+ * straight to nvkm_uvmm, the page tables live in a calloc()'d instmem,
+ * and the TLB flush is only a counter plus a busy-wait standing in for
+ * the MMIO round-trips.
+ */
+static struct {
+	struct nvkm_client *client;
+	struct nvkm_ummu ummu;
+	bool nobind;
+	u64 ioctls;
+	u64 flushes;
+	s64 flush_ns;
+} bench;
+
+struct bench_instobj {
+	struct nvkm_instobj base;
+	struct nvkm_instmem *imem;
+	struct list_head head;
+	u32 *data;
+	u32 size;
+};
+#define bench_instobj(p) container_of((p), struct bench_instobj, base.memory)
+
+static struct list_head bench_instobjs = LIST_HEAD_INIT(bench_instobjs);
+
+static enum nvkm_memory_target
+bench_instobj_target(struct nvkm_memory *memory)
+{
+	return NVKM_MEM_TARGET_VRAM;
+}
+
+static u64
+bench_instobj_addr(struct nvkm_memory *memory)
+{
+	return 0;
+}
+
+static u64
+bench_instobj_size(struct nvkm_memory *memory)
+{
+	return bench_instobj(memory)->size;
+}
+
+static u32
+bench_instobj_rd32(struct nvkm_memory *memory, u64 offset)
+{
+	return bench_instobj(memory)->data[offset / 4];
+}
+
+static void
+bench_instobj_wr32(struct nvkm_memory *memory, u64 offset, u32 data)
+{
+	bench_instobj(memory)->data[offset / 4] = data;
+}
+
+static const struct nvkm_memory_ptrs
+bench_instobj_ptrs = {
+	.rd32 = bench_instobj_rd32,
+	.wr32 = bench_instobj_wr32,
+};
+
+static void __iomem *
+bench_instobj_acquire(struct nvkm_memory *memory)
+{
+	return NULL;
+}
+
+static void
+bench_instobj_release(struct nvkm_memory *memory)
+{
+}
+
+static void *
+bench_instobj_dtor(struct nvkm_memory *memory)
+{
+	struct bench_instobj *iobj = bench_instobj(memory);
+	nvkm_instobj_dtor(iobj->imem, &iobj->base);
+	list_del(&iobj->head);
+	free(iobj->data);
+	return iobj;
+}
+
+static const struct nvkm_memory_func
+bench_instobj_func = {
+	.dtor = bench_instobj_dtor,
+	.target = bench_instobj_target,
+	.addr = bench_instobj_addr,
+	.size = bench_instobj_size,
+	.acquire = bench_instobj_acquire,
+	.release = bench_instobj_release,
+};
+
+static int
+bench_instobj_new(struct nvkm_instmem *imem, u32 size, u32 align, bool zero,
+		  struct nvkm_memory **pmemory)
+{
+	struct bench_instobj *iobj;
+
+	if (!(iobj = kzalloc(sizeof(*iobj), GFP_KERNEL)))
+		return -ENOMEM;
+	*pmemory = &iobj->base.memory;
+
+	nvkm_instobj_ctor(&bench_instobj_func, imem, &iobj->base);
+	iobj->base.memory.ptrs = &bench_instobj_ptrs;
+	iobj->imem = imem;
+	iobj->size = size;
+	list_add_tail(&iobj->head, &bench_instobjs);
+	if (!(iobj->data = calloc(1, size)))
+		return -ENOMEM;
+	return 0;
+}
+
+static const struct nvkm_instmem_func
+bench_instmem = {
+	.memory_new = bench_instobj_new,
+	.zero = true,
+};
+
+/* FNV-1a over the contents of every page table. */
+static u64
+bench_ptes(void)
+{
+	struct bench_instobj *iobj;
+	u64 hash = 0xcbf29ce484222325ULL;
+	u32 i;
+
+	list_for_each_entry(iobj, &bench_instobjs, head) {
+		for (i = 0; i < iobj->size / 4; i++) {
+			hash ^= iobj->data[i];
+			hash *= 0x100000001b3ULL;
+		}
+	}
+
+	return hash;
+}
+
+static void
+bench_flush(struct nvkm_vmm *vmm, int depth)
+{
+	s64 time = ktime_to_ns(ktime_get()) + bench.flush_ns;
+
+	bench.flushes++;
+	while (ktime_to_ns(ktime_get()) < time)
+		;
+}
+
+/* Same layout as GF100 with 128KiB large pages. */
+static const struct nvkm_vmm_desc
+bench_vmm_desc_17_12[] = {
+	{ SPT, 15, 8, 0x1000, &gf100_vmm_pgt },
+	{ PGD, 13, 8, 0x1000, &gf100_vmm_pgd },
+	{}
+};
+
+static const struct nvkm_vmm_desc
+bench_vmm_desc_17_17[] = {
+	{ LPT, 10, 8, 0x1000, &gf100_vmm_pgt },
+	{ PGD, 13, 8, 0x1000, &gf100_vmm_pgd },
+	{}
+};
+
+static const struct nvkm_vmm_func
+bench_vmm = {
+	.aper = gf100_vmm_aper,
+	.valid = gf100_vmm_valid,
+	.flush = bench_flush,
+	.page = {
+		{ 17, &bench_vmm_desc_17_17[0], NVKM_VMM_PAGE_xVxC },
+		{ 12, &bench_vmm_desc_17_12[0], NVKM_VMM_PAGE_xVHx },
+		{}
+	}
+};
+
+static int
+bench_vmm_new(struct nvkm_mmu *mmu, bool managed, u64 addr, u64 size,
+	      void *argv, u32 argc, struct lock_class_key *key,
+	      const char *name, struct nvkm_vmm **pvmm)
+{
+	return nv04_vmm_new_(&bench_vmm, mmu, 0, managed, addr, size,
+			     argv, argc, key, name, pvmm);
+}
+
+static const struct nvkm_mmu_func
+bench_mmu = {
+	.dma_bits = 40,
+	.mmu = {{ -1, -1, NVIF_CLASS_MMU_GF100}},
+	.mem = {{ -1,  0, NVIF_CLASS_MEM_GF100}},
+	.vmm = {{ -1, -1, NVIF_CLASS_VMM_GF100}, bench_vmm_new },
+	.kind = gf100_mmu_kind,
+};
+
+static int
+bench_ioctl(void *priv, bool super, void *data, u32 size, void **hack)
+{
+	struct nvif_ioctl_v0 *args = data;
+	void *argv = args->data;
+	u32 argc = size - sizeof(*args);
+	struct nvkm_oclass oclass = {
+		.client = bench.client,
+		.parent = &bench.ummu.object,
+		.base.maxver = -1,
+	};
+	struct nvkm_object *object;
+	int ret;
+
+	bench.ioctls++;
+
+	switch (args->type) {
+	case NVIF_IOCTL_V0_NEW: {
+		struct nvif_ioctl_new_v0 *new = argv;
+		oclass.handle = new->handle;
+		oclass.object = new->object;
+		argv = new->data;
+		argc = argc - sizeof(*new);
+		if (new->oclass == NVIF_CLASS_MEM_GF100)
+			ret = nvkm_umem_new(&oclass, argv, argc, &object);
+		else
+		if (new->oclass == NVIF_CLASS_VMM_GF100)
+			ret = nvkm_uvmm_new(&oclass, argv, argc, &object);
+		else
+			return -ENODEV;
+		if (ret == 0 && !nvkm_object_insert(object))
+			ret = -EEXIST;
+		if (ret)
+			nvkm_object_del(&object);
+		return ret;
+	}
+	case NVIF_IOCTL_V0_MTHD: {
+		struct nvif_ioctl_mthd_v0 *mthd = argv;
+		if (bench.nobind && mthd->method == NVIF_VMM_V0_BIND)
+			return -EINVAL;
+		object = nvkm_object_search(bench.client, args->object, NULL);
+		if (IS_ERR(object))
+			return PTR_ERR(object);
+		return nvkm_object_mthd(object, mthd->method, mthd->data,
+					argc - sizeof(*mthd));
+	}
+	case NVIF_IOCTL_V0_DEL:
+		object = nvkm_object_search(bench.client, args->object, NULL);
+		if (IS_ERR(object))
+			return PTR_ERR(object);
+		nvkm_object_del(&object);
+		return 0;
+	default:
+		return -ENOSYS;
+	}
+}
+
+static const struct nvif_driver
+bench_driver = {
+	.name = "bench",
+	.ioctl = bench_ioctl,
+};
+
+/* The ranges are visited in a random order, as lib/rb.c is an unbalanced
+ * tree and splitting a VMA in address order would turn it into a list.
+ */
+static void
+bench_ops(struct nvif_vmm_bind *bind, const int *perm, int nr,
+	  enum nvif_vmm_bind_type type, u64 addr, struct nvif_mem *mem,
+	  int pages, int shift)
+{
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		bind[i].type = type;
+		bind[i].addr = addr + ((u64)perm[i] << 12);
+		bind[i].size = 1ULL << 12;
+		bind[i].mem = mem;
+		bind[i].offset = (u64)((perm[i] + shift) % pages) << 12;
+		bind[i].ret = 1;
+	}
+}
+
+static int *
+bench_perm(int nr)
+{
+	int *perm = calloc(nr, sizeof(*perm));
+	int i, j, t;
+
+	assert(perm);
+	for (i = 0; i < nr; i++)
+		perm[i] = i;
+
+	for (i = nr - 1; i > 0; i--) {
+		j = random() % (i + 1);
+		t = perm[i];
+		perm[i] = perm[j];
+		perm[j] = t;
+	}
+
+	return perm;
+}
+
+static void
+bench_single(struct nvif_vmm *vmm, struct nvif_vmm_bind *bind, int nr)
+{
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		if (bind[i].type != NVIF_VMM_BIND_MAP) {
+			bind[i].ret = nvif_vmm_unmap(vmm, bind[i].addr);
+			assert(bind[i].ret == 0);
+		}
+		if (bind[i].type != NVIF_VMM_BIND_UNMAP) {
+			bind[i].ret = nvif_vmm_map(vmm, bind[i].addr,
+						   bind[i].size, NULL, 0,
+						   bind[i].mem,
+						   bind[i].offset);
+		}
+		assert(bind[i].ret == 0);
+	}
+}
+
+static void
+bench_batch(struct nvif_vmm *vmm, struct nvif_vmm_bind *bind, int nr)
+{
+	int i;
+
+	assert(nvif_vmm_bind(vmm, bind, nr, NULL, 0) == 0);
+	for (i = 0; i < nr; i++)
+		assert(bind[i].ret == 0);
+}
+
+static s64
+bench_time(const char *name, struct nvif_vmm *vmm, struct nvif_vmm_bind *bind,
+	   int nr, void (*func)(struct nvif_vmm *, struct nvif_vmm_bind *, int))
+{
+	s64 time;
+
+	bench.ioctls = bench.flushes = 0;
+	time = ktime_to_ns(ktime_get());
+	func(vmm, bind, nr);
+	time = ktime_to_ns(ktime_get()) - time;
+
+	printf("%7d %-6s %-6s %8llu %8llu %10lld %8lld\n", nr,
+	       func == bench_batch ? "batch" : "single", name,
+	       bench.ioctls, bench.flushes, time / 1000, time / nr);
+	return time;
+}
+
+/* Maps, remaps and unmaps 'nr' ranges both ways, and checks that both
+ * leave the page tables in the same state.
+ */
+static void
+bench_bind(struct nvif_vmm *vmm, struct nvif_mem *mem, int pages, int nr)
+{
+	struct nvif_vmm_bind *bind;
+	struct nvif_vma vma;
+	u64 empty, mapped, remapped;
+	int *perm, ret;
+
+	bind = calloc(nr, sizeof(*bind));
+	assert(bind);
+	perm = bench_perm(nr);
+
+	ret = nvif_vmm_get(vmm, PTES, false, 12, 0, (u64)nr << 12, &vma);
+	assert(ret == 0);
+	empty = bench_ptes();
+
+	bench_ops(bind, perm, nr, NVIF_VMM_BIND_MAP, vma.addr, mem, pages, 0);
+	bench_time("map", vmm, bind, nr, bench_single);
+	mapped = bench_ptes();
+	bench_ops(bind, perm, nr, NVIF_VMM_BIND_REMAP, vma.addr, mem, pages, 1);
+	bench_time("remap", vmm, bind, nr, bench_single);
+	remapped = bench_ptes();
+	bench_ops(bind, perm, nr, NVIF_VMM_BIND_UNMAP, vma.addr, NULL, pages, 0);
+	bench_time("unmap", vmm, bind, nr, bench_single);
+	assert(bench_ptes() == empty);
+
+	bench_ops(bind, perm, nr, NVIF_VMM_BIND_MAP, vma.addr, mem, pages, 0);
+	bench_time("map", vmm, bind, nr, bench_batch);
+	assert(bench_ptes() == mapped);
+	bench_ops(bind, perm, nr, NVIF_VMM_BIND_REMAP, vma.addr, mem, pages, 1);
+	bench_time("remap", vmm, bind, nr, bench_batch);
+	assert(bench_ptes() == remapped);
+	bench_ops(bind, perm, nr, NVIF_VMM_BIND_UNMAP, vma.addr, NULL, pages, 0);
+	bench_time("unmap", vmm, bind, nr, bench_batch);
+	assert(bench_ptes() == empty);
+
+	nvif_vmm_put(vmm, &vma);
+	free(perm);
+	free(bind);
+}
+
+/* A batch with one bad operation is rejected as a whole, and a server
+ * without NVIF_VMM_V0_BIND gets the operations one at a time.
+ */
+static void
+bench_check(struct nvif_vmm *vmm, struct nvif_mem *mem, int pages)
+{
+	static const int perm[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+	struct nvif_vmm_bind bind[8];
+	struct nvif_vma vma;
+	u64 empty;
+	int i;
+
+	assert(!nvif_vmm_get(vmm, PTES, false, 12, 0, 8 << 12, &vma));
+	empty = bench_ptes();
+
+	bench_ops(bind, perm, 8, NVIF_VMM_BIND_MAP, vma.addr, mem, pages, 0);
+	bind[5].type = 3;
+	assert(nvif_vmm_bind(vmm, bind, 8, NULL, 0) == -ECANCELED);
+	for (i = 0; i < 8; i++)
+		assert(bind[i].ret == (i == 5 ? -EINVAL : -ECANCELED));
+	assert(bench_ptes() == empty);
+
+	bench_ops(bind, perm, 8, NVIF_VMM_BIND_REMAP, vma.addr, mem, pages, 0);
+	assert(nvif_vmm_bind(vmm, bind, 8, NULL, 0) == -EINVAL);
+	for (i = 0; i < 8; i++)
+		assert(bind[i].ret == -EINVAL);
+	assert(bench_ptes() == empty);
+
+	bench.nobind = true;
+	bench.ioctls = 0;
+	bench_ops(bind, perm, 8, NVIF_VMM_BIND_MAP, vma.addr, mem, pages, 0);
+	assert(nvif_vmm_bind(vmm, bind, 8, NULL, 0) == 0);
+	assert(bench.ioctls == 1 + 8);
+	bench_ops(bind, perm, 8, NVIF_VMM_BIND_REMAP, vma.addr, mem, pages, 1);
+	assert(nvif_vmm_bind(vmm, bind, 8, NULL, 0) == 0);
+	bench_ops(bind, perm, 8, NVIF_VMM_BIND_UNMAP, vma.addr, NULL, pages, 0);
+	assert(nvif_vmm_bind(vmm, bind, 8, NULL, 0) == 0);
+	bench.nobind = false;
+	assert(bench_ptes() == empty);
+
+	nvif_vmm_put(vmm, &vma);
+}
+
+int
+main(int argc, char **argv)
+{
+	static const struct {
+		u8 type;
+		u8 heap;
+	} types[] = {
+		{ NVIF_MEM_HOST | NVIF_MEM_MAPPABLE | NVIF_MEM_COHERENT, 0 },
+	};
+	struct device dev = { .name = "bench", .dma_virt = true };
+	struct nvkm_device device = { .dev = &dev, .dbgopt = "fatal" };
+	struct nvif_client client = {};
+	struct nvif_mmu nvif_mmu = {};
+	struct nvif_vmm vmm;
+	struct nvif_mem mem;
+	struct nvkm_instmem *imem;
+	struct nvkm_mmu *mmu;
+	struct nvkm_subdev *subdev;
+	struct nvkm_object *object;
+	int pages = 4096, max = 100000, ret, c, nr;
+
+	bench.flush_ns = 1000;
+	while ((c = getopt(argc, argv, "f:m:")) != -1) {
+		switch (c) {
+		case 'f': bench.flush_ns = strtol(optarg, NULL, 0); break;
+		case 'm': max = strtol(optarg, NULL, 0); break;
+		default:
+			return 1;
+		}
+	}
+
+	if (max < 1 || bench.flush_ns < 0)
+		return 1;
+
+	if (!(imem = kzalloc(sizeof(*imem), GFP_KERNEL)))
+		return -ENOMEM;
+	nvkm_instmem_ctor(&bench_instmem, &device, NVKM_SUBDEV_INSTMEM, imem);
+	device.imem = imem;
+
+	if (!(mmu = kzalloc(sizeof(*mmu), GFP_KERNEL)))
+		return -ENOMEM;
+	nvkm_mmu_ctor(&bench_mmu, &device, NVKM_SUBDEV_MMU, mmu);
+	mmu->heap_nr = 1;
+	mmu->heap[0].type = NVKM_MEM_HOST;
+	mmu->heap[0].size = ~0ULL;
+	mmu->type_nr = 1;
+	mmu->type[0].type = NVKM_MEM_HOST | NVKM_MEM_MAPPABLE |
+			    NVKM_MEM_COHERENT;
+	mmu->type[0].heap = 0;
+	bench.ummu.mmu = mmu;
+
+	ret = nvkm_client_new("bench", ~0ULL, NULL, "fatal", NULL,
+			      &bench.client);
+	if (ret)
+		return ret;
+	bench.client->super = true;
+
+	client.object.client = &client;
+	client.object.name = "benchClient";
+	client.driver = &bench_driver;
+	client.super = true;
+	nvif_mmu.object.client = &client;
+	nvif_mmu.mem = NVIF_CLASS_MEM_GF100;
+	nvif_mmu.type_nr = ARRAY_SIZE(types);
+	nvif_mmu.type = (void *)types;
+
+	ret = nvif_vmm_ctor(&nvif_mmu, "benchVmm", NVIF_CLASS_VMM_GF100, false,
+			    0, 1ULL << 40, NULL, 0, &vmm);
+	if (ret)
+		return ret;
+
+	ret = nvif_mem_ctor_type(&nvif_mmu, "benchMem", NVIF_CLASS_MEM_GF100,
+				 0, 12, (u64)pages << 12, NULL, 0, &mem);
+	if (ret)
+		return ret;
+
+	bench_check(&vmm, &mem, pages);
+
+	printf("%7s %-6s %-6s %8s %8s %10s %8s\n", "ranges", "mode", "op",
+	       "ioctls", "flushes", "time(us)", "ns/range");
+	for (nr = 1000; nr <= max; nr *= 10)
+		bench_bind(&vmm, &mem, pages, nr);
+
+	nvif_mem_dtor(&mem);
+	nvif_vmm_dtor(&vmm);
+	object = &bench.client->object;
+	nvkm_object_del(&object);
+
+	/* Page tables freed by the VMM are cached, not released. */
+	nvkm_mmu_ptc_dump(mmu);
+	subdev = &mmu->subdev;
+	nvkm_subdev_del(&subdev);
+	subdev = &imem->subdev;
+	nvkm_subdev_del(&subdev);
+	return 0;
+}
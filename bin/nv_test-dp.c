@@ -0,0 +1,189 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "../drm/nouveau/nvkm/engine/disp/dp.c"
+#include "../drm/nouveau/nvkm/subdev/i2c/aux.h"
+
+/* Trains a DP output against a scripted sink behind a fake AUX channel.
+ * The sink advertises 4 lanes, but only trains with up to "lanes" of them,
+ * and only once the source is driving at least "swing".  Every AUX
+ * transaction is counted, so the cost of each training attempt can be
+ * compared between a cold cache and a warm one.
+ */
+static struct {
+	u8 dpcd[0x1000];
+	int lanes;
+	int swing;
+	int xfers;
+} sink;
+
+static void
+sink_status(void)
+{
+	u8 *dpcd = sink.dpcd;
+	int nr = dpcd[DPCD_LC01] & DPCD_LC01_LANE_COUNT_SET;
+	int tp = dpcd[DPCD_LC02] & DPCD_LC02_TRAINING_PATTERN_SET;
+	bool align = tp >= 2;
+	int i;
+
+	memset(&dpcd[DPCD_LS02], 0x00, 6);
+	for (i = 0; i < nr; i++) {
+		int vsw = dpcd[DPCD_LC03(i)] & DPCD_LC03_VOLTAGE_SWING_SET;
+		u8 lane = 0, adj = min(vsw + 1, sink.swing);
+
+		if (nr <= sink.lanes && vsw >= sink.swing) {
+			lane |= DPCD_LS02_LANE0_CR_DONE;
+			if (tp >= 2) {
+				lane |= DPCD_LS02_LANE0_CHANNEL_EQ_DONE |
+					DPCD_LS02_LANE0_SYMBOL_LOCKED;
+			}
+			adj = vsw;
+		} else {
+			align = false;
+		}
+
+		dpcd[DPCD_LS02 + (i >> 1)] |= lane << ((i & 1) * 4);
+		dpcd[DPCD_LS06 + (i >> 1)] |= adj << ((i & 1) * 4);
+	}
+
+	if (align)
+		dpcd[DPCD_LS04] |= DPCD_LS04_INTERLANE_ALIGN_DONE;
+}
+
+static int
+sink_xfer(struct nvkm_i2c_aux *aux, bool retry, u8 type,
+	  u32 addr, u8 *data, u8 *size)
+{
+	sink.xfers++;
+	switch (type) {
+	case 8:
+		memcpy(&sink.dpcd[addr], data, *size);
+		break;
+	case 9:
+		sink_status();
+		memcpy(data, &sink.dpcd[addr], *size);
+		break;
+	default:
+		return -EINVAL;
+	}
+	return 0;
+}
+
+static const struct nvkm_i2c_aux_func
+sink_aux = {
+	.xfer = sink_xfer,
+};
+
+static const struct nvkm_i2c_pad_func
+sink_pad = {
+};
+
+static int
+ior_links(struct nvkm_ior *ior, struct nvkm_i2c_aux *aux)
+{
+	return 0;
+}
+
+static void ior_power(struct nvkm_ior *ior, int nr) {}
+static void ior_pattern(struct nvkm_ior *ior, int pattern) {}
+
+static const struct nvkm_ior_func
+ior_func = {
+	.dp.links = ior_links,
+	.dp.power = ior_power,
+	.dp.pattern = ior_pattern,
+};
+
+static int
+train(struct nvkm_dp *dp, const char *name, u8 bw, u8 nr)
+{
+	int ret;
+
+	sink.xfers = 0;
+	ret = nvkm_dp_train(dp, 100000);
+	printf("%-10s: %d x %d MB/s, %3d AUX transactions\n", name,
+	       dp->outp.ior->dp.nr, dp->outp.ior->dp.bw * 27, sink.xfers);
+	assert(ret == 0);
+	assert(dp->outp.ior->dp.bw == bw);
+	assert(dp->outp.ior->dp.nr == nr);
+	return sink.xfers;
+}
+
+static void
+plug(struct nvkm_dp *dp, u8 oui)
+{
+	sink.dpcd[DPCD_SI00_IEEE_OUI] = oui;
+	nvkm_dp_enable(dp, false);
+	assert(nvkm_dp_enable(dp, true));
+}
+
+int
+main(int argc, char **argv)
+{
+	struct nvkm_device device = { .chipset = 0x140 };
+	struct nvkm_bios bios = {};
+	struct nvkm_i2c i2c = { .subdev.device = &device };
+	struct nvkm_disp disp = { .engine.subdev.device = &device };
+	struct nvkm_ior ior = { .func = &ior_func, .disp = &disp };
+	struct nvkm_i2c_pad pad = { .func = &sink_pad, .i2c = &i2c };
+	struct nvkm_i2c_aux aux = { .func = &sink_aux, .pad = &pad };
+	struct nvkm_dp dp = {
+		.outp.disp = &disp,
+		.outp.ior = &ior,
+		.outp.info.dpconf.link_bw = 0x14,
+		.outp.info.dpconf.link_nr = 4,
+		.aux = &aux,
+	};
+	int cold, warm;
+
+	device.bios = &bios;
+	mutex_init(&pad.mutex);
+	mutex_init(&aux.mutex);
+	aux.enabled = true;
+
+	sink.dpcd[DPCD_RC00_DPCD_REV] = 0x12;
+	sink.dpcd[DPCD_RC01_MAX_LINK_RATE] = 0x14;
+	sink.dpcd[DPCD_RC02] = DPCD_RC02_ENHANCED_FRAME_CAP |
+			       DPCD_RC02_TPS3_SUPPORTED | 4;
+	sink.lanes = 2;
+	sink.swing = 2;
+
+	/* First training searches, retraining starts from the result. */
+	plug(&dp, 0x01);
+	cold = train(&dp, "cold", 0x14, 2);
+	warm = train(&dp, "warm", 0x14, 2);
+	assert(warm < cold);
+
+	/* A different sink on the same output needs its own search. */
+	plug(&dp, 0x02);
+	assert(train(&dp, "new sink", 0x14, 2) > warm);
+	assert(dp.ltc_nr == 2);
+
+	/* ...but the original sink is still remembered. */
+	plug(&dp, 0x01);
+	assert(train(&dp, "replug", 0x14, 2) == warm);
+
+	/* If the known-good configuration stops working, search again. */
+	sink.lanes = 1;
+	assert(train(&dp, "degraded", 0x14, 1) > cold);
+	assert(train(&dp, "recovered", 0x14, 1) < cold);
+	return 0;
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#define _GNU_SOURCE
+#include <subdev/timer.h>
+
+#include "../drm/nouveau/nvkm/engine/gr/ctxgf100.h"
+
+/* Runs gf100_gr_icmd() against a model of the ICMD interface, tracing every
+ * register access it makes, and checks that the bundles reaching the
+ * hardware match the ones in the pack, in order and with the right data,
+ * whatever the submission depth.
+ *
+ * BAR0 is an inaccessible mapping: each access faults, the handler
+ * supplies the model's value for reads, single-steps the instruction, and
+ * hands writes to the model afterwards.  This needs x86-64.
+ */
+#if defined(__x86_64__)
+#include <signal.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+#define TEST_BAR0 0x1000000
+
+static u8 *test_pri;
+static u32 test_addr;
+static bool test_write;
+
+/* ICMD model: the interface retires one queued bundle in the time each
+ * register access takes, so it keeps pace with submission and only a
+ * bundle or so is ever left to drain.
+ */
+static u32 test_data, test_queued, test_queued_max;
+static u32 *test_trace, test_trace_nr;
+static u32 test_polls;
+static bool test_enabled;
+
+u64
+nvkm_timer_read(struct nvkm_timer *tmr)
+{
+	return ktime_to_ns(ktime_get());
+}
+
+static u32
+test_rd32(u32 addr)
+{
+	switch (addr) {
+	case 0x000200:
+		return 0x00001000;
+	case 0x400700:
+		test_polls++;
+		if (test_queued)
+			test_queued--;
+		return test_queued ? 0x00000004 : 0x00000000;
+	case 0x40060c:
+		return test_queued ? 0x00000001 : 0x00000000;
+	default:
+		return 0x00000000;
+	}
+}
+
+static void
+test_wr32(u32 addr, u32 data)
+{
+	switch (addr) {
+	case 0x400200:
+		assert(test_enabled);
+		if (test_queued)
+			test_queued--;
+		test_trace[test_trace_nr++] = data;
+		test_trace[test_trace_nr++] = test_data;
+		test_queued++;
+		test_queued_max = max(test_queued_max, test_queued);
+		break;
+	case 0x400204:
+		test_data = data;
+		break;
+	case 0x400208:
+		test_enabled = !!(data & 0x80000000);
+		break;
+	default:
+		break;
+	}
+}
+
+static void
+test_segv(int sig, siginfo_t *info, void *priv)
+{
+	ucontext_t *uc = priv;
+	u8 *addr = info->si_addr;
+	u8 *page = (u8 *)((unsigned long)addr & ~0xfffUL);
+
+	assert(addr >= test_pri && addr < test_pri + TEST_BAR0);
+	test_addr = addr - test_pri;
+	test_write = !!(uc->uc_mcontext.gregs[REG_ERR] & 2);
+
+	mprotect(page, 0x1000, PROT_READ | PROT_WRITE);
+	if (!test_write)
+		*(u32 *)addr = test_rd32(test_addr);
+	uc->uc_mcontext.gregs[REG_EFL] |= 0x100;
+}
+
+static void
+test_trap(int sig, siginfo_t *info, void *priv)
+{
+	ucontext_t *uc = priv;
+	u8 *page = test_pri + (test_addr & ~0xfff);
+
+	if (test_write)
+		test_wr32(test_addr, *(u32 *)(test_pri + test_addr));
+	mprotect(page, 0x1000, PROT_NONE);
+	uc->uc_mcontext.gregs[REG_EFL] &= ~0x100;
+}
+
+/* The bundle sequence the pack describes. */
+static u32
+test_expect(const struct gf100_gr_pack *p, u32 *trace)
+{
+	const struct gf100_gr_pack *pack;
+	const struct gf100_gr_init *init;
+	u32 nr = 0, addr;
+
+	pack_for_each_init(init, pack, p) {
+		u32 next = init->addr + init->count * init->pitch;
+		for (addr = init->addr; addr < next; addr += init->pitch) {
+			trace[nr++] = addr;
+			trace[nr++] = init->data;
+		}
+	}
+
+	return nr;
+}
+
+static void
+test(struct gf100_gr *gr, const char *name, const struct gf100_gr_pack *p,
+     int depth)
+{
+	const struct gf100_gr_pack *pack;
+	const struct gf100_gr_init *init;
+	u32 *expect, nr = 0;
+	int i;
+	s64 time;
+
+	pack_for_each_init(init, pack, p)
+		nr += init->count;
+
+	test_trace = calloc(nr * 2, sizeof(*test_trace));
+	expect = calloc(nr * 2, sizeof(*expect));
+	assert(test_trace && expect);
+	nr = test_expect(p, expect);
+
+	gr->icmd_depth = depth;
+	test_trace_nr = test_polls = test_queued_max = 0;
+	time = ktime_to_us(ktime_get());
+	gf100_gr_icmd(gr, p);
+	time = ktime_to_us(ktime_get()) - time;
+
+	assert(test_trace_nr == nr);
+	for (i = 0; i < nr; i += 2) {
+		if (test_trace[i + 0] != expect[i + 0] ||
+		    test_trace[i + 1] != expect[i + 1]) {
+			printf("bundle %d: %08x %08x, expected %08x %08x\n",
+			       i / 2, test_trace[i + 0], test_trace[i + 1],
+			       expect[i + 0], expect[i + 1]);
+			assert(0);
+		}
+	}
+	assert(!test_queued && !test_enabled);
+	assert(test_queued_max <= depth);
+
+	printf("%-6s depth %2d: %5d bundles, %5d polls, %5lldus traced\n",
+	       name, depth, nr / 2, test_polls, time);
+	free(test_trace);
+	free(expect);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct device dev = { .name = "test" };
+	struct nvkm_device device = {
+		.dev = &dev,
+		.dbgopt = "fatal",
+	};
+	static const struct nvkm_subdev_func func = {};
+	struct sigaction sa = { .sa_flags = SA_SIGINFO };
+	static const int depths[] = { 1, 2, 4, 8, 16, 32 };
+	struct gf100_gr *gr;
+	int i;
+
+	test_pri = mmap(NULL, TEST_BAR0, PROT_NONE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	assert(test_pri != MAP_FAILED);
+	device.pri = (void __iomem *)test_pri;
+
+	sa.sa_sigaction = test_segv;
+	sigaction(SIGSEGV, &sa, NULL);
+	sa.sa_sigaction = test_trap;
+	sigaction(SIGTRAP, &sa, NULL);
+
+	if (!(gr = kzalloc(sizeof(*gr), GFP_KERNEL)))
+		return -ENOMEM;
+	nvkm_subdev_ctor(&func, &device, NVKM_ENGINE_GR, &gr->base.engine.subdev);
+
+	for (i = 0; i < ARRAY_SIZE(depths); i++) {
+		test(gr, "gf100", gf100_grctx_pack_icmd, depths[i]);
+		test(gr, "gk104", gk104_grctx_pack_icmd, depths[i]);
+		test(gr, "gk110", gk110_grctx_pack_icmd, depths[i]);
+	}
+
+	kfree(gr);
+	munmap(test_pri, TEST_BAR0);
+	return 0;
+}
+#else
+int
+main(int argc, char **argv)
+{
+	printf("register tracing needs x86-64, skipped\n");
+	return 0;
+}
+#endif
@@ -0,0 +1,255 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <core/memory.h>
+
+#include "../drm/nouveau/nvkm/subdev/instmem/priv.h"
+
+/* Runs instmem suspend/resume cycles against a host-memory backend,
+ * scribbling over every object between suspend and resume to model the
+ * loss of VRAM, and checks everything comes back.  Objects are a mix of
+ * page tables (CPU-only, mostly zero), context buffers and lots of small
+ * identical objects.
+ */
+struct test_instobj {
+	struct nvkm_instobj base;
+	struct nvkm_instmem *imem;
+	u32 *data;
+	u32 *copy;
+	u32 size;
+	bool slow;
+};
+#define test_instobj(p) container_of((p), struct test_instobj, base.memory)
+
+static enum nvkm_memory_target
+test_instobj_target(struct nvkm_memory *memory)
+{
+	return NVKM_MEM_TARGET_INST;
+}
+
+static u64
+test_instobj_size(struct nvkm_memory *memory)
+{
+	return test_instobj(memory)->size;
+}
+
+static u32
+test_instobj_rd32(struct nvkm_memory *memory, u64 offset)
+{
+	return test_instobj(memory)->data[offset / 4];
+}
+
+static void
+test_instobj_wr32(struct nvkm_memory *memory, u64 offset, u32 data)
+{
+	test_instobj(memory)->data[offset / 4] = data;
+}
+
+static const struct nvkm_memory_ptrs
+test_instobj_ptrs = {
+	.rd32 = test_instobj_rd32,
+	.wr32 = test_instobj_wr32,
+};
+
+static void __iomem *
+test_instobj_acquire(struct nvkm_memory *memory)
+{
+	struct test_instobj *iobj = test_instobj(memory);
+	nvkm_instobj_dirty(&iobj->base);
+	return iobj->slow ? NULL : iobj->data;
+}
+
+static void
+test_instobj_release(struct nvkm_memory *memory)
+{
+}
+
+static void *
+test_instobj_dtor(struct nvkm_memory *memory)
+{
+	struct test_instobj *iobj = test_instobj(memory);
+	nvkm_instobj_dtor(iobj->imem, &iobj->base);
+	free(iobj->data);
+	free(iobj->copy);
+	return iobj;
+}
+
+static const struct nvkm_memory_func
+test_instobj_func = {
+	.dtor = test_instobj_dtor,
+	.target = test_instobj_target,
+	.size = test_instobj_size,
+	.acquire = test_instobj_acquire,
+	.release = test_instobj_release,
+};
+
+static int
+test_instobj_new(struct nvkm_instmem *imem, u32 size, u32 align, bool zero,
+		 struct nvkm_memory **pmemory)
+{
+	struct test_instobj *iobj;
+
+	if (!(iobj = kzalloc(sizeof(*iobj), GFP_KERNEL)))
+		return -ENOMEM;
+	*pmemory = &iobj->base.memory;
+
+	nvkm_instobj_ctor(&test_instobj_func, imem, &iobj->base);
+	iobj->base.memory.ptrs = &test_instobj_ptrs;
+	iobj->imem = imem;
+	iobj->size = size;
+	iobj->data = calloc(1, size);
+	iobj->copy = calloc(1, size);
+	if (!iobj->data || !iobj->copy)
+		return -ENOMEM;
+	return 0;
+}
+
+static const struct nvkm_instmem_func
+test_instmem = {
+	.memory_new = test_instobj_new,
+	.zero = true,
+};
+
+static struct test_instobj *
+test_new(struct nvkm_device *device, bool cpu, u32 size, bool slow)
+{
+	struct nvkm_memory *memory;
+	int ret;
+
+	ret = nvkm_memory_new(device, cpu ? NVKM_MEM_TARGET_INST_CPU :
+					    NVKM_MEM_TARGET_INST,
+			      size, 0x1000, true, &memory);
+	assert(ret == 0);
+	test_instobj(memory)->slow = slow;
+	return test_instobj(memory);
+}
+
+/* Writes through the accessors, like any other user of an object would,
+ * and remembers what the object should contain.
+ */
+static void
+test_fill(struct test_instobj *iobj, u32 offset, u32 data, u32 count)
+{
+	struct nvkm_memory *memory = &iobj->base.memory;
+
+	nvkm_kmap(memory);
+	while (count--) {
+		nvkm_wo32(memory, offset, data);
+		iobj->copy[offset / 4] = data;
+		offset += 4;
+		data = data * 1103515245 + 12345;
+	}
+	nvkm_done(memory);
+}
+
+static void
+test_cycle(struct nvkm_instmem *imem, struct test_instobj **iobj, int nr,
+	   const char *name)
+{
+	int i;
+
+	assert(nvkm_subdev_fini(&imem->subdev, true) == 0);
+	for (i = 0; i < nr; i++)
+		memset(iobj[i]->data, 0xa5, iobj[i]->size);
+	assert(nvkm_subdev_init(&imem->subdev) == 0);
+
+	for (i = 0; i < nr; i++)
+		assert(!memcmp(iobj[i]->data, iobj[i]->copy, iobj[i]->size));
+
+	printf("%-6s: read %7lld clean %7lld zero %7lld shared %7lld "
+	       "stored %7lld, save %5lldus, restore %5lldus (%lld bytes)\n",
+	       name, imem->sr.read, imem->sr.clean, imem->sr.zero,
+	       imem->sr.shared, imem->sr.stored, imem->sr.save_us,
+	       imem->sr.load_us, imem->sr.written);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct device dev = { .name = "test" };
+	struct nvkm_device device = {
+		.dev = &dev,
+		.dbgopt = "fatal",
+	};
+	struct test_instobj *iobj[64 + 16 + 256];
+	struct nvkm_instmem *imem;
+	struct nvkm_subdev *subdev;
+	u64 size = 0, cpu = 0;
+	int nr = 0, i;
+
+	if (!(imem = kzalloc(sizeof(*imem), GFP_KERNEL)))
+		return -ENOMEM;
+	nvkm_instmem_ctor(&test_instmem, &device, NVKM_SUBDEV_INSTMEM, imem);
+	device.imem = imem;
+	subdev = &imem->subdev;
+	assert(nvkm_subdev_init(subdev) == 0);
+
+	/* page tables: a few live PTEs each, some through the slow path */
+	for (i = 0; i < 64; i++) {
+		iobj[nr] = test_new(&device, true, 0x8000, i % 8 == 0);
+		test_fill(iobj[nr], (i * 0x140) & 0x7ffc, 0x00000001 + i, 16);
+		cpu += iobj[nr]->size;
+		size += iobj[nr++]->size;
+	}
+
+	/* context buffers, which the GPU writes */
+	for (i = 0; i < 16; i++) {
+		iobj[nr] = test_new(&device, false, 0x10000, false);
+		test_fill(iobj[nr], 0, 0xc0de0000 + i, 0x2000);
+		size += iobj[nr++]->size;
+	}
+
+	/* small objects, most of them identical */
+	for (i = 0; i < 256; i++) {
+		iobj[nr] = test_new(&device, false, 0x20, false);
+		test_fill(iobj[nr], 0, 0x0000003d + (i % 4), 4);
+		size += iobj[nr++]->size;
+	}
+
+	printf("%d objects, %lld bytes (%lld CPU-only)\n", nr, size, cpu);
+
+	/* first cycle saves everything */
+	test_cycle(imem, iobj, nr, "first");
+	assert(imem->sr.read == size && imem->sr.clean == 0);
+	assert(imem->sr.stored < size / 2);
+	assert(imem->sr.written == size);
+
+	/* nothing touched, page tables come from the kept shadow */
+	test_cycle(imem, iobj, nr, "idle");
+	assert(imem->sr.read == size - cpu && imem->sr.clean == cpu);
+
+	/* a couple of page tables updated */
+	test_fill(iobj[3], 0x100, 0x12345678, 8);
+	test_fill(iobj[8], 0x7f00, 0x9abcdef0, 8);
+	test_cycle(imem, iobj, nr, "dirty");
+	assert(imem->sr.read == size - cpu + 2 * 0x8000);
+	assert(imem->sr.clean == cpu - 2 * 0x8000);
+
+	/* and the shadows still match after one goes away */
+	nvkm_memory_unref((struct nvkm_memory **)&iobj[3]);
+	iobj[3] = iobj[--nr];
+	test_cycle(imem, iobj, nr, "unref");
+
+	for (i = 0; i < nr; i++)
+		nvkm_memory_unref((struct nvkm_memory **)&iobj[i]);
+	nvkm_subdev_del(&subdev);
+	return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "../drm/nouveau/nvkm/subdev/clk/pllnv04.c"
+#include "../drm/nouveau/nvkm/subdev/clk/pllgt215.c"
+
+/* Sweeps a range of frequencies through the cached PLL solvers, checking
+ * that the results of both the first (miss) and second (hit) requests are
+ * bit-identical to those of the brute-force solvers.
+ */
+static const struct nvbios_pll
+test_nv04[] = {
+	{ /* single-stage, nv1x-style */
+		.refclk = 13500, .min_p = 0, .max_p = 4, .max_p_usable = 4,
+		.vco1 = { 128000, 350000, 1000, 13500, 1, 13, 1, 255 },
+	},
+	{ /* two-stage, nv4x-style */
+		.refclk = 27000, .min_p = 0, .max_p = 6, .max_p_usable = 6,
+		.vco1 = { 200000, 700000, 2000, 27000, 1, 13, 1, 255 },
+		.vco2 = { 400000, 1400000, 50000, 400000, 1, 4, 1, 31 },
+	},
+};
+
+static const struct nvbios_pll
+test_gt215[] = {
+	{
+		.refclk = 27000, .min_p = 1, .max_p = 63,
+		.vco1 = { 500000, 1500000, 5000, 27000, 1, 255, 1, 255 },
+	},
+	{
+		.refclk = 100000, .min_p = 1, .max_p = 31,
+		.vco1 = { 1000000, 2000000, 10000, 40000, 1, 20, 8, 255 },
+	},
+};
+
+static s64 time_calc, time_hit[2];
+static int tests;
+
+#define TIMED(t,f) ({ s64 _t = ktime_to_ns(ktime_get()); int _r = (f);       \
+		      (t) += ktime_to_ns(ktime_get()) - _t; _r; })
+
+static void
+test_nv04_pll(struct nvkm_subdev *subdev, struct nvbios_pll *info, u32 freq,
+	      bool two)
+{
+	int v[3][6] = {}, i;
+
+	v[0][5] = TIMED(time_calc, nv04_pll_calc_(subdev, info, freq,
+		  &v[0][0], &v[0][1], two ? &v[0][2] : NULL, &v[0][3], &v[0][4]));
+	for (i = 1; i < 3; i++) {
+		v[i][5] = TIMED(time_hit[i - 1], nv04_pll_calc(subdev, info, freq,
+			  &v[i][0], &v[i][1], two ? &v[i][2] : NULL, &v[i][3],
+			  &v[i][4]));
+		assert(!memcmp(v[0], v[i], sizeof(v[0])));
+	}
+
+	tests++;
+}
+
+static void
+test_gt215_pll(struct nvkm_subdev *subdev, struct nvbios_pll *info, u32 freq,
+	       bool frac)
+{
+	int v[3][5] = {}, i;
+
+	v[0][4] = TIMED(time_calc, gt215_pll_calc_(subdev, info, freq,
+		  &v[0][0], frac ? &v[0][1] : NULL, &v[0][2], &v[0][3]));
+	for (i = 1; i < 3; i++) {
+		v[i][4] = TIMED(time_hit[i - 1], gt215_pll_calc(subdev, info, freq,
+			  &v[i][0], frac ? &v[i][1] : NULL, &v[i][2],
+			  &v[i][3]));
+		assert(!memcmp(v[0], v[i], sizeof(v[0])));
+	}
+
+	tests++;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct nvkm_bios bios = { .version.major = 0x60, .version.chip = 0x40 };
+	struct nvkm_device device = { .bios = &bios };
+	struct nvkm_subdev subdev = { .device = &device };
+	struct nvbios_pll info;
+	u32 freq;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(test_nv04); i++) {
+		info = test_nv04[i];
+		for (freq = 20000; freq <= 800000; freq += 1250) {
+			test_nv04_pll(&subdev, &info, freq, false);
+			test_nv04_pll(&subdev, &info, freq, true);
+		}
+	}
+
+	for (i = 0; i < ARRAY_SIZE(test_gt215); i++) {
+		info = test_gt215[i];
+		for (freq = 20000; freq <= 1500000; freq += 2500) {
+			test_gt215_pll(&subdev, &info, freq, false);
+			test_gt215_pll(&subdev, &info, freq, true);
+		}
+	}
+
+	printf("%d frequencies, calc %lldns, miss %lldns, hit %lldns\n",
+	       tests, time_calc / tests, time_hit[0] / tests,
+	       time_hit[1] / tests);
+	return 0;
+}
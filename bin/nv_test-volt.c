@@ -0,0 +1,268 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "../drm/nouveau/nvkm/subdev/volt/base.c"
+
+#include <sys/stat.h>
+
+/* Compares the table-driven, cached voltage map evaluator against a direct
+ * evaluation from the VBIOS, for every id, temperature and a number of
+ * speedo values.  Synthetic v0x10 and v0x20 vmap tables are always tested,
+ * and any VBIOS images given on the command line are tested as well.
+ */
+static int
+test_map_ref(struct nvkm_volt *volt, u8 id, u8 temp)
+{
+	struct nvkm_bios *bios = volt->subdev.device->bios;
+	struct nvbios_vmap_entry info;
+	u8  ver, len;
+	u32 vmap;
+
+	vmap = nvbios_vmap_entry_parse(bios, id, &ver, &len, &info);
+	if (vmap) {
+		s64 result;
+
+		if (volt->speedo < 0)
+			return volt->speedo;
+
+		if (ver == 0x10 || (ver == 0x20 && info.mode == 0)) {
+			result  = div64_s64((s64)info.arg[0], 10);
+			result += div64_s64((s64)info.arg[1] * volt->speedo, 10);
+			result += div64_s64((s64)info.arg[2] * volt->speedo * volt->speedo, 100000);
+		} else if (ver == 0x20) {
+			switch (info.mode) {
+			case 0x1:
+				result =  ((s64)info.arg[0] * 15625) >> 18;
+				result += ((s64)info.arg[1] * volt->speedo * 15625) >> 18;
+				result += ((s64)info.arg[2] * temp * 15625) >> 10;
+				result += ((s64)info.arg[3] * volt->speedo * temp * 15625) >> 18;
+				result += ((s64)info.arg[4] * volt->speedo * volt->speedo * 15625) >> 30;
+				result += ((s64)info.arg[5] * temp * temp * 15625) >> 18;
+				break;
+			case 0x3:
+				result = (info.min + info.max) / 2;
+				break;
+			case 0x2:
+			default:
+				result = info.min;
+				break;
+			}
+		} else {
+			return -ENODEV;
+		}
+
+		result = min(max(result, (s64)info.min), (s64)info.max);
+
+		if (info.link != 0xff) {
+			int ret = test_map_ref(volt, info.link, temp);
+			if (ret < 0)
+				return ret;
+			result += ret;
+		}
+		return result;
+	}
+
+	return id ? id * 10000 : -ENODEV;
+}
+
+static int
+test_map_min_ref(struct nvkm_volt *volt, u8 id)
+{
+	struct nvkm_bios *bios = volt->subdev.device->bios;
+	struct nvbios_vmap_entry info;
+	u8  ver, len;
+
+	if (nvbios_vmap_entry_parse(bios, id, &ver, &len, &info)) {
+		if (info.link != 0xff) {
+			int ret = test_map_min_ref(volt, info.link);
+			if (ret < 0)
+				return ret;
+			info.min += ret;
+		}
+		return info.min;
+	}
+
+	return id ? id * 10000 : -ENODEV;
+}
+
+static const struct nvkm_volt_func
+test_volt = {
+};
+
+static u32 test_seed = 0x1234abcd;
+
+static u32
+test_rand(void)
+{
+	test_seed ^= test_seed << 13;
+	test_seed ^= test_seed >> 17;
+	test_seed ^= test_seed << 5;
+	return test_seed;
+}
+
+static s64 time_ref, time_miss, time_hit;
+static int tests;
+
+#define TIMED(t,f) ({ s64 _t = ktime_to_ns(ktime_get()); int _r = (f);       \
+		      (t) += ktime_to_ns(ktime_get()) - _t; _r; })
+
+static void
+test_image(const char *name, struct nvkm_bios *bios)
+{
+	static const int speedo[] = { -EINVAL, 0, 1, 1420, 1792, 2200, 4095 };
+	struct nvkm_device device = { .bios = bios };
+	struct nvkm_volt volt = {};
+	struct nvbios_vmap_entry *map;
+	int i, j, id, temp, ref;
+
+	bios->bit_offset = nvbios_findstr(bios->data, bios->size,
+					  "\xff\xb8""BIT", 5);
+	nvkm_volt_ctor(&test_volt, &device, NVKM_SUBDEV_VOLT, &volt);
+	printf("%s: vmap v%02x, %d entries\n", name, volt.map_ver, volt.map_nr);
+
+	/* Second pass evaluates directly from the VBIOS, as for a table
+	 * that failed to allocate.
+	 */
+	for (j = 0, map = volt.map; j < 2; j++, volt.map = NULL) {
+		for (i = 0; i < ARRAY_SIZE(speedo); i++) {
+			volt.speedo = speedo[i];
+			nvkm_volt_map_flush(&volt);
+
+			for (id = 0; id <= volt.map_nr + 2 && id < 0x100; id++) {
+				ref = test_map_min_ref(&volt, id);
+				assert(nvkm_volt_map_min(&volt, id) == ref);
+
+				for (temp = 0; temp < 0x100; temp++) {
+					ref = TIMED(time_ref, test_map_ref(&volt, id, temp));
+					assert(TIMED(time_miss, nvkm_volt_map(&volt, id, temp)) == ref);
+					assert(TIMED(time_hit, nvkm_volt_map(&volt, id, temp)) == ref);
+					tests++;
+				}
+			}
+		}
+	}
+
+	volt.map = map;
+	nvkm_volt_dtor(&volt.subdev);
+}
+
+static void
+test_synth(u8 ver)
+{
+	u8 data[0x1000] = { 0x55, 0xaa };
+	struct nvkm_bios bios = { .data = data, .size = sizeof(data) };
+	u32 bit = 0x100, bit_P = 0x200, vmap = 0x300;
+	u8  hdr = 0x0d, len = ver == 0x10 ? 0x14 : 0x22, cnt = 64;
+	char name[16];
+	int i, j;
+
+	memcpy(&data[bit], "\xff\xb8""BIT", 5);
+	data[bit + 9] = 6;
+	data[bit + 10] = 1;
+	data[bit + 12] = 'P';
+	data[bit + 13] = 2;
+	*(u16 *)&data[bit + 14] = 0x40;
+	*(u16 *)&data[bit + 16] = bit_P;
+	*(u32 *)&data[bit_P + 0x20] = vmap;
+
+	data[vmap + 0] = ver;
+	data[vmap + 1] = hdr;
+	data[vmap + 2] = len;
+	data[vmap + 3] = cnt;
+	data[vmap + 7] = 0;
+	data[vmap + 8] = 1;
+	data[vmap + 0xc] = 0xff;
+
+	for (i = 0; i < cnt; i++) {
+		u8 *e = &data[vmap + hdr + i * len];
+		u32 min = 500000 + test_rand() % 400000;
+		u32 max = min + test_rand() % 600000;
+		u32 *arg;
+
+		if (ver == 0x10) {
+			*(u32 *)&e[0x00] = min;
+			*(u32 *)&e[0x04] = max;
+			arg = (u32 *)&e[0x08];
+		} else {
+			/* Links only ever point forwards, and sometimes past
+			 * the end of the table.
+			 */
+			e[0x00] = test_rand() % 5;
+			e[0x01] = (test_rand() % 3) ? 0xff :
+				  i + 1 + test_rand() % 8;
+			*(u32 *)&e[0x02] = min;
+			*(u32 *)&e[0x06] = max;
+			arg = (u32 *)&e[0x0a];
+		}
+
+		for (j = 0; j < (ver == 0x10 ? 3 : 6); j++)
+			arg[j] = (s32)(test_rand() % 0x200000) - 0x100000;
+	}
+
+	snprintf(name, sizeof(name), "synthetic v%02x", ver);
+	test_image(name, &bios);
+}
+
+static int
+test_file(const char *path)
+{
+	struct nvkm_bios bios = {};
+	struct stat st;
+	FILE *file;
+
+	file = fopen(path, "rb");
+	if (!file || fstat(fileno(file), &st)) {
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		return -errno;
+	}
+
+	bios.size = st.st_size;
+	bios.image0_size = st.st_size;
+	bios.data = malloc(bios.size);
+	if (!bios.data || fread(bios.data, 1, bios.size, file) != bios.size) {
+		fclose(file);
+		free(bios.data);
+		return -EIO;
+	}
+
+	fclose(file);
+	test_image(path, &bios);
+	free(bios.data);
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	int ret, i;
+
+	test_synth(0x10);
+	test_synth(0x20);
+
+	for (i = 1; i < argc; i++) {
+		if ((ret = test_file(argv[i])))
+			return ret;
+	}
+
+	printf("%d evaluations, vbios %lldns, miss %lldns, hit %lldns\n",
+	       tests, time_ref / tests, time_miss / tests, time_hit / tests);
+	return 0;
+}
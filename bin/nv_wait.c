@@ -0,0 +1,135 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <nvif/client.h>
+#include <nvif/device.h>
+#include <nvif/cl0080.h>
+
+#include "util.h"
+
+/* Brings up a device (optionally cycling it through suspend/resume) and
+ * dumps the statistics kept for each hardware wait it ran, busiest first.
+ *
+ * -r clears the statistics: before the suspend/resume cycle with -s, so
+ * only its waits are counted, or otherwise once they've been listed.
+ */
+static int
+wait_reset(struct nvif_device *device)
+{
+	int ret = nvif_mthd(&device->object, NV_DEVICE_V0_WAIT,
+			    &(struct nv_device_wait_v0) { .reset = 1 },
+			    sizeof(struct nv_device_wait_v0));
+	if (ret)
+		fprintf(stderr, "reset: %d\n", ret);
+	return ret;
+}
+
+static int
+wait_cmp(const void *a, const void *b)
+{
+	const struct nv_device_wait_v0 *wa = a, *wb = b;
+	if (wa->time != wb->time)
+		return wa->time < wb->time ? 1 : -1;
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct nvif_client client;
+	struct nvif_device device;
+	struct nv_device_wait_v0 *wait = NULL;
+	bool reset = false, suspend = false;
+	int ret, c, i, nr = 0, max = -1;
+
+	while ((c = getopt(argc, argv, "n:rs"U_GETOPT)) != -1) {
+		switch (c) {
+		case 'n':
+			max = strtol(optarg, NULL, 0);
+			break;
+		case 'r':
+			reset = true;
+			break;
+		case 's':
+			suspend = true;
+			break;
+		default:
+			if (!u_option(c))
+				return 1;
+			break;
+		}
+	}
+
+	ret = u_device(NULL, argv[0], "error", true, true, ~0ULL,
+		       0x00000000, &client, &device);
+	if (ret)
+		return ret;
+
+	/* Only count the waits made during suspend/resume. */
+	if (suspend) {
+		if (reset && (ret = wait_reset(&device)))
+			goto done;
+		nvif_client_suspend(&client);
+		nvif_client_resume(&client);
+	}
+
+	for (;;) {
+		struct nv_device_wait_v0 *temp;
+
+		if (!(nr & (nr - 1))) {
+			temp = realloc(wait, (nr ? nr * 2 : 1) * sizeof(*wait));
+			if (!temp) {
+				ret = -ENOMEM;
+				goto done;
+			}
+			wait = temp;
+		}
+
+		memset(&wait[nr], 0x00, sizeof(wait[nr]));
+		wait[nr].index = nr;
+		if (nvif_mthd(&device.object, NV_DEVICE_V0_WAIT,
+			      &wait[nr], sizeof(wait[nr])))
+			break;
+		nr++;
+	}
+
+	qsort(wait, nr, sizeof(*wait), wait_cmp);
+
+	printf("%8s %10s %10s %10s %4s  %s\n",
+	       "calls", "reads", "total(us)", "max(us)", "tmo", "site");
+	for (i = 0; i < nr && (max < 0 || i < max); i++) {
+		if (!wait[i].calls)
+			continue;
+
+		printf("%8lld %10lld %10lld %10lld %4lld  %s:%d: %s\n",
+		       wait[i].calls, wait[i].reads, wait[i].time / 1000,
+		       wait[i].time_max / 1000, wait[i].timeouts,
+		       wait[i].file, wait[i].line, wait[i].cond);
+	}
+
+	if (reset && !suspend)
+		ret = wait_reset(&device);
+done:
+	free(wait);
+	nvif_device_dtor(&device);
+	nvif_client_dtor(&client);
+	return ret;
+}
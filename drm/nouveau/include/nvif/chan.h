@@ -0,0 +1,66 @@
+#ifndef __NVIF_CHAN_H__
+#define __NVIF_CHAN_H__
+#include <nvif/push.h>
+#include <nvif/vmm.h>
+struct nvif_device;
+
+/* Userspace submission to a Fermi+ GPFIFO channel.
+ *
+ * A single buffer holds the pushbuffer ring, the GPFIFO ring and a fence
+ * semaphore, in that order.  Methods are written through the embedded
+ * nvif_push, and each PUSH_KICK() posts what was written since the last
+ * one as a GPFIFO entry, bumps GP_PUT in USERD and rings the doorbell.
+ * None of that goes through the ioctl path once the channel is mapped.
+ *
+ * Pushbuffer space is reclaimed from the channel's GET pointer, and
+ * GPFIFO entries from GP_GET.  Fences are semaphore releases to the
+ * tail of the buffer, waited for by polling it.
+ */
+struct nvif_chan {
+	struct nvif_device *device;
+	struct nvif_object *userd;
+	u32 token;
+
+	struct nvif_push push;
+
+	struct {
+		u32 *ptr;
+		u64 addr;
+		u32 size;	/* in dwords */
+		u32 get;	/* oldest dword the GPU may still fetch */
+	} pushbuf;
+
+	struct {
+		u32 *ptr;
+		u64 addr;
+		u32 max;
+		u32 cur;
+		u32 get;
+	} gpfifo;
+
+	struct {
+		u32 *ptr;
+		u64 addr;
+		u32 seqno;
+	} fence;
+
+	/* Only used by nvif_chan_ctor_gpfifo(). */
+	struct nvif_object object;
+	struct nvif_vmm *vmm;
+	struct nvif_vma vma;
+};
+
+#define NVIF_CHAN_FENCE_SIZE 16
+
+int  nvif_chan_ctor(struct nvif_device *, const char *name,
+		    struct nvif_object *userd, u32 token, void *ptr, u64 addr,
+		    u32 push_size, u32 gpfifo_nr, struct nvif_chan *);
+int  nvif_chan_ctor_gpfifo(struct nvif_device *, struct nvif_mmu *,
+			   struct nvif_vmm *, const char *name, u64 runlist,
+			   u32 push_size, u32 gpfifo_nr, struct nvif_chan *);
+void nvif_chan_dtor(struct nvif_chan *);
+void nvif_chan_update(struct nvif_chan *);
+int  nvif_chan_fence(struct nvif_chan *, u32 *seqno);
+bool nvif_chan_fence_done(struct nvif_chan *, u32 seqno);
+int  nvif_chan_fence_wait(struct nvif_chan *, u32 seqno);
+#endif
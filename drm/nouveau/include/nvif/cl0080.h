@@ -10,6 +10,7 @@ struct nv_device_v0 {
 
 #define NV_DEVICE_V0_INFO                                                  0x00
 #define NV_DEVICE_V0_TIME                                                  0x01
+#define NV_DEVICE_V0_WAIT                                                  0x02
 
 struct nv_device_info_v0 {
 	__u8  version;
@@ -57,6 +58,27 @@ struct nv_device_time_v0 {
 	__u64 time;
 };
 
+/* Statistics for the index'th nvkm_nsec()/nvkm_wait_*() call site, in the
+ * order they were first run.  Sites are shared by all devices.  -ENOENT is
+ * returned past the last site.  If 'reset' is set, every site's statistics
+ * are cleared instead, which only a supervisor client may do.
+ */
+struct nv_device_wait_v0 {
+	__u8  version;
+	__u8  reset;
+	__u8  pad02[2];
+	__u32 index;
+	__u64 calls;
+	__u64 reads;
+	__u64 time;	/* ns */
+	__u64 time_max;	/* ns */
+	__u64 timeouts;
+	__u32 line;
+	__u8  pad34[4];
+	char  file[64];
+	char  cond[128];
+};
+
 #define NV_DEVICE_INFO_UNIT                               (0xffffffffULL << 32)
 #define NV_DEVICE_INFO(n)                          ((n) | (0x00000000ULL << 32))
 #define NV_DEVICE_FIFO(n)                          ((n) | (0x00000001ULL << 32))
@@ -11,6 +11,7 @@ struct nvif_mmu_v0 {
 #define NVIF_MMU_V0_HEAP                                                   0x00
 #define NVIF_MMU_V0_TYPE                                                   0x01
 #define NVIF_MMU_V0_KIND                                                   0x02
+#define NVIF_MMU_V0_INFO                                                   0x03
 
 struct nvif_mmu_heap_v0 {
 	__u8  version;
@@ -39,4 +40,27 @@ struct nvif_mmu_kind_v0 {
 	__u16 count;
 	__u8  data[];
 };
+
+/* Everything HEAP/TYPE/KIND return, in one call.  'data' holds heap_nr
+ * heap sizes (__u64), then type_nr (heap, flags) byte pairs, then kind_nr
+ * kind bytes.  The counts must be those returned by the constructor.
+ */
+struct nvif_mmu_info_v0 {
+	__u8  version;
+	__u8  heap_nr;
+	__u8  type_nr;
+	__u8  kind_inv;
+	__u16 kind_nr;
+	__u8  pad06[2];
+	__u8  data[];
+};
+
+#define NVIF_MMU_INFO_V0_TYPE_VRAM                                         0x01
+#define NVIF_MMU_INFO_V0_TYPE_HOST                                         0x02
+#define NVIF_MMU_INFO_V0_TYPE_COMP                                         0x04
+#define NVIF_MMU_INFO_V0_TYPE_DISP                                         0x08
+#define NVIF_MMU_INFO_V0_TYPE_KIND                                         0x10
+#define NVIF_MMU_INFO_V0_TYPE_MAPPABLE                                     0x20
+#define NVIF_MMU_INFO_V0_TYPE_COHERENT                                     0x40
+#define NVIF_MMU_INFO_V0_TYPE_UNCACHED                                     0x80
 #endif
@@ -17,6 +17,7 @@ struct nvif_vmm_v0 {
 #define NVIF_VMM_V0_UNMAP                                                  0x04
 #define NVIF_VMM_V0_PFNMAP                                                 0x05
 #define NVIF_VMM_V0_PFNCLR                                                 0x06
+#define NVIF_VMM_V0_BIND                                                   0x07
 #define NVIF_VMM_V0_MTHD(i)                                         ((i) + 0x80)
 
 struct nvif_vmm_page_v0 {
@@ -89,4 +90,23 @@ struct nvif_vmm_pfnclr_v0 {
 	__u64 addr;
 	__u64 size;
 };
+
+struct nvif_vmm_bind_v0 {
+	__u8  version;
+	__u8  pad01[3];
+	__u32 count;
+	struct nvif_vmm_bind_op_v0 {
+#define NVIF_VMM_BIND_V0_MAP                                               0x00
+#define NVIF_VMM_BIND_V0_UNMAP                                             0x01
+#define NVIF_VMM_BIND_V0_REMAP                                             0x02
+		__u8  op;
+		__u8  pad01[3];
+		__s32 status;
+		__u64 addr;
+		__u64 size;
+		__u64 memory;
+		__u64 offset;
+	} op[];
+	/* followed by map arguments, shared by all MAP/REMAP ops */
+};
 #endif
@@ -5,6 +5,7 @@
 #include <linux/types.h>
 #include <linux/slab.h>
 #include <linux/mutex.h>
+#include <linux/rwsem.h>
 #include <linux/pci.h>
 #include <linux/platform_device.h>
 #include <linux/printk.h>
@@ -21,6 +22,7 @@
 #include <linux/reboot.h>
 #include <linux/interrupt.h>
 #include <linux/log2.h>
+#include <linux/hash.h>
 #include <linux/pm_runtime.h>
 #include <linux/power_supply.h>
 #include <linux/clk.h>
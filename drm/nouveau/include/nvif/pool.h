@@ -0,0 +1,52 @@
+#ifndef __NVIF_POOL_H__
+#define __NVIF_POOL_H__
+#include <nvif/mem.h>
+#include <nvif/vmm.h>
+
+/* Suballocator for small buffers.  Objects are carved out of power-of-two
+ * size classes in slabs, each of which is a single nvif_mem mapped once
+ * into the VMM (and the CPU, for MAPPABLE types).  A pool hands out one
+ * memory type, so clients keep a pool per type they need.
+ *
+ * Slabs that become empty are kept for reuse by any size class, up to
+ * 'empty_max' of them, and otherwise released.
+ */
+#define NVIF_POOL_SHIFT_MIN 8
+#define NVIF_POOL_SHIFT_MAX 16
+#define NVIF_POOL_CLASS_NR (NVIF_POOL_SHIFT_MAX - NVIF_POOL_SHIFT_MIN + 1)
+
+struct nvif_pool {
+	struct nvif_mmu *mmu;
+	struct nvif_vmm *vmm;
+	const char *name;
+	u8  type;
+	u8  page;
+	u32 slab_size;
+
+	struct mutex mutex;
+	struct list_head part[NVIF_POOL_CLASS_NR];
+	struct list_head full;
+	struct list_head empty;
+	int empty_nr;
+	int empty_max;
+	int slab_nr;
+};
+
+struct nvif_pool_slab;
+
+struct nvif_pool_alloc {
+	struct nvif_pool_slab *slab;
+	struct nvif_mem *mem;
+	u64 offset;	/* within 'mem' */
+	u64 addr;	/* GPU virtual address */
+	void *ptr;	/* CPU virtual address, NULL unless MAPPABLE */
+	u32 size;
+};
+
+int  nvif_pool_ctor(struct nvif_mmu *, struct nvif_vmm *, const char *name,
+		    u8 type, u8 page, u32 slab_size, struct nvif_pool *);
+void nvif_pool_dtor(struct nvif_pool *);
+int  nvif_pool_get(struct nvif_pool *, u32 size, struct nvif_pool_alloc *);
+void nvif_pool_put(struct nvif_pool *, struct nvif_pool_alloc *);
+void nvif_pool_trim(struct nvif_pool *);
+#endif
@@ -15,6 +15,21 @@ struct nvif_vma {
 	u64 size;
 };
 
+enum nvif_vmm_bind_type {
+	NVIF_VMM_BIND_MAP,
+	NVIF_VMM_BIND_UNMAP,
+	NVIF_VMM_BIND_REMAP,
+};
+
+struct nvif_vmm_bind {
+	enum nvif_vmm_bind_type type;
+	u64 addr;
+	u64 size;
+	struct nvif_mem *mem;
+	u64 offset;
+	int ret;
+};
+
 struct nvif_vmm {
 	struct nvif_object object;
 	u64 start;
@@ -39,4 +54,6 @@ void nvif_vmm_put(struct nvif_vmm *, struct nvif_vma *);
 int nvif_vmm_map(struct nvif_vmm *, u64 addr, u64 size, void *argv, u32 argc,
 		 struct nvif_mem *, u64 offset);
 int nvif_vmm_unmap(struct nvif_vmm *, u64);
+int nvif_vmm_bind(struct nvif_vmm *, struct nvif_vmm_bind *, int nr,
+		  void *argv, u32 argc);
 #endif
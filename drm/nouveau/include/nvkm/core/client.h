@@ -11,10 +11,15 @@ struct nvkm_client {
 	u32 debug;
 
 	struct nvkm_client_notify *notify[32];
+	struct rw_semaphore objlock;
 	struct rb_root objroot;
+	struct {
+		struct nvkm_object **slot;
+		u32 bits;
+		u32 nr;
+	} objhash;
 
 	bool super;
-	void *data;
 	int (*ntfy)(const void *, u32, const void *, u32);
 
 	struct list_head umem;
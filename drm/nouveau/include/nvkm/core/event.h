@@ -13,7 +13,10 @@ struct nvkm_event {
 
 	spinlock_t refs_lock;
 	spinlock_t list_lock;
-	struct list_head list;
+	struct nvkm_event_index {
+		struct list_head list;
+		u32 types;
+	} *index;
 	int *refs;
 };
 
@@ -32,4 +35,6 @@ void nvkm_event_get(struct nvkm_event *, u32 types, int index);
 void nvkm_event_put(struct nvkm_event *, u32 types, int index);
 void nvkm_event_send(struct nvkm_event *, u32 types, int index,
 		     void *data, u32 size);
+void nvkm_event_ntfy_add(struct nvkm_event *, struct nvkm_notify *);
+void nvkm_event_ntfy_del(struct nvkm_event *, struct nvkm_notify *);
 #endif
@@ -16,6 +16,7 @@ enum nvkm_memory_target {
 	NVKM_MEM_TARGET_VRAM, /* video memory */
 	NVKM_MEM_TARGET_HOST, /* coherent system memory */
 	NVKM_MEM_TARGET_NCOH, /* non-coherent system memory */
+	NVKM_MEM_TARGET_INST_CPU, /* instance memory, never written by GPU */
 };
 
 struct nvkm_memory {
@@ -100,6 +101,16 @@ void nvkm_memory_tags_put(struct nvkm_memory *, struct nvkm_device *,
 	}                                                                      \
 } while(0)
 
+#define nvkm_wblk(o,a,p,s) do {                                                \
+	u64 _a = (a), _s = (s);                                                \
+	u8 __iomem *_m = nvkm_kmap(o);                                         \
+	if (likely(_m))                                                        \
+		memcpy_toio(&_m[_a], (p), _s);                                 \
+	else                                                                   \
+		nvkm_wobj((o), _a, (p), _s);                                   \
+	nvkm_done(o);                                                          \
+} while(0)
+
 #define nvkm_fill(t,s,o,a,d,c) do {                                            \
 	u64 _a = (a), _c = (c), _d = (d), _o = _a >> s, _s = _c << s;          \
 	u##t __iomem *_m = nvkm_kmap(o);                                       \
@@ -8,6 +8,7 @@ struct nvkm_ramht_data {
 	struct nvkm_gpuobj *inst;
 	int chid;
 	u32 handle;
+	u32 context;
 };
 
 struct nvkm_ramht {
@@ -16,6 +17,15 @@ struct nvkm_ramht {
 	struct nvkm_gpuobj *gpuobj;
 	int size;
 	int bits;
+
+	/* host-side (chid, handle) -> slot index, never read from instmem */
+	struct {
+		int *slot;
+		int mask;
+		int used;
+		int dead;
+	} index;
+
 	struct nvkm_ramht_data data[];
 };
 
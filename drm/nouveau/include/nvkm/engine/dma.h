@@ -19,6 +19,10 @@ struct nvkm_dmaobj {
 struct nvkm_dma {
 	const struct nvkm_dma_func *func;
 	struct nvkm_engine engine;
+
+	/* contexts bound outside of any parent gpuobj, shared by all users */
+	struct mutex mutex;
+	struct list_head ctx;
 };
 
 struct nvkm_dmaobj *nvkm_dmaobj_search(struct nvkm_client *, u64 object);
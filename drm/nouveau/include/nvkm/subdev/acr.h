@@ -54,6 +54,15 @@ struct nvkm_acr {
 	const struct firmware *wpr_fw;
 	bool wpr_comp;
 	u64 wpr_prev;
+
+	/* Time spent (ns) in each phase of secure boot preparation. */
+	struct {
+		s64 lsfw;
+		s64 layout;
+		s64 build;
+		s64 upload;
+		s64 hsfw;
+	} time;
 };
 
 bool nvkm_acr_managed_falcon(struct nvkm_device *, enum nvkm_acr_lsf_id);
@@ -3,6 +3,14 @@
 #define __NVKM_BIOS_H__
 #include <core/subdev.h>
 
+struct nvbios_index_table {
+	u32 data;
+	u8  ver;
+	u8  hdr;
+	u8  cnt;
+	u8  len;
+};
+
 struct nvkm_bios {
 	struct nvkm_subdev subdev;
 	u32 size;
@@ -21,8 +29,47 @@ struct nvkm_bios {
 		u8 micro;
 		u8 patch;
 	} version;
+
+	/*
+	 * Locations of frequently used tables, and of the entries within
+	 * them, found once after shadowing so that the parsers don't need
+	 * to walk the image on every lookup.
+	 */
+	struct {
+		bool valid;
+		struct {
+			u8  id;
+			u8  version;
+			u16 length;
+			u16 offset;
+		} bit[0x80];
+		struct nvbios_index_table dcb;
+		struct nvbios_index_table gpio;
+		u8  gpio_func[0x100];
+		struct nvbios_index_table pll;
+		struct {
+			u8  type;
+			u32 reg;
+		} pll_map[32];
+		struct nvbios_index_table perf;
+		u8  perf_snr;
+		u8  perf_ssz;
+		struct nvbios_index_table vmap;
+		struct nvbios_index_table volt;
+	} index;
 };
 
+static inline u32
+nvbios_index_table(const struct nvbios_index_table *table,
+		   u8 *ver, u8 *hdr, u8 *cnt, u8 *len)
+{
+	*ver = table->ver;
+	*hdr = table->hdr;
+	*cnt = table->cnt;
+	*len = table->len;
+	return table->data;
+}
+
 u8  nvbios_checksum(const u8 *data, int size);
 u16 nvbios_findstr(const u8 *data, int size, const char *str, int len);
 int nvbios_memcmp(struct nvkm_bios *, u32 addr, const char *, u32 len);
@@ -72,5 +72,6 @@ struct nvbios_pll {
 	} vco1, vco2;
 };
 
+u32 nvbios_pll_table(struct nvkm_bios *, u8 *ver, u8 *hdr, u8 *cnt, u8 *len);
 int nvbios_pll_parse(struct nvkm_bios *, u32 type, struct nvbios_pll *);
 #endif
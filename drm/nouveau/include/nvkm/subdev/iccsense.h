@@ -12,8 +12,16 @@ struct nvkm_iccsense {
 
 	u32 power_w_max;
 	u32 power_w_crit;
+
+	/* last sample, served to readers until it's 'period' ns old */
+	struct mutex mutex;
+	struct i2c_msg *msg;
+	u64 period;
+	u64 time;
+	int power;
 };
 
 int gf100_iccsense_new(struct nvkm_device *, int index, struct nvkm_iccsense **);
 int nvkm_iccsense_read_all(struct nvkm_iccsense *iccsense);
+int nvkm_iccsense_sample(struct nvkm_iccsense *iccsense);
 #endif
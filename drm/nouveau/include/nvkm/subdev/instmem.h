@@ -13,6 +13,20 @@ struct nvkm_instmem {
 	struct list_head boot;
 	u32 reserved;
 
+	/* suspend/resume shadow pages, and stats for the last cycle */
+	struct list_head *pages;
+	bool suspended;
+	struct {
+		u64 read;
+		u64 clean;
+		u64 zero;
+		u64 shared;
+		u64 stored;
+		u64 written;
+		s64 save_us;
+		s64 load_us;
+	} sr;
+
 	struct nvkm_memory *vbios;
 	struct nvkm_ramht  *ramht;
 	struct nvkm_memory *ramro;
@@ -22,7 +36,7 @@ struct nvkm_instmem {
 u32 nvkm_instmem_rd32(struct nvkm_instmem *, u32 addr);
 void nvkm_instmem_wr32(struct nvkm_instmem *, u32 addr, u32 data);
 int nvkm_instobj_new(struct nvkm_instmem *, u32 size, u32 align, bool zero,
-		     struct nvkm_memory **);
+		     bool cpu, struct nvkm_memory **);
 
 
 int nv04_instmem_new(struct nvkm_device *, int, struct nvkm_instmem **);
@@ -32,6 +32,11 @@ struct nvkm_pmu {
 		u32 message;
 		u32 data[2];
 	} recv;
+
+	struct {
+		struct mutex mutex;
+		struct list_head cache;
+	} memx;
 };
 
 int nvkm_pmu_send(struct nvkm_pmu *, u32 reply[2], u32 process,
@@ -55,6 +60,10 @@ int gp10b_pmu_new(struct nvkm_device *, int, struct nvkm_pmu **);
 /* interface to MEMX process running on PMU */
 struct nvkm_memx;
 int  nvkm_memx_init(struct nvkm_pmu *, struct nvkm_memx **);
+int  nvkm_memx_cached(struct nvkm_pmu *, u32 from, u32 to, u32 band,
+		      struct nvkm_memx **);
+void nvkm_memx_key(struct nvkm_memx *, u32 from, u32 to, u32 band);
+void nvkm_memx_input(struct nvkm_memx *, u32 addr, u32 data);
 int  nvkm_memx_fini(struct nvkm_memx **, bool exec);
 void nvkm_memx_wr32(struct nvkm_memx *, u32 addr, u32 data);
 void nvkm_memx_wait(struct nvkm_memx *, u32 addr, u32 mask, u32 data, u32 nsec);
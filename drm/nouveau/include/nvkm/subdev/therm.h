@@ -56,6 +56,11 @@ struct nvkm_therm_clkgate_pack {
 	const struct nvkm_therm_clkgate_init *init;
 };
 
+struct nvkm_therm_sample {
+	u64 time;
+	int value;
+};
+
 struct nvkm_therm {
 	const struct nvkm_therm_func *func;
 	struct nvkm_subdev subdev;
@@ -81,6 +86,17 @@ struct nvkm_therm {
 		enum nvkm_therm_thrs_state alarm_state[NVKM_THERM_THRS_NR];
 	} sensor;
 
+	/* sensor polling, temperature/fan/power share one time base */
+	struct {
+		struct nvkm_alarm alarm;
+		struct work_struct work;
+		spinlock_t lock;
+		bool enabled;
+		u32 period;
+		struct nvkm_therm_sample temp;
+		struct nvkm_therm_sample fan;
+	} sample;
+
 	/* what should be done if the card overheats */
 	struct {
 		void (*downclock)(struct nvkm_therm *, bool active);
@@ -101,6 +117,7 @@ struct nvkm_therm {
 
 int nvkm_therm_temp_get(struct nvkm_therm *);
 int nvkm_therm_fan_sense(struct nvkm_therm *);
+void nvkm_therm_sample(struct nvkm_therm *);
 int nvkm_therm_cstate(struct nvkm_therm *, int, int);
 void nvkm_therm_clkgate_init(struct nvkm_therm *,
 			     const struct nvkm_therm_clkgate_pack *);
@@ -28,17 +28,42 @@ struct nvkm_timer {
 u64 nvkm_timer_read(struct nvkm_timer *);
 void nvkm_timer_alarm(struct nvkm_timer *, u32 nsec, struct nvkm_alarm *);
 
+/* Every nvkm_nsec() expansion has one of these, which is added to a global
+ * registry the first time the wait runs.  Times are in PTIMER nanoseconds,
+ * and "reads" counts evaluations of the condition.  The counters are only
+ * ever updated atomically, so waits don't serialise on the registry lock.
+ */
+struct nvkm_timer_site {
+	const char *file;
+	const char *cond;
+	int line;
+	struct list_head head;
+	atomic_t registered;
+
+	atomic64_t calls;
+	atomic64_t reads;
+	atomic64_t time;
+	atomic64_t time_max;
+	atomic64_t timeouts;
+};
+
 struct nvkm_timer_wait {
 	struct nvkm_timer *tmr;
+	struct nvkm_timer_site *site;
 	u64 limit;
 	u64 time0;
 	u64 time1;
 	int reads;
+	u32 tests;
 };
 
 void nvkm_timer_wait_init(struct nvkm_device *, u64 nsec,
-			  struct nvkm_timer_wait *);
+			  struct nvkm_timer_site *, struct nvkm_timer_wait *);
 s64 nvkm_timer_wait_test(struct nvkm_timer_wait *);
+void nvkm_timer_wait_fini(struct nvkm_timer_wait *, s64 taken, bool warn);
+
+int nvkm_timer_site(int index, struct nvkm_timer_site *);
+void nvkm_timer_site_reset(void);
 
 /* Delay based on GPU time (ie. PTIMER).
  *
@@ -50,17 +75,20 @@ s64 nvkm_timer_wait_test(struct nvkm_timer_wait *);
  */
 #define NVKM_DELAY _warn = false;
 #define nvkm_nsec(d,n,cond...) ({                                              \
+	static struct nvkm_timer_site _site = { __FILE__, #cond, __LINE__ };   \
 	struct nvkm_timer_wait _wait;                                          \
 	bool _warn = true;                                                     \
 	s64 _taken = 0;                                                        \
                                                                                \
-	nvkm_timer_wait_init((d), (n), &_wait);                                \
+	nvkm_timer_wait_init((d), (n), &_site, &_wait);                        \
 	do {                                                                   \
 		cond                                                           \
 	} while ((_taken = nvkm_timer_wait_test(&_wait)) >= 0);                \
                                                                                \
+	nvkm_timer_wait_fini(&_wait, _taken, _warn);                           \
 	if (_warn && _taken < 0)                                               \
-		dev_WARN(_wait.tmr->subdev.device->dev, "timeout\n");          \
+		dev_WARN(_wait.tmr->subdev.device->dev, "timeout at %s:%d\n", \
+			 __FILE__, __LINE__);                                  \
 	_taken;                                                                \
 })
 #define nvkm_usec(d, u, cond...) nvkm_nsec((d), (u) * 1000ULL, ##cond)
@@ -7,6 +7,19 @@ struct nvkm_top {
 	const struct nvkm_top_func *func;
 	struct nvkm_subdev subdev;
 	struct list_head device;
+
+	/* lookup tables, built from 'device' at oneinit */
+	struct {
+		u32 addr;
+		u32 reset;
+		u32 intr;
+		int fault;
+	} index[NVKM_SUBDEV_NR + 1];
+	enum nvkm_devidx fault[128];
+	struct nvkm_top_device *engine[64];
+	int engine_nr;
+	u64 intr[32];
+	u32 intr_mask;
 };
 
 u32 nvkm_top_addr(struct nvkm_device *, enum nvkm_devidx);
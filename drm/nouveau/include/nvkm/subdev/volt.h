@@ -2,6 +2,7 @@
 #ifndef __NVKM_VOLT_H__
 #define __NVKM_VOLT_H__
 #include <core/subdev.h>
+struct nvbios_vmap_entry;
 
 struct nvkm_volt {
 	const struct nvkm_volt_func *func;
@@ -28,6 +29,25 @@ struct nvkm_volt {
 	u8 max2_id;
 
 	int speedo;
+
+	/* VBIOS voltage map entries, parsed once at construction time. */
+	struct nvbios_vmap_entry *map;
+	u8 map_ver;
+	u8 map_nr;
+
+	/*
+	 * Recently evaluated voltage map results, keyed by (id, temperature).
+	 * Flushed whenever the speedo value changes.
+	 */
+	struct {
+		spinlock_t lock;
+		struct {
+			bool valid;
+			u8 id;
+			u8 temp;
+			int uv;
+		} entry[64];
+	} map_cache;
 };
 
 int nvkm_volt_map(struct nvkm_volt *volt, u8 id, u8 temperature);
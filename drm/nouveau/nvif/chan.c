@@ -0,0 +1,428 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <nvif/chan.h>
+#include <nvif/class.h>
+#include <nvif/device.h>
+#include <nvif/mmu.h>
+#include <nvif/timer.h>
+
+#include <nvif/cl906f.h>
+#include <nvif/cla06f.h>
+#include <nvif/clc36f.h>
+#include <nvif/push906f.h>
+
+#include <nvhw/class/cl906f.h>
+
+/* USERD, common to all GPFIFO classes from Fermi onwards. */
+#define NVIF_CHAN_USERD_GET    0x44
+#define NVIF_CHAN_USERD_GET_HI 0x60
+#define NVIF_CHAN_USERD_GP_GET 0x88
+#define NVIF_CHAN_USERD_GP_PUT 0x8c
+
+static u32
+nvif_chan_gpfifo_free(struct nvif_chan *chan)
+{
+	return (chan->gpfifo.get - chan->gpfifo.cur - 1) & chan->gpfifo.max;
+}
+
+/* Refreshes GP_GET, and moves pushbuf.get forward to wherever GET is
+ * within what's been posted.  GP_GET can't be used for the latter, as
+ * host fetches GPFIFO entries ahead of the pushbuffer data they point at.
+ */
+void
+nvif_chan_update(struct nvif_chan *chan)
+{
+	u32 bgn = chan->push.bgn - chan->pushbuf.ptr;
+	u32 get = chan->pushbuf.get;
+	u32 lo, hi, off;
+	u64 addr;
+
+	chan->gpfifo.get = nvif_rd32(chan->userd, NVIF_CHAN_USERD_GP_GET) &
+			   chan->gpfifo.max;
+	if (get == bgn)
+		return;
+
+	do {
+		hi = nvif_rd32(chan->userd, NVIF_CHAN_USERD_GET_HI);
+		lo = nvif_rd32(chan->userd, NVIF_CHAN_USERD_GET);
+	} while (hi != nvif_rd32(chan->userd, NVIF_CHAN_USERD_GET_HI));
+
+	addr = (u64)(hi & 0x000000ff) << 32 | lo;
+	if (addr < chan->pushbuf.addr ||
+	    addr >= chan->pushbuf.addr + chan->pushbuf.size * 4)
+		return;
+
+	off = (addr - chan->pushbuf.addr) >> 2;
+	if (get < bgn ? (off >= get && off <= bgn) : (off >= get || off <= bgn))
+		chan->pushbuf.get = off;
+}
+
+/* Posts anything written since the last kick as a GPFIFO entry, and tells
+ * the GPU about it.  Fails only if the GPFIFO is full.
+ */
+static bool
+nvif_chan_kick(struct nvif_chan *chan)
+{
+	struct nvif_device *device = chan->device;
+	struct nvif_push *push = &chan->push;
+	u32 bgn = push->bgn - chan->pushbuf.ptr;
+	u32 len = push->cur - push->bgn;
+	u64 addr = chan->pushbuf.addr + bgn * 4;
+	u32 *entry;
+
+	if (!len)
+		return true;
+
+	if (!nvif_chan_gpfifo_free(chan)) {
+		nvif_chan_update(chan);
+		if (!nvif_chan_gpfifo_free(chan))
+			return false;
+	}
+
+	entry = &chan->gpfifo.ptr[chan->gpfifo.cur * 2];
+	entry[0] = lower_32_bits(addr);
+	entry[1] = upper_32_bits(addr) | len << 10;
+	chan->gpfifo.cur = (chan->gpfifo.cur + 1) & chan->gpfifo.max;
+	push->bgn = push->cur;
+
+	mb();
+	nvif_wr32(chan->userd, NVIF_CHAN_USERD_GP_PUT, chan->gpfifo.cur);
+	if (device->user.func && device->user.func->doorbell)
+		device->user.func->doorbell(&device->user, chan->token);
+	return true;
+}
+
+static void
+nvif_chan_push_kick(struct nvif_push *push)
+{
+	struct nvif_chan *chan = container_of(push, typeof(*chan), push);
+	s64 ret;
+
+	if (nvif_chan_kick(chan))
+		return;
+
+	/* The methods stay pending if this fails, and go with the next kick. */
+	ret = nvif_msec(chan->device, 2000,
+		if (nvif_chan_kick(chan))
+			break;
+	);
+	WARN_ON(ret < 0);
+}
+
+/* Looks for 'size' contiguous dwords from the current position, wrapping
+ * back to the start of the ring if need be, and sets the end of the push
+ * as far out as the GPU allows.  The ring is never allowed to fill all
+ * the way up to GET, so that get == cur can only mean it's empty.
+ */
+static bool
+nvif_chan_push_space(struct nvif_chan *chan, u32 size)
+{
+	struct nvif_push *push = &chan->push;
+	u32 *ptr = chan->pushbuf.ptr;
+	u32 cur = push->cur - ptr;
+	u32 get;
+
+	nvif_chan_update(chan);
+	get = chan->pushbuf.get;
+
+	if (cur >= get) {
+		if (cur + size < chan->pushbuf.size) {
+			push->end = ptr + chan->pushbuf.size;
+			return true;
+		}
+
+		/* A GPFIFO entry can't wrap, so pending methods have to
+		 * be posted before going back to the start.
+		 */
+		if (size < get && nvif_chan_kick(chan)) {
+			push->bgn = ptr;
+			push->cur = ptr;
+			push->end = ptr + get;
+			return true;
+		}
+	} else {
+		if (cur + size < get) {
+			push->end = ptr + get;
+			return true;
+		}
+	}
+
+	/* Make sure the GPU has everything it needs to make progress. */
+	nvif_chan_kick(chan);
+	return false;
+}
+
+static int
+nvif_chan_push_wait(struct nvif_push *push, u32 size)
+{
+	struct nvif_chan *chan = container_of(push, typeof(*chan), push);
+	s64 ret;
+
+	if (WARN_ON(size >= chan->pushbuf.size / 2))
+		return -EINVAL;
+
+	if (nvif_chan_push_space(chan, size))
+		return 0;
+
+	ret = nvif_msec(chan->device, 2000,
+		if (nvif_chan_push_space(chan, size))
+			break;
+	);
+	return ret < 0 ? ret : 0;
+}
+
+bool
+nvif_chan_fence_done(struct nvif_chan *chan, u32 seqno)
+{
+	return (s32)(ioread32_native(chan->fence.ptr) - seqno) >= 0;
+}
+
+int
+nvif_chan_fence_wait(struct nvif_chan *chan, u32 seqno)
+{
+	s64 ret;
+
+	if (nvif_chan_fence_done(chan, seqno))
+		return 0;
+
+	ret = nvif_msec(chan->device, 2000,
+		if (nvif_chan_fence_done(chan, seqno))
+			break;
+	);
+	return ret < 0 ? ret : 0;
+}
+
+/* Emits a semaphore release of the next sequence number, and kicks. */
+int
+nvif_chan_fence(struct nvif_chan *chan, u32 *seqno)
+{
+	struct nvif_push *push = &chan->push;
+	u64 addr = chan->fence.addr;
+	int ret;
+
+	ret = PUSH_WAIT(push, 5);
+	if (ret)
+		return ret;
+
+	PUSH_MTHD(push, NV906F, SEMAPHOREA,
+		  NVVAL(NV906F, SEMAPHOREA, OFFSET_UPPER, upper_32_bits(addr)),
+
+				SEMAPHOREB, lower_32_bits(addr),
+				SEMAPHOREC, chan->fence.seqno + 1,
+
+				SEMAPHORED,
+		  NVDEF(NV906F, SEMAPHORED, OPERATION, RELEASE) |
+		  NVDEF(NV906F, SEMAPHORED, RELEASE_WFI, EN) |
+		  NVDEF(NV906F, SEMAPHORED, RELEASE_SIZE, 16BYTE));
+	PUSH_KICK(push);
+
+	*seqno = ++chan->fence.seqno;
+	return 0;
+}
+
+static bool
+nvif_chan_valid(u32 push_size, u32 gpfifo_nr)
+{
+	/* GP_ENTRY1_LENGTH is 21 bits of dwords. */
+	return push_size && push_size <= 0x800000 && !(push_size & 0xf) &&
+	       gpfifo_nr >= 2 && is_power_of_2(gpfifo_nr);
+}
+
+static void
+nvif_chan_init(struct nvif_chan *chan, struct nvif_device *device,
+	       struct nvif_object *userd, u32 token, void *ptr, u64 addr,
+	       u32 push_size, u32 gpfifo_nr)
+{
+	chan->device = device;
+	chan->userd = userd;
+	chan->token = token;
+
+	chan->pushbuf.ptr = ptr;
+	chan->pushbuf.addr = addr;
+	chan->pushbuf.size = push_size / 4;
+	chan->pushbuf.get = 0;
+
+	chan->gpfifo.ptr = chan->pushbuf.ptr + chan->pushbuf.size;
+	chan->gpfifo.addr = addr + push_size;
+	chan->gpfifo.max = gpfifo_nr - 1;
+	chan->gpfifo.cur = 0;
+	chan->gpfifo.get = 0;
+
+	chan->fence.ptr = chan->gpfifo.ptr + gpfifo_nr * 2;
+	chan->fence.addr = chan->gpfifo.addr + gpfifo_nr * 8;
+	chan->fence.seqno = 0;
+	iowrite32_native(0, chan->fence.ptr);
+
+	/* Start out with no space, so the first PUSH_WAIT() asks for it. */
+	chan->push.wait = nvif_chan_push_wait;
+	chan->push.kick = nvif_chan_push_kick;
+	chan->push.bgn = ptr;
+	chan->push.cur = ptr;
+	chan->push.seg = ptr;
+	chan->push.end = ptr;
+}
+
+void
+nvif_chan_dtor(struct nvif_chan *chan)
+{
+	if (chan->vmm) {
+		nvif_object_dtor(&chan->object);
+		if (chan->vma.size) {
+			nvif_vmm_unmap(chan->vmm, chan->vma.addr);
+			nvif_vmm_put(chan->vmm, &chan->vma);
+		}
+		nvif_mem_dtor(&chan->push.mem);
+		chan->vmm = NULL;
+	}
+	chan->userd = NULL;
+}
+
+/* Creates a GPFIFO channel on 'vmm', with its buffer in host memory. */
+int
+nvif_chan_ctor_gpfifo(struct nvif_device *device, struct nvif_mmu *mmu,
+		      struct nvif_vmm *vmm, const char *name, u64 runlist,
+		      u32 push_size, u32 gpfifo_nr, struct nvif_chan *chan)
+{
+	static const s32 oclasses[] = { TURING_CHANNEL_GPFIFO_A,
+					VOLTA_CHANNEL_GPFIFO_A,
+					PASCAL_CHANNEL_GPFIFO_A,
+					MAXWELL_CHANNEL_GPFIFO_A,
+					KEPLER_CHANNEL_GPFIFO_B,
+					KEPLER_CHANNEL_GPFIFO_A,
+					FERMI_CHANNEL_GPFIFO,
+					0 };
+	const s32 *oclass = oclasses;
+	union {
+		struct fermi_channel_gpfifo_v0 fermi;
+		struct kepler_channel_gpfifo_a_v0 kepler;
+		struct volta_channel_gpfifo_a_v0 volta;
+	} args;
+	u64 ioffset, size = push_size + gpfifo_nr * 8 + NVIF_CHAN_FENCE_SIZE;
+	u32 argc;
+	int ret;
+
+	if (!nvif_chan_valid(push_size, gpfifo_nr))
+		return -EINVAL;
+
+	name = name ? name : "nvifChan";
+	chan->vmm = vmm;
+	chan->vma.size = 0;
+	chan->object.client = NULL;
+
+	ret = nvif_mem_ctor_map(mmu, name, NVIF_MEM_HOST | NVIF_MEM_COHERENT,
+				size, &chan->push.mem);
+	if (ret)
+		goto done;
+
+	ret = nvif_vmm_get(vmm, ADDR, false, chan->push.mem.page, 0,
+			   chan->push.mem.size, &chan->vma);
+	if (ret)
+		goto done;
+
+	ret = nvif_vmm_map(vmm, chan->vma.addr, chan->push.mem.size, NULL, 0,
+			   &chan->push.mem, 0);
+	if (ret) {
+		nvif_vmm_put(vmm, &chan->vma);
+		goto done;
+	}
+
+	ioffset = chan->vma.addr + push_size;
+	do {
+		if (oclass[0] >= VOLTA_CHANNEL_GPFIFO_A) {
+			args.volta.version = 0;
+			args.volta.priv = 0;
+			args.volta.ilength = gpfifo_nr * 8;
+			args.volta.ioffset = ioffset;
+			args.volta.runlist = runlist;
+			args.volta.vmm = nvif_handle(&vmm->object);
+			argc = sizeof(args.volta);
+		} else
+		if (oclass[0] >= KEPLER_CHANNEL_GPFIFO_A) {
+			args.kepler.version = 0;
+			args.kepler.priv = 0;
+			args.kepler.ilength = gpfifo_nr * 8;
+			args.kepler.ioffset = ioffset;
+			args.kepler.runlist = runlist;
+			args.kepler.vmm = nvif_handle(&vmm->object);
+			argc = sizeof(args.kepler);
+		} else {
+			args.fermi.version = 0;
+			args.fermi.ilength = gpfifo_nr * 8;
+			args.fermi.ioffset = ioffset;
+			args.fermi.vmm = nvif_handle(&vmm->object);
+			argc = sizeof(args.fermi);
+		}
+
+		ret = nvif_object_ctor(&device->object, name, 0, *oclass++,
+				       &args, argc, &chan->object);
+	} while (ret && *oclass);
+	if (ret)
+		goto done;
+
+	/* Volta+ needs the usermode class for the doorbell. */
+	if (chan->object.oclass >= VOLTA_CHANNEL_GPFIFO_A) {
+		ret = nvif_user_ctor(device, NULL);
+		if (ret)
+			goto done;
+	}
+
+	ret = nvif_object_map(&chan->object, NULL, 0);
+	if (ret)
+		goto done;
+
+	nvif_chan_init(chan, device, &chan->object,
+		       chan->object.oclass >= VOLTA_CHANNEL_GPFIFO_A ?
+		       args.volta.token : 0, chan->push.mem.object.map.ptr,
+		       chan->vma.addr, push_size, gpfifo_nr);
+done:
+	if (ret)
+		nvif_chan_dtor(chan);
+	return ret;
+}
+
+/* Wraps a channel that's been set up elsewhere, given its USERD and a
+ * CPU mapping of its buffer, laid out as described in chan.h, at GPU
+ * virtual address 'addr'.  This is also how a simulated channel is
+ * driven.
+ */
+int
+nvif_chan_ctor(struct nvif_device *device, const char *name,
+	       struct nvif_object *userd, u32 token, void *ptr, u64 addr,
+	       u32 push_size, u32 gpfifo_nr, struct nvif_chan *chan)
+{
+	if (!nvif_chan_valid(push_size, gpfifo_nr))
+		return -EINVAL;
+
+	chan->vmm = NULL;
+	chan->object.client = NULL;
+
+	/* Enough of an object for PUSH_PRINTF(). */
+	chan->push.mem.object.parent = device->object.parent;
+	chan->push.mem.object.client = device->object.client;
+	chan->push.mem.object.name = name ? name : "nvifChan";
+	chan->push.mem.object.handle = 0;
+	chan->push.mem.object.map.ptr = ptr;
+
+	nvif_chan_init(chan, device, userd, token, ptr, addr,
+		       push_size, gpfifo_nr);
+	return 0;
+}
@@ -24,6 +24,61 @@
 #include <nvif/class.h>
 #include <nvif/if0008.h>
 
+/* Fetches the heap, type and kind tables in a single call, if the server
+ * supports it.
+ */
+static int
+nvif_mmu_info(struct nvif_mmu *mmu)
+{
+	struct nvif_mmu_info_v0 *args;
+	size_t argc = sizeof(*args) + mmu->heap_nr * sizeof(u64) +
+		      mmu->type_nr * 2 + mmu->kind_nr;
+	u8 *data;
+	int ret, i;
+
+	if (!(args = kmalloc(argc, GFP_KERNEL)))
+		return -ENOMEM;
+	args->version = 0;
+	args->heap_nr = mmu->heap_nr;
+	args->type_nr = mmu->type_nr;
+	args->kind_nr = mmu->kind_nr;
+
+	ret = nvif_object_mthd(&mmu->object, NVIF_MMU_V0_INFO, args, argc);
+	if (ret == 0) {
+		data = args->data;
+		for (i = 0; i < mmu->heap_nr; i++, data += sizeof(u64))
+			memcpy(&mmu->heap[i].size, data, sizeof(u64));
+
+		for (i = 0; i < mmu->type_nr; i++) {
+			mmu->type[i].heap = *data++;
+			mmu->type[i].type = 0;
+			if (*data & NVIF_MMU_INFO_V0_TYPE_VRAM)
+				mmu->type[i].type |= NVIF_MEM_VRAM;
+			if (*data & NVIF_MMU_INFO_V0_TYPE_HOST)
+				mmu->type[i].type |= NVIF_MEM_HOST;
+			if (*data & NVIF_MMU_INFO_V0_TYPE_COMP)
+				mmu->type[i].type |= NVIF_MEM_COMP;
+			if (*data & NVIF_MMU_INFO_V0_TYPE_DISP)
+				mmu->type[i].type |= NVIF_MEM_DISP;
+			if (*data & NVIF_MMU_INFO_V0_TYPE_KIND)
+				mmu->type[i].type |= NVIF_MEM_KIND;
+			if (*data & NVIF_MMU_INFO_V0_TYPE_MAPPABLE)
+				mmu->type[i].type |= NVIF_MEM_MAPPABLE;
+			if (*data & NVIF_MMU_INFO_V0_TYPE_COHERENT)
+				mmu->type[i].type |= NVIF_MEM_COHERENT;
+			if (*data & NVIF_MMU_INFO_V0_TYPE_UNCACHED)
+				mmu->type[i].type |= NVIF_MEM_UNCACHED;
+			data++;
+		}
+
+		memcpy(mmu->kind, data, mmu->kind_nr);
+		mmu->kind_inv = args->kind_inv;
+	}
+
+	kfree(args);
+	return ret;
+}
+
 void
 nvif_mmu_dtor(struct nvif_mmu *mmu)
 {
@@ -78,6 +133,11 @@ nvif_mmu_ctor(struct nvif_object *parent, const char *name, s32 oclass,
 	if (!mmu->kind && mmu->kind_nr)
 		goto done;
 
+	ret = nvif_mmu_info(mmu);
+	if (ret != -EINVAL && ret != -ENOSYS)
+		goto done;
+
+	/* Older servers need a query per heap, type and the kinds. */
 	for (i = 0; i < mmu->heap_nr; i++) {
 		struct nvif_mmu_heap_v0 args = { .index = i };
 
@@ -0,0 +1,276 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <nvif/pool.h>
+#include <nvif/mmu.h>
+
+struct nvif_pool_slab {
+	struct list_head head;
+	struct nvif_mem mem;
+	struct nvif_vma vma;
+	void *ptr;
+
+	u8  shift;	/* object size, 0 for a dedicated allocation */
+	u32 count;
+	u32 used;
+	u32 next;	/* first object that has never been handed out */
+	u32 free_nr;
+	u32 free[];	/* objects returned since the slab was (re)classed */
+};
+
+static void
+nvif_pool_slab_del(struct nvif_pool *pool, struct nvif_pool_slab *slab)
+{
+	list_del(&slab->head);
+	if (slab->vma.size) {
+		nvif_vmm_unmap(pool->vmm, slab->vma.addr);
+		nvif_vmm_put(pool->vmm, &slab->vma);
+	}
+	nvif_mem_dtor(&slab->mem);
+	kfree(slab);
+	pool->slab_nr--;
+}
+
+static struct nvif_pool_slab *
+nvif_pool_slab_new(struct nvif_pool *pool, u64 size, u32 objects)
+{
+	struct nvif_pool_slab *slab;
+	int ret;
+
+	if (!(slab = kzalloc(struct_size(slab, free, objects), GFP_KERNEL)))
+		return NULL;
+	INIT_LIST_HEAD(&slab->head);
+	pool->slab_nr++;
+
+	ret = nvif_mem_ctor(pool->mmu, pool->name, pool->mmu->mem, pool->type,
+			    pool->page, size, NULL, 0, &slab->mem);
+	if (ret)
+		goto done;
+
+	if (pool->type & NVIF_MEM_MAPPABLE) {
+		ret = nvif_object_map(&slab->mem.object, NULL, 0);
+		if (ret)
+			goto done;
+		slab->ptr = slab->mem.object.map.ptr;
+	}
+
+	ret = nvif_vmm_get(pool->vmm, ADDR, false, slab->mem.page, 0,
+			   slab->mem.size, &slab->vma);
+	if (ret)
+		goto done;
+
+	ret = nvif_vmm_map(pool->vmm, slab->vma.addr, slab->mem.size, NULL, 0,
+			   &slab->mem, 0);
+	if (ret) {
+		nvif_vmm_put(pool->vmm, &slab->vma);
+		goto done;
+	}
+
+done:
+	if (ret) {
+		nvif_pool_slab_del(pool, slab);
+		return NULL;
+	}
+	return slab;
+}
+
+static void
+nvif_pool_slab_class(struct nvif_pool *pool, struct nvif_pool_slab *slab,
+		     u8 shift)
+{
+	slab->shift = shift;
+	slab->count = pool->slab_size >> shift;
+	slab->used = 0;
+	slab->next = 0;
+	slab->free_nr = 0;
+}
+
+static void
+nvif_pool_slab_fill(struct nvif_pool_slab *slab, u32 index, u32 size,
+		    struct nvif_pool_alloc *alloc)
+{
+	alloc->slab = slab;
+	alloc->mem = &slab->mem;
+	alloc->offset = (u64)index << slab->shift;
+	alloc->addr = slab->vma.addr + alloc->offset;
+	alloc->ptr = slab->ptr ? (u8 *)slab->ptr + alloc->offset : NULL;
+	alloc->size = size;
+}
+
+/* Releases every empty slab the pool is holding on to. */
+void
+nvif_pool_trim(struct nvif_pool *pool)
+{
+	struct nvif_pool_slab *slab, *temp;
+
+	mutex_lock(&pool->mutex);
+	list_for_each_entry_safe(slab, temp, &pool->empty, head)
+		nvif_pool_slab_del(pool, slab);
+	pool->empty_nr = 0;
+	mutex_unlock(&pool->mutex);
+}
+
+void
+nvif_pool_put(struct nvif_pool *pool, struct nvif_pool_alloc *alloc)
+{
+	struct nvif_pool_slab *slab = alloc->slab;
+
+	if (!slab)
+		return;
+	alloc->slab = NULL;
+
+	mutex_lock(&pool->mutex);
+	if (!slab->shift) {
+		nvif_pool_slab_del(pool, slab);
+		goto done;
+	}
+
+	if (slab->used-- == slab->count)
+		list_move(&slab->head, &pool->part[slab->shift -
+						   NVIF_POOL_SHIFT_MIN]);
+	slab->free[slab->free_nr++] = alloc->offset >> slab->shift;
+
+	if (!slab->used) {
+		list_move(&slab->head, &pool->empty);
+		if (++pool->empty_nr > pool->empty_max) {
+			slab = list_last_entry(&pool->empty, typeof(*slab),
+					       head);
+			nvif_pool_slab_del(pool, slab);
+			pool->empty_nr--;
+		}
+	}
+
+done:
+	mutex_unlock(&pool->mutex);
+}
+
+int
+nvif_pool_get(struct nvif_pool *pool, u32 size, struct nvif_pool_alloc *alloc)
+{
+	struct nvif_pool_slab *slab;
+	struct list_head *part;
+	u8 shift = max_t(u8, order_base_2(size), NVIF_POOL_SHIFT_MIN);
+	u32 index;
+	int ret = 0;
+
+	alloc->slab = NULL;
+	if (!size)
+		return -EINVAL;
+
+	mutex_lock(&pool->mutex);
+	if (shift > NVIF_POOL_SHIFT_MAX) {
+		slab = nvif_pool_slab_new(pool, ALIGN((u64)size, 1ULL <<
+						      pool->page), 0);
+		if (!slab) {
+			ret = -ENOMEM;
+			goto done;
+		}
+		list_add(&slab->head, &pool->full);
+		nvif_pool_slab_fill(slab, 0, size, alloc);
+		goto done;
+	}
+
+	part = &pool->part[shift - NVIF_POOL_SHIFT_MIN];
+	slab = list_first_entry_or_null(part, typeof(*slab), head);
+	if (!slab) {
+		slab = list_first_entry_or_null(&pool->empty, typeof(*slab),
+						head);
+		if (slab) {
+			pool->empty_nr--;
+		} else {
+			slab = nvif_pool_slab_new(pool, pool->slab_size,
+						  pool->slab_size >>
+						  NVIF_POOL_SHIFT_MIN);
+			if (!slab) {
+				ret = -ENOMEM;
+				goto done;
+			}
+		}
+
+		nvif_pool_slab_class(pool, slab, shift);
+		list_move(&slab->head, part);
+	}
+
+	if (slab->free_nr)
+		index = slab->free[--slab->free_nr];
+	else
+		index = slab->next++;
+
+	if (++slab->used == slab->count)
+		list_move(&slab->head, &pool->full);
+
+	nvif_pool_slab_fill(slab, index, size, alloc);
+done:
+	mutex_unlock(&pool->mutex);
+	return ret;
+}
+
+void
+nvif_pool_dtor(struct nvif_pool *pool)
+{
+	struct nvif_pool_slab *slab, *temp;
+	int i;
+
+	if (!pool->mmu)
+		return;
+
+	for (i = 0; i < NVIF_POOL_CLASS_NR; i++) {
+		list_for_each_entry_safe(slab, temp, &pool->part[i], head)
+			nvif_pool_slab_del(pool, slab);
+	}
+	list_for_each_entry_safe(slab, temp, &pool->full, head)
+		nvif_pool_slab_del(pool, slab);
+	list_for_each_entry_safe(slab, temp, &pool->empty, head)
+		nvif_pool_slab_del(pool, slab);
+
+	WARN_ON(pool->slab_nr);
+	pool->mmu = NULL;
+}
+
+int
+nvif_pool_ctor(struct nvif_mmu *mmu, struct nvif_vmm *vmm, const char *name,
+	       u8 type, u8 page, u32 slab_size, struct nvif_pool *pool)
+{
+	int i;
+
+	pool->mmu = NULL;
+	if (!is_power_of_2(slab_size) ||
+	    slab_size < (1 << NVIF_POOL_SHIFT_MAX) ||
+	    slab_size < (1 << page))
+		return -EINVAL;
+
+	pool->mmu = mmu;
+	pool->vmm = vmm;
+	pool->name = name ? name : "nvifPool";
+	pool->type = type;
+	pool->page = page;
+	pool->slab_size = slab_size;
+
+	mutex_init(&pool->mutex);
+	for (i = 0; i < NVIF_POOL_CLASS_NR; i++)
+		INIT_LIST_HEAD(&pool->part[i]);
+	INIT_LIST_HEAD(&pool->full);
+	INIT_LIST_HEAD(&pool->empty);
+	pool->empty_nr = 0;
+	pool->empty_max = 2;
+	pool->slab_nr = 0;
+	return 0;
+}
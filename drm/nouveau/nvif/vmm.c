@@ -61,6 +61,114 @@ nvif_vmm_map(struct nvif_vmm *vmm, u64 addr, u64 size, void *argv, u32 argc,
 	return ret;
 }
 
+static int
+nvif_vmm_bind_single(struct nvif_vmm *vmm, struct nvif_vmm_bind *bind,
+		     void *argv, u32 argc)
+{
+	int ret;
+
+	switch (bind->type) {
+	case NVIF_VMM_BIND_REMAP:
+		/* MAP is only for unmapped regions, so the old mapping has
+		 * to go first.  Unlike BIND, a failed map then leaves the
+		 * region unmapped.
+		 */
+		ret = nvif_vmm_unmap(vmm, bind->addr);
+		if (ret)
+			return ret;
+		fallthrough;
+	case NVIF_VMM_BIND_MAP:
+		return nvif_vmm_map(vmm, bind->addr, bind->size, argv, argc,
+				    bind->mem, bind->offset);
+	case NVIF_VMM_BIND_UNMAP:
+		return nvif_vmm_unmap(vmm, bind->addr);
+	default:
+		return -EINVAL;
+	}
+}
+
+/* Performs 'nr' map/unmap/remap operations, NVIF_VMM_BIND_MAX at a time,
+ * with one TLB flush per batch.  The result of each operation is stored
+ * in its 'ret', and the first error (if any) is returned.  Servers that
+ * don't implement NVIF_VMM_V0_BIND get one method per operation instead.
+ */
+#define NVIF_VMM_BIND_MAX 1024
+
+int
+nvif_vmm_bind(struct nvif_vmm *vmm, struct nvif_vmm_bind *bind, int nr,
+	      void *argv, u32 argc)
+{
+	static const u8 type[] = {
+		[NVIF_VMM_BIND_MAP  ] = NVIF_VMM_BIND_V0_MAP,
+		[NVIF_VMM_BIND_UNMAP] = NVIF_VMM_BIND_V0_UNMAP,
+		[NVIF_VMM_BIND_REMAP] = NVIF_VMM_BIND_V0_REMAP,
+	};
+	struct nvif_vmm_bind_v0 *args;
+	int count = min(nr, NVIF_VMM_BIND_MAX);
+	int ret = 0, i, j;
+
+	if (nr <= 0)
+		return 0;
+
+	args = kvmalloc(struct_size(args, op, count) + argc, GFP_KERNEL);
+	if (!args)
+		return -ENOMEM;
+
+	for (i = 0; i < nr; i += count) {
+		count = min(nr - i, NVIF_VMM_BIND_MAX);
+		args->version = 0;
+		args->count = count;
+		for (j = 0; j < count; j++) {
+			struct nvif_vmm_bind *b = &bind[i + j];
+			struct nvif_vmm_bind_op_v0 *op = &args->op[j];
+			memset(op, 0x00, sizeof(*op));
+			op->op = b->type < ARRAY_SIZE(type) ? type[b->type] : ~0;
+			op->status = -ENOSYS;
+			op->addr = b->addr;
+			op->size = b->size;
+			op->memory = b->mem ? nvif_handle(&b->mem->object) : 0;
+			op->offset = b->offset;
+		}
+		memcpy(&args->op[count], argv, argc);
+
+		ret = nvif_object_mthd(&vmm->object, NVIF_VMM_V0_BIND, args,
+				       struct_size(args, op, count) + argc);
+		if (ret) {
+			/* A rejected batch has the status of the operation
+			 * that caused it set, and none of it was applied.
+			 */
+			for (j = 0; j < count; j++) {
+				if (args->op[j].status != -ENOSYS)
+					break;
+			}
+
+			if (j == count) {
+				for (j = 0; j < count; j++) {
+					struct nvif_vmm_bind *b = &bind[i + j];
+					b->ret = nvif_vmm_bind_single(vmm, b,
+								      argv,
+								      argc);
+				}
+				continue;
+			}
+
+			for (j = 0; j < count; j++) {
+				if (args->op[j].status == -ENOSYS)
+					args->op[j].status = -ECANCELED;
+			}
+		}
+
+		for (j = 0; j < count; j++)
+			bind[i + j].ret = args->op[j].status;
+	}
+
+	kvfree(args);
+
+	for (i = 0, ret = 0; i < nr && !ret; i++)
+		ret = bind[i].ret;
+	return ret;
+}
+
 void
 nvif_vmm_put(struct nvif_vmm *vmm, struct nvif_vma *vma)
 {
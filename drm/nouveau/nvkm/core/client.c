@@ -271,6 +271,7 @@ nvkm_client_dtor(struct nvkm_object *object)
 	int i;
 	for (i = 0; i < ARRAY_SIZE(client->notify); i++)
 		nvkm_client_notify_del(client, i);
+	kvfree(client->objhash.slot);
 	return client;
 }
 
@@ -299,6 +300,7 @@ nvkm_client_new(const char *name, u64 device, const char *cfg,
 	snprintf(client->name, sizeof(client->name), "%s", name);
 	client->device = device;
 	client->debug = nvkm_dbgopt(dbg, "CLIENT");
+	init_rwsem(&client->objlock);
 	client->objroot = RB_ROOT;
 	client->ntfy = ntfy;
 	INIT_LIST_HEAD(&client->umem);
@@ -52,29 +52,61 @@ void
 nvkm_event_send(struct nvkm_event *event, u32 types, int index,
 		void *data, u32 size)
 {
+	struct nvkm_event_index *head;
 	struct nvkm_notify *notify;
 	unsigned long flags;
 
 	if (!event->refs || WARN_ON(index >= event->index_nr))
 		return;
+	head = &event->index[index];
 
 	spin_lock_irqsave(&event->list_lock, flags);
-	list_for_each_entry(notify, &event->list, head) {
-		if (notify->index == index && (notify->types & types)) {
-			if (event->func->send) {
-				event->func->send(data, size, notify);
-				continue;
+	if (head->types & types) {
+		list_for_each_entry(notify, &head->list, head) {
+			if (notify->types & types) {
+				if (event->func->send) {
+					event->func->send(data, size, notify);
+					continue;
+				}
+				nvkm_notify_send(notify, data, size);
 			}
-			nvkm_notify_send(notify, data, size);
 		}
 	}
 	spin_unlock_irqrestore(&event->list_lock, flags);
 }
 
+/* Notifiers are kept on per-index lists, along with a mask of the types
+ * that are of interest to at least one of them, so that sending an event
+ * only has to touch notifiers that will actually receive it.
+ */
+void
+nvkm_event_ntfy_add(struct nvkm_event *event, struct nvkm_notify *notify)
+{
+	struct nvkm_event_index *head = &event->index[notify->index];
+	assert_spin_locked(&event->list_lock);
+	list_add_tail(&notify->head, &head->list);
+	head->types |= notify->types;
+}
+
+void
+nvkm_event_ntfy_del(struct nvkm_event *event, struct nvkm_notify *notify)
+{
+	struct nvkm_event_index *head = &event->index[notify->index];
+	struct nvkm_notify *temp;
+
+	assert_spin_locked(&event->list_lock);
+	list_del(&notify->head);
+	head->types = 0;
+	list_for_each_entry(temp, &head->list, head)
+		head->types |= temp->types;
+}
+
 void
 nvkm_event_fini(struct nvkm_event *event)
 {
 	if (event->refs) {
+		kfree(event->index);
+		event->index = NULL;
 		kfree(event->refs);
 		event->refs = NULL;
 	}
@@ -84,17 +116,27 @@ int
 nvkm_event_init(const struct nvkm_event_func *func, int types_nr, int index_nr,
 		struct nvkm_event *event)
 {
+	int i;
+
 	event->refs = kzalloc(array3_size(index_nr, types_nr,
 					  sizeof(*event->refs)),
 			      GFP_KERNEL);
 	if (!event->refs)
 		return -ENOMEM;
 
+	event->index = kcalloc(index_nr, sizeof(*event->index), GFP_KERNEL);
+	if (!event->index) {
+		kfree(event->refs);
+		event->refs = NULL;
+		return -ENOMEM;
+	}
+
 	event->func = func;
 	event->types_nr = types_nr;
 	event->index_nr = index_nr;
 	spin_lock_init(&event->refs_lock);
 	spin_lock_init(&event->list_lock);
-	INIT_LIST_HEAD(&event->list);
+	for (i = 0; i < index_nr; i++)
+		INIT_LIST_HEAD(&event->index[i].list);
 	return 0;
 }
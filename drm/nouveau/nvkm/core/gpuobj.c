@@ -257,6 +257,26 @@ nvkm_gpuobj_wrap(struct nvkm_memory *memory, struct nvkm_gpuobj **pgpuobj)
 	return 0;
 }
 
+/* Returns another reference to a gpuobj allocated directly from instmem,
+ * which is released with nvkm_gpuobj_del() like any other.  The copy has
+ * no heap of its own, so it can't be sub-allocated from.
+ */
+int
+nvkm_gpuobj_share(struct nvkm_gpuobj *gpuobj, struct nvkm_gpuobj **pgpuobj)
+{
+	if (WARN_ON(gpuobj->parent || !gpuobj->memory))
+		return -EINVAL;
+
+	if (!(*pgpuobj = kzalloc(sizeof(**pgpuobj), GFP_KERNEL)))
+		return -ENOMEM;
+
+	(*pgpuobj)->func = &nvkm_gpuobj_heap;
+	(*pgpuobj)->memory = nvkm_memory_ref(gpuobj->memory);
+	(*pgpuobj)->addr = gpuobj->addr;
+	(*pgpuobj)->size = gpuobj->size;
+	return 0;
+}
+
 void
 nvkm_gpuobj_memcpy_to(struct nvkm_gpuobj *dst, u32 dstoffset, void *src,
 		      u32 length)
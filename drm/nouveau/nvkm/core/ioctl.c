@@ -30,7 +30,8 @@
 
 static int
 nvkm_ioctl_nop(struct nvkm_client *client,
-	       struct nvkm_object *object, void *data, u32 size)
+	       struct nvkm_object *object, void *data, u32 size,
+	       void **hack)
 {
 	union {
 		struct nvif_ioctl_nop_v0 v0;
@@ -48,7 +49,8 @@ nvkm_ioctl_nop(struct nvkm_client *client,
 
 static int
 nvkm_ioctl_sclass(struct nvkm_client *client,
-		  struct nvkm_object *object, void *data, u32 size)
+		  struct nvkm_object *object, void *data, u32 size,
+		  void **hack)
 {
 	union {
 		struct nvif_ioctl_sclass_v0 v0;
@@ -81,7 +83,8 @@ nvkm_ioctl_sclass(struct nvkm_client *client,
 
 static int
 nvkm_ioctl_new(struct nvkm_client *client,
-	       struct nvkm_object *parent, void *data, u32 size)
+	       struct nvkm_object *parent, void *data, u32 size,
+	       void **hack)
 {
 	union {
 		struct nvif_ioctl_new_v0 v0;
@@ -130,7 +133,8 @@ nvkm_ioctl_new(struct nvkm_client *client,
 		if (ret == 0) {
 			list_add(&object->head, &parent->tree);
 			if (nvkm_object_insert(object)) {
-				client->data = object;
+				if (hack)
+					*hack = object;
 				return 0;
 			}
 			ret = -EEXIST;
@@ -144,7 +148,8 @@ nvkm_ioctl_new(struct nvkm_client *client,
 
 static int
 nvkm_ioctl_del(struct nvkm_client *client,
-	       struct nvkm_object *object, void *data, u32 size)
+	       struct nvkm_object *object, void *data, u32 size,
+	       void **hack)
 {
 	union {
 		struct nvif_ioctl_del none;
@@ -163,7 +168,8 @@ nvkm_ioctl_del(struct nvkm_client *client,
 
 static int
 nvkm_ioctl_mthd(struct nvkm_client *client,
-		struct nvkm_object *object, void *data, u32 size)
+		struct nvkm_object *object, void *data, u32 size,
+		void **hack)
 {
 	union {
 		struct nvif_ioctl_mthd_v0 v0;
@@ -182,48 +188,74 @@ nvkm_ioctl_mthd(struct nvkm_client *client,
 
 
 static int
-nvkm_ioctl_rd(struct nvkm_client *client,
-	      struct nvkm_object *object, void *data, u32 size)
+nvkm_ioctl_rd_(struct nvkm_object *object, struct nvif_ioctl_rd_v0 *args)
 {
-	union {
-		struct nvif_ioctl_rd_v0 v0;
-	} *args = data;
 	union {
 		u8  b08;
 		u16 b16;
 		u32 b32;
 	} v;
+	int ret;
+
+	switch (args->size) {
+	case 1:
+		ret = nvkm_object_rd08(object, args->addr, &v.b08);
+		args->data = v.b08;
+		break;
+	case 2:
+		ret = nvkm_object_rd16(object, args->addr, &v.b16);
+		args->data = v.b16;
+		break;
+	case 4:
+		ret = nvkm_object_rd32(object, args->addr, &v.b32);
+		args->data = v.b32;
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	return ret;
+}
+
+static int
+nvkm_ioctl_rd(struct nvkm_client *client,
+	      struct nvkm_object *object, void *data, u32 size,
+	      void **hack)
+{
+	union {
+		struct nvif_ioctl_rd_v0 v0;
+	} *args = data;
 	int ret = -ENOSYS;
 
 	nvif_ioctl(object, "rd size %d\n", size);
 	if (!(ret = nvif_unpack(ret, &data, &size, args->v0, 0, 0, false))) {
 		nvif_ioctl(object, "rd vers %d size %d addr %016llx\n",
 			   args->v0.version, args->v0.size, args->v0.addr);
-		switch (args->v0.size) {
-		case 1:
-			ret = nvkm_object_rd08(object, args->v0.addr, &v.b08);
-			args->v0.data = v.b08;
-			break;
-		case 2:
-			ret = nvkm_object_rd16(object, args->v0.addr, &v.b16);
-			args->v0.data = v.b16;
-			break;
-		case 4:
-			ret = nvkm_object_rd32(object, args->v0.addr, &v.b32);
-			args->v0.data = v.b32;
-			break;
-		default:
-			ret = -EINVAL;
-			break;
-		}
+		ret = nvkm_ioctl_rd_(object, &args->v0);
 	}
 
 	return ret;
 }
 
+static int
+nvkm_ioctl_wr_(struct nvkm_object *object, struct nvif_ioctl_wr_v0 *args)
+{
+	switch (args->size) {
+	case 1: return nvkm_object_wr08(object, args->addr, args->data);
+	case 2: return nvkm_object_wr16(object, args->addr, args->data);
+	case 4: return nvkm_object_wr32(object, args->addr, args->data);
+	default:
+		break;
+	}
+
+	return -EINVAL;
+}
+
 static int
 nvkm_ioctl_wr(struct nvkm_client *client,
-	      struct nvkm_object *object, void *data, u32 size)
+	      struct nvkm_object *object, void *data, u32 size,
+	      void **hack)
 {
 	union {
 		struct nvif_ioctl_wr_v0 v0;
@@ -239,20 +271,13 @@ nvkm_ioctl_wr(struct nvkm_client *client,
 	} else
 		return ret;
 
-	switch (args->v0.size) {
-	case 1: return nvkm_object_wr08(object, args->v0.addr, args->v0.data);
-	case 2: return nvkm_object_wr16(object, args->v0.addr, args->v0.data);
-	case 4: return nvkm_object_wr32(object, args->v0.addr, args->v0.data);
-	default:
-		break;
-	}
-
-	return -EINVAL;
+	return nvkm_ioctl_wr_(object, &args->v0);
 }
 
 static int
 nvkm_ioctl_map(struct nvkm_client *client,
-	       struct nvkm_object *object, void *data, u32 size)
+	       struct nvkm_object *object, void *data, u32 size,
+	       void **hack)
 {
 	union {
 		struct nvif_ioctl_map_v0 v0;
@@ -277,7 +302,8 @@ nvkm_ioctl_map(struct nvkm_client *client,
 
 static int
 nvkm_ioctl_unmap(struct nvkm_client *client,
-		 struct nvkm_object *object, void *data, u32 size)
+		 struct nvkm_object *object, void *data, u32 size,
+		 void **hack)
 {
 	union {
 		struct nvif_ioctl_unmap none;
@@ -295,7 +321,8 @@ nvkm_ioctl_unmap(struct nvkm_client *client,
 
 static int
 nvkm_ioctl_ntfy_new(struct nvkm_client *client,
-		    struct nvkm_object *object, void *data, u32 size)
+		    struct nvkm_object *object, void *data, u32 size,
+		    void **hack)
 {
 	union {
 		struct nvif_ioctl_ntfy_new_v0 v0;
@@ -322,7 +349,8 @@ nvkm_ioctl_ntfy_new(struct nvkm_client *client,
 
 static int
 nvkm_ioctl_ntfy_del(struct nvkm_client *client,
-		    struct nvkm_object *object, void *data, u32 size)
+		    struct nvkm_object *object, void *data, u32 size,
+		    void **hack)
 {
 	union {
 		struct nvif_ioctl_ntfy_del_v0 v0;
@@ -341,7 +369,8 @@ nvkm_ioctl_ntfy_del(struct nvkm_client *client,
 
 static int
 nvkm_ioctl_ntfy_get(struct nvkm_client *client,
-		    struct nvkm_object *object, void *data, u32 size)
+		    struct nvkm_object *object, void *data, u32 size,
+		    void **hack)
 {
 	union {
 		struct nvif_ioctl_ntfy_get_v0 v0;
@@ -360,7 +389,8 @@ nvkm_ioctl_ntfy_get(struct nvkm_client *client,
 
 static int
 nvkm_ioctl_ntfy_put(struct nvkm_client *client,
-		    struct nvkm_object *object, void *data, u32 size)
+		    struct nvkm_object *object, void *data, u32 size,
+		    void **hack)
 {
 	union {
 		struct nvif_ioctl_ntfy_put_v0 v0;
@@ -379,7 +409,8 @@ nvkm_ioctl_ntfy_put(struct nvkm_client *client,
 
 static struct {
 	int version;
-	int (*func)(struct nvkm_client *, struct nvkm_object *, void *, u32);
+	int (*func)(struct nvkm_client *, struct nvkm_object *, void *, u32,
+		    void **);
 }
 nvkm_ioctl_v0[] = {
 	{ 0x00, nvkm_ioctl_nop },
@@ -399,7 +430,8 @@ nvkm_ioctl_v0[] = {
 
 static int
 nvkm_ioctl_path(struct nvkm_client *client, u64 handle, u32 type,
-		void *data, u32 size, u8 owner, u8 *route, u64 *token)
+		void *data, u32 size, u8 owner, u8 *route, u64 *token,
+		void **hack)
 {
 	struct nvkm_object *object;
 	int ret;
@@ -419,15 +451,83 @@ nvkm_ioctl_path(struct nvkm_client *client, u64 handle, u32 type,
 
 	if (ret = -EINVAL, type < ARRAY_SIZE(nvkm_ioctl_v0)) {
 		if (nvkm_ioctl_v0[type].version == 0)
-			ret = nvkm_ioctl_v0[type].func(client, object, data, size);
+			ret = nvkm_ioctl_v0[type].func(client, object, data, size,
+						       hack);
 	}
 
 	return ret;
 }
 
-int
-nvkm_ioctl(struct nvkm_client *client, bool supervisor,
-	   void *data, u32 size, void **hack)
+/* Lean path for RD/WR/MTHD, which make up the bulk of the ioctl traffic
+ * once a client has set up its objects.  The requests are validated in one
+ * go, rather than going through the generic unpack and trace logging of
+ * each layer.  Anything out of the ordinary is left to the regular path,
+ * which will deal with it (and the error reporting) as it always has.
+ */
+static bool
+nvkm_ioctl_fast(struct nvkm_client *client, struct nvif_ioctl_v0 *args,
+		u32 size, int *pret)
+{
+	struct nvkm_object *object;
+
+	if (client->debug >= NV_DBG_TRACE ||
+	    size < sizeof(*args) || args->version != 0)
+		return false;
+	size -= sizeof(*args);
+
+	switch (args->type) {
+	case NVIF_IOCTL_V0_RD:
+		if (size != sizeof(struct nvif_ioctl_rd_v0))
+			return false;
+		break;
+	case NVIF_IOCTL_V0_WR:
+		if (size != sizeof(struct nvif_ioctl_wr_v0))
+			return false;
+		break;
+	case NVIF_IOCTL_V0_MTHD:
+		if (size < sizeof(struct nvif_ioctl_mthd_v0))
+			return false;
+		break;
+	default:
+		return false;
+	}
+
+	/* All three request types begin with their version byte. */
+	if (args->data[0] != 0)
+		return false;
+
+	object = nvkm_object_search(client, args->object, NULL);
+	if (IS_ERR(object))
+		return false;
+
+	if (args->owner != NVIF_IOCTL_V0_OWNER_ANY &&
+	    args->owner != object->route)
+		return false;
+	args->route = object->route;
+	args->token = object->token;
+
+	switch (args->type) {
+	case NVIF_IOCTL_V0_RD:
+		*pret = nvkm_ioctl_rd_(object, (void *)args->data);
+		break;
+	case NVIF_IOCTL_V0_WR:
+		*pret = nvkm_ioctl_wr_(object, (void *)args->data);
+		break;
+	case NVIF_IOCTL_V0_MTHD: {
+		struct nvif_ioctl_mthd_v0 *mthd = (void *)args->data;
+		*pret = nvkm_object_mthd(object, mthd->method, mthd->data,
+					 size - sizeof(*mthd));
+	}
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+static int
+nvkm_ioctl_(struct nvkm_client *client, void *data, u32 size, void **hack)
 {
 	struct nvkm_object *object = &client->object;
 	union {
@@ -435,7 +535,9 @@ nvkm_ioctl(struct nvkm_client *client, bool supervisor,
 	} *args = data;
 	int ret = -ENOSYS;
 
-	client->super = supervisor;
+	if (nvkm_ioctl_fast(client, data, size, &ret))
+		return ret;
+
 	nvif_ioctl(object, "size %d\n", size);
 
 	if (!(ret = nvif_unpack(ret, &data, &size, args->v0, 0, 0, true))) {
@@ -445,16 +547,86 @@ nvkm_ioctl(struct nvkm_client *client, bool supervisor,
 			   args->v0.owner);
 		ret = nvkm_ioctl_path(client, args->v0.object, args->v0.type,
 				      data, size, args->v0.owner,
-				      &args->v0.route, &args->v0.token);
+				      &args->v0.route, &args->v0.token, hack);
 	}
 
-	if (ret != 1) {
+	if (ret != 1)
 		nvif_ioctl(object, "return %d\n", ret);
-		if (hack) {
-			*hack = client->data;
-			client->data = NULL;
+	return ret;
+}
+
+/* Requests that modify the client's object tree or notifier table, or
+ * that change its privilege level, are serialised against all others.
+ * Everything else may be processed concurrently, and will see a stable
+ * client->super for its duration.
+ */
+static bool
+nvkm_ioctl_excl(struct nvkm_client *client, bool supervisor,
+		struct nvif_ioctl_v0 *args, u32 size)
+{
+	if (client->super != supervisor)
+		return true;
+
+	if (size < sizeof(*args) || args->version != 0)
+		return false;
+
+	switch (args->type) {
+	case NVIF_IOCTL_V0_NEW:
+	case NVIF_IOCTL_V0_DEL:
+	case NVIF_IOCTL_V0_NTFY_NEW:
+	case NVIF_IOCTL_V0_NTFY_DEL:
+		return true;
+	default:
+		return false;
+	}
+}
+
+int
+nvkm_ioctl(struct nvkm_client *client, bool supervisor,
+	   void *data, u32 size, void **hack)
+{
+	struct nvif_ioctl_v0 *args = data;
+	struct nvkm_client *owner;
+	int ret;
+
+	if (hack)
+		*hack = NULL;
+
+	down_read(&client->objlock);
+	if (!nvkm_ioctl_excl(client, supervisor, args, size)) {
+		ret = nvkm_ioctl_(client, data, size, hack);
+		up_read(&client->objlock);
+		return ret;
+	}
+	up_read(&client->objlock);
+
+	/* A client deleting itself can't hold its own lock while doing so,
+	 * as the lock is freed along with it.  Taking it once for writing
+	 * waits out the client's other ioctls, and the parent's object tree
+	 * it's linked into is protected by the parent's lock.
+	 */
+	if (size >= sizeof(*args) && args->version == 0 &&
+	    args->type == NVIF_IOCTL_V0_DEL && args->object == 0) {
+		owner = client->object.client;
+		if (owner == client) {
+			down_write(&client->objlock);
+			client->super = supervisor;
+			up_write(&client->objlock);
+			return nvkm_ioctl_(client, data, size, hack);
 		}
+
+		down_write(&owner->objlock);
+		down_write(&client->objlock);
+		client->super = supervisor;
+		up_write(&client->objlock);
+		ret = nvkm_ioctl_(client, data, size, hack);
+		up_write(&owner->objlock);
+		return ret;
 	}
 
+	down_write(&client->objlock);
+	client->super = supervisor;
+	ret = nvkm_ioctl_(client, data, size, hack);
+	up_write(&client->objlock);
 	return ret;
 }
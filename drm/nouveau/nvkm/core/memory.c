@@ -142,10 +142,12 @@ nvkm_memory_new(struct nvkm_device *device, enum nvkm_memory_target target,
 	struct nvkm_memory *memory;
 	int ret;
 
-	if (unlikely(target != NVKM_MEM_TARGET_INST || !imem))
+	if (unlikely((target != NVKM_MEM_TARGET_INST &&
+		      target != NVKM_MEM_TARGET_INST_CPU) || !imem))
 		return -ENOSYS;
 
-	ret = nvkm_instobj_new(imem, size, align, zero, &memory);
+	ret = nvkm_instobj_new(imem, size, align, zero,
+			       target == NVKM_MEM_TARGET_INST_CPU, &memory);
 	if (ret)
 		return ret;
 
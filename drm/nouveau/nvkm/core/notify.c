@@ -121,7 +121,7 @@ nvkm_notify_fini(struct nvkm_notify *notify)
 	if (notify->event) {
 		nvkm_notify_put(notify);
 		spin_lock_irqsave(&notify->event->list_lock, flags);
-		list_del(&notify->head);
+		nvkm_event_ntfy_del(notify->event, notify);
 		spin_unlock_irqrestore(&notify->event->list_lock, flags);
 		kfree((void *)notify->data);
 		notify->event = NULL;
@@ -138,6 +138,8 @@ nvkm_notify_init(struct nvkm_object *object, struct nvkm_event *event,
 	int ret = -ENODEV;
 	if ((notify->event = event), event->refs) {
 		ret = event->func->ctor(object, data, size, notify);
+		if (ret == 0 && WARN_ON(notify->index >= event->index_nr))
+			ret = -EINVAL;
 		if (ret == 0 && (ret = -EINVAL, notify->size == reply)) {
 			notify->flags = 0;
 			notify->block = 1;
@@ -153,7 +155,7 @@ nvkm_notify_init(struct nvkm_object *object, struct nvkm_event *event,
 		}
 		if (ret == 0) {
 			spin_lock_irqsave(&event->list_lock, flags);
-			list_add_tail(&notify->head, &event->list);
+			nvkm_event_ntfy_add(event, notify);
 			spin_unlock_irqrestore(&event->list_lock, flags);
 		}
 	}
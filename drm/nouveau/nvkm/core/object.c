@@ -25,12 +25,100 @@
 #include <core/client.h>
 #include <core/engine.h>
 
+/* The rb-tree is the authoritative index of a client's objects, the hash
+ * table is an open-addressed (linear probing) mirror of it that's used for
+ * the lookup on every ioctl.  Should the table fail to (re)allocate, we fall
+ * back to the tree until the next insertion manages to rebuild it.
+ */
+static void
+nvkm_object_hash_link(struct nvkm_object **slot, u32 bits,
+		      struct nvkm_object *object)
+{
+	u32 mask = BIT(bits) - 1;
+	u32 i = hash_64(object->object, bits);
+
+	while (slot[i])
+		i = (i + 1) & mask;
+	slot[i] = object;
+}
+
+static void
+nvkm_object_hash_unlink(struct nvkm_object **slot, u32 bits,
+			struct nvkm_object *object)
+{
+	u32 mask = BIT(bits) - 1;
+	u32 i = hash_64(object->object, bits), j, k;
+
+	while (slot[i] != object) {
+		if (!slot[i])
+			return;
+		i = (i + 1) & mask;
+	}
+
+	/* Shift any following entries of the probe sequence back into the
+	 * hole, so that lookups never need to step over deleted slots.
+	 */
+	for (j = (i + 1) & mask; slot[j]; j = (j + 1) & mask) {
+		k = hash_64(slot[j]->object, bits);
+		if ((j > i && (k <= i || k > j)) ||
+		    (j < i && (k <= i && k > j))) {
+			slot[i] = slot[j];
+			i = j;
+		}
+	}
+
+	slot[i] = NULL;
+}
+
+static void
+nvkm_object_hash_rebuild(struct nvkm_client *client)
+{
+	u32 bits = max_t(u32, order_base_2(client->objhash.nr) + 1, 6);
+	struct nvkm_object **slot;
+	struct rb_node *node;
+
+	kvfree(client->objhash.slot);
+	client->objhash.slot = NULL;
+
+	slot = kvcalloc(BIT(bits), sizeof(*slot), GFP_KERNEL);
+	if (!slot)
+		return;
+
+	for (node = rb_first(&client->objroot); node; node = rb_next(node)) {
+		struct nvkm_object *object = rb_entry(node, typeof(*object), node);
+		nvkm_object_hash_link(slot, bits, object);
+	}
+
+	client->objhash.slot = slot;
+	client->objhash.bits = bits;
+}
+
+static struct nvkm_object *
+nvkm_object_hash_find(struct nvkm_client *client, u64 handle)
+{
+	struct nvkm_object **slot = client->objhash.slot;
+	u32 mask = BIT(client->objhash.bits) - 1;
+	u32 i = hash_64(handle, client->objhash.bits);
+
+	for (; slot[i]; i = (i + 1) & mask) {
+		if (slot[i]->object == handle)
+			return slot[i];
+	}
+
+	return NULL;
+}
+
 struct nvkm_object *
 nvkm_object_search(struct nvkm_client *client, u64 handle,
 		   const struct nvkm_object_func *func)
 {
 	struct nvkm_object *object;
 
+	if (handle && client->objhash.slot) {
+		object = nvkm_object_hash_find(client, handle);
+		if (!object)
+			return ERR_PTR(-ENOENT);
+	} else
 	if (handle) {
 		struct rb_node *node = client->objroot.rb_node;
 		while (node) {
@@ -57,14 +145,23 @@ done:
 void
 nvkm_object_remove(struct nvkm_object *object)
 {
-	if (!RB_EMPTY_NODE(&object->node))
-		rb_erase(&object->node, &object->client->objroot);
+	struct nvkm_client *client = object->client;
+
+	if (!RB_EMPTY_NODE(&object->node)) {
+		rb_erase(&object->node, &client->objroot);
+		if (client->objhash.slot) {
+			nvkm_object_hash_unlink(client->objhash.slot,
+						client->objhash.bits, object);
+		}
+		client->objhash.nr--;
+	}
 }
 
 bool
 nvkm_object_insert(struct nvkm_object *object)
 {
-	struct rb_node **ptr = &object->client->objroot.rb_node;
+	struct nvkm_client *client = object->client;
+	struct rb_node **ptr = &client->objroot.rb_node;
 	struct rb_node *parent = NULL;
 
 	while (*ptr) {
@@ -80,7 +177,19 @@ nvkm_object_insert(struct nvkm_object *object)
 	}
 
 	rb_link_node(&object->node, parent, ptr);
-	rb_insert_color(&object->node, &object->client->objroot);
+	rb_insert_color(&object->node, &client->objroot);
+
+	/* Keep the table at most half full, to keep probe sequences short. */
+	if (client->objhash.slot &&
+	    (client->objhash.nr + 1) * 2 <= BIT(client->objhash.bits)) {
+		nvkm_object_hash_link(client->objhash.slot,
+				      client->objhash.bits, object);
+		client->objhash.nr++;
+	} else {
+		client->objhash.nr++;
+		nvkm_object_hash_rebuild(client);
+	}
+
 	return true;
 }
 
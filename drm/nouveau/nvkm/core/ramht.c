@@ -37,22 +37,75 @@ nvkm_ramht_hash(struct nvkm_ramht *ramht, int chid, u32 handle)
 	return hash;
 }
 
-struct nvkm_gpuobj *
-nvkm_ramht_search(struct nvkm_ramht *ramht, int chid, u32 handle)
+/* The host-side index is open-addressed on its own hash of (chid, handle),
+ * and stores RAMHT slot + 1.  It's sized to at least twice the RAMHT, and
+ * rebuilt once removed entries leave too many tombstones behind, so probes
+ * stay short no matter how full or fragmented the RAMHT itself becomes.
+ */
+#define NVKM_RAMHT_DEAD -1
+
+static u32
+nvkm_ramht_index_hash(struct nvkm_ramht *ramht, int chid, u32 handle)
 {
-	u32 co, ho;
+	u32 hash = (handle ^ (chid * 0x85ebca6b)) * 0x9e3779b1;
+	return (hash ^ (hash >> 16)) & ramht->index.mask;
+}
 
-	co = ho = nvkm_ramht_hash(ramht, chid, handle);
-	do {
-		if (ramht->data[co].chid == chid) {
-			if (ramht->data[co].handle == handle)
-				return ramht->data[co].inst;
+static int *
+nvkm_ramht_index_find(struct nvkm_ramht *ramht, int chid, u32 handle)
+{
+	u32 i = nvkm_ramht_index_hash(ramht, chid, handle);
+	int *slot;
+
+	while (*(slot = &ramht->index.slot[i])) {
+		if (*slot > 0) {
+			struct nvkm_ramht_data *data = &ramht->data[*slot - 1];
+			if (data->chid == chid && data->handle == handle)
+				return slot;
 		}
+		i = (i + 1) & ramht->index.mask;
+	}
 
-		if (++co >= ramht->size)
-			co = 0;
-	} while (co != ho);
+	return NULL;
+}
+
+static void
+nvkm_ramht_index_link(struct nvkm_ramht *ramht, int co)
+{
+	struct nvkm_ramht_data *data = &ramht->data[co];
+	u32 i = nvkm_ramht_index_hash(ramht, data->chid, data->handle);
+
+	while (ramht->index.slot[i] > 0)
+		i = (i + 1) & ramht->index.mask;
+
+	if (ramht->index.slot[i] == NVKM_RAMHT_DEAD)
+		ramht->index.dead--;
+	ramht->index.slot[i] = co + 1;
+	ramht->index.used++;
+}
+
+static void
+nvkm_ramht_index_rehash(struct nvkm_ramht *ramht)
+{
+	int i;
 
+	memset(ramht->index.slot, 0x00, (ramht->index.mask + 1) *
+					sizeof(*ramht->index.slot));
+	ramht->index.used = 0;
+	ramht->index.dead = 0;
+
+	for (i = 0; i < ramht->size; i++) {
+		if (ramht->data[i].chid >= 0)
+			nvkm_ramht_index_link(ramht, i);
+	}
+}
+
+struct nvkm_gpuobj *
+nvkm_ramht_search(struct nvkm_ramht *ramht, int chid, u32 handle)
+{
+	int *slot = nvkm_ramht_index_find(ramht, chid, handle);
+	if (slot)
+		return ramht->data[*slot - 1].inst;
 	return NULL;
 }
 
@@ -89,6 +142,8 @@ nvkm_ramht_update(struct nvkm_ramht *ramht, int co, struct nvkm_object *object,
 		else          context |= inst >>  addr;
 	}
 
+	data->context = context;
+
 	nvkm_kmap(ramht->gpuobj);
 	nvkm_wo32(ramht->gpuobj, (co << 3) + 0, handle);
 	nvkm_wo32(ramht->gpuobj, (co << 3) + 4, context);
@@ -99,8 +154,20 @@ nvkm_ramht_update(struct nvkm_ramht *ramht, int co, struct nvkm_object *object,
 void
 nvkm_ramht_remove(struct nvkm_ramht *ramht, int cookie)
 {
-	if (--cookie >= 0)
-		nvkm_ramht_update(ramht, cookie, NULL, -1, 0, 0, 0);
+	struct nvkm_ramht_data *data;
+	int *slot;
+
+	if (--cookie < 0)
+		return;
+
+	data = &ramht->data[cookie];
+	if ((slot = nvkm_ramht_index_find(ramht, data->chid, data->handle))) {
+		*slot = NVKM_RAMHT_DEAD;
+		ramht->index.used--;
+		ramht->index.dead++;
+	}
+
+	nvkm_ramht_update(ramht, cookie, NULL, -1, 0, 0, 0);
 }
 
 int
@@ -108,15 +175,25 @@ nvkm_ramht_insert(struct nvkm_ramht *ramht, struct nvkm_object *object,
 		  int chid, int addr, u32 handle, u32 context)
 {
 	u32 co, ho;
+	int ret;
 
-	if (nvkm_ramht_search(ramht, chid, handle))
+	if (nvkm_ramht_index_find(ramht, chid, handle))
 		return -EEXIST;
 
+	/* Keep at least a quarter of the index empty so probes terminate. */
+	if ((ramht->index.used + ramht->index.dead + 1) * 4 >
+	    (ramht->index.mask + 1) * 3)
+		nvkm_ramht_index_rehash(ramht);
+
+	/* Slot placement has to follow the hardware's hash and probe. */
 	co = ho = nvkm_ramht_hash(ramht, chid, handle);
 	do {
 		if (ramht->data[co].chid < 0) {
-			return nvkm_ramht_update(ramht, co, object, chid,
-						 addr, handle, context);
+			ret = nvkm_ramht_update(ramht, co, object, chid,
+						addr, handle, context);
+			if (ret > 0)
+				nvkm_ramht_index_link(ramht, co);
+			return ret;
 		}
 
 		if (++co >= ramht->size)
@@ -132,6 +209,7 @@ nvkm_ramht_del(struct nvkm_ramht **pramht)
 	struct nvkm_ramht *ramht = *pramht;
 	if (ramht) {
 		nvkm_gpuobj_del(&ramht->gpuobj);
+		kvfree(ramht->index.slot);
 		vfree(*pramht);
 		*pramht = NULL;
 	}
@@ -154,6 +232,14 @@ nvkm_ramht_new(struct nvkm_device *device, u32 size, u32 align,
 	for (i = 0; i < ramht->size; i++)
 		ramht->data[i].chid = -1;
 
+	ramht->index.mask = (2 << ramht->bits) - 1;
+	ramht->index.slot = kvcalloc(ramht->index.mask + 1,
+				     sizeof(*ramht->index.slot), GFP_KERNEL);
+	if (!ramht->index.slot) {
+		nvkm_ramht_del(pramht);
+		return -ENOMEM;
+	}
+
 	ret = nvkm_gpuobj_new(ramht->device, size, align, true,
 			      ramht->parent, &ramht->gpuobj);
 	if (ret)
@@ -44,6 +44,24 @@ nvkm_device_find_locked(u64 handle)
 	return NULL;
 }
 
+/* Kept in handle order, so that devices constructed concurrently list the
+ * same way whichever of them finishes first.
+ */
+static void
+nvkm_device_add_locked(struct nvkm_device *device)
+{
+	struct nvkm_device *temp;
+
+	list_for_each_entry(temp, &nv_devices, head) {
+		if (temp->handle > device->handle) {
+			list_add_tail(&device->head, &temp->head);
+			return;
+		}
+	}
+
+	list_add_tail(&device->head, &nv_devices);
+}
+
 struct nvkm_device *
 nvkm_device_find(u64 handle)
 {
@@ -2902,6 +2920,9 @@ nvkm_device_del(struct nvkm_device **pdevice)
 	int i;
 	if (device) {
 		mutex_lock(&nv_devices_mutex);
+		list_del(&device->head);
+		mutex_unlock(&nv_devices_mutex);
+
 		device->disable_mask = 0;
 		for (i = NVKM_SUBDEV_NR - 1; i >= 0; i--) {
 			struct nvkm_subdev *subdev =
@@ -2913,11 +2934,9 @@ nvkm_device_del(struct nvkm_device **pdevice)
 
 		if (device->pri)
 			iounmap(device->pri);
-		list_del(&device->head);
 
 		if (device->func->dtor)
 			*pdevice = device->func->dtor(device);
-		mutex_unlock(&nv_devices_mutex);
 
 		kfree(*pdevice);
 		*pdevice = NULL;
@@ -2952,10 +2971,6 @@ nvkm_device_ctor(const struct nvkm_device_func *func,
 	int ret = -EEXIST, i;
 	unsigned chipset;
 
-	mutex_lock(&nv_devices_mutex);
-	if (nvkm_device_find_locked(handle))
-		goto done;
-
 	device->func = func;
 	device->quirk = quirk;
 	device->dev = dev;
@@ -2964,7 +2979,18 @@ nvkm_device_ctor(const struct nvkm_device_func *func,
 	device->cfgopt = cfg;
 	device->dbgopt = dbg;
 	device->name = name;
-	list_add_tail(&device->head, &nv_devices);
+	INIT_LIST_HEAD(&device->head);
+
+	/* The device only goes on the list once it's been constructed, so
+	 * nv_devices_mutex isn't held across construction, and several
+	 * devices can be brought up at once.
+	 */
+	mutex_lock(&nv_devices_mutex);
+	ret = nvkm_device_find_locked(handle) ? -EEXIST : 0;
+	mutex_unlock(&nv_devices_mutex);
+	if (ret)
+		return ret;
+
 	device->debug = nvkm_dbgopt(device->dbgopt, "device");
 
 	ret = nvkm_event_init(&nvkm_device_event_func, 1, 1, &device->event);
@@ -3277,6 +3303,14 @@ done:
 		iounmap(device->pri);
 		device->pri = NULL;
 	}
-	mutex_unlock(&nv_devices_mutex);
+
+	if (ret == 0) {
+		mutex_lock(&nv_devices_mutex);
+		if (nvkm_device_find_locked(handle))
+			ret = -EEXIST;
+		else
+			nvkm_device_add_locked(device);
+		mutex_unlock(&nv_devices_mutex);
+	}
 	return ret;
 }
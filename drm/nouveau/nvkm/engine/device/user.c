@@ -214,6 +214,50 @@ nvkm_udevice_time(struct nvkm_udevice *udev, void *data, u32 size)
 	return ret;
 }
 
+static int
+nvkm_udevice_wait(struct nvkm_udevice *udev, void *data, u32 size)
+{
+	struct nvkm_object *object = &udev->object;
+	struct nvkm_timer_site site;
+	union {
+		struct nv_device_wait_v0 v0;
+	} *args = data;
+	int ret = -ENOSYS;
+	size_t len;
+
+	nvif_ioctl(object, "device wait size %d\n", size);
+	if (!(ret = nvif_unpack(ret, &data, &size, args->v0, 0, 0, false))) {
+		nvif_ioctl(object, "device wait vers %d reset %d index %d\n",
+			   args->v0.version, args->v0.reset, args->v0.index);
+		if (args->v0.reset) {
+			if (!object->client->super)
+				return -EACCES;
+			nvkm_timer_site_reset();
+			return 0;
+		}
+
+		ret = nvkm_timer_site(args->v0.index, &site);
+		if (ret)
+			return ret;
+
+		args->v0.calls = atomic64_read(&site.calls);
+		args->v0.reads = atomic64_read(&site.reads);
+		args->v0.time = atomic64_read(&site.time);
+		args->v0.time_max = atomic64_read(&site.time_max);
+		args->v0.timeouts = atomic64_read(&site.timeouts);
+		args->v0.line = site.line;
+
+		/* Keep the end of the path, it's the useful part. */
+		len = strlen(site.file);
+		if (len >= sizeof(args->v0.file))
+			site.file += len - sizeof(args->v0.file) + 1;
+		snprintf(args->v0.file, sizeof(args->v0.file), "%s", site.file);
+		snprintf(args->v0.cond, sizeof(args->v0.cond), "%s", site.cond);
+	}
+
+	return ret;
+}
+
 static int
 nvkm_udevice_mthd(struct nvkm_object *object, u32 mthd, void *data, u32 size)
 {
@@ -224,6 +268,8 @@ nvkm_udevice_mthd(struct nvkm_object *object, u32 mthd, void *data, u32 size)
 		return nvkm_udevice_info(udev, data, size);
 	case NV_DEVICE_V0_TIME:
 		return nvkm_udevice_time(udev, data, size);
+	case NV_DEVICE_V0_WAIT:
+		return nvkm_udevice_wait(udev, data, size);
 	default:
 		break;
 	}
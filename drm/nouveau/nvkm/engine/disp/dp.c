@@ -157,7 +157,7 @@ nvkm_dp_train_eq(struct lt_state *lt)
 	bool eq_done = false, cr_done = true;
 	int tries = 0, i;
 
-	if (lt->dp->dpcd[DPCD_RC02] & DPCD_RC02_TPS3_SUPPORTED)
+	if (lt->pc2)
 		nvkm_dp_train_pattern(lt, 3);
 	else
 		nvkm_dp_train_pattern(lt, 2);
@@ -216,8 +216,52 @@ nvkm_dp_train_cr(struct lt_state *lt)
 	return cr_done ? 0 : -1;
 }
 
+static struct nvkm_dp_ltc *
+nvkm_dp_ltc_find(struct nvkm_dp *dp)
+{
+	int i;
+
+	for (i = 0; i < dp->ltc_nr; i++) {
+		if (!memcmp(dp->ltc[i].dpcd, dp->dpcd, sizeof(dp->dpcd)) &&
+		    !memcmp(dp->ltc[i].sink, dp->sink, sizeof(dp->sink)))
+			return &dp->ltc[i];
+	}
+
+	return NULL;
+}
+
+static void
+nvkm_dp_ltc_del(struct nvkm_dp *dp, struct nvkm_dp_ltc *ltc)
+{
+	int i = ltc - dp->ltc;
+
+	memmove(&dp->ltc[i], &dp->ltc[i + 1],
+		(--dp->ltc_nr - i) * sizeof(*ltc));
+}
+
+static void
+nvkm_dp_ltc_add(struct nvkm_dp *dp, struct lt_state *lt)
+{
+	struct nvkm_ior *ior = dp->outp.ior;
+	struct nvkm_dp_ltc *ltc;
+
+	if ((ltc = nvkm_dp_ltc_find(dp)))
+		nvkm_dp_ltc_del(dp, ltc);
+	if (dp->ltc_nr == ARRAY_SIZE(dp->ltc))
+		dp->ltc_nr--;
+
+	memmove(&dp->ltc[1], &dp->ltc[0], dp->ltc_nr++ * sizeof(*ltc));
+	ltc = &dp->ltc[0];
+	memcpy(ltc->dpcd, dp->dpcd, sizeof(ltc->dpcd));
+	memcpy(ltc->sink, dp->sink, sizeof(ltc->sink));
+	ltc->bw = ior->dp.bw;
+	ltc->nr = ior->dp.nr;
+	memcpy(ltc->conf, lt->conf, sizeof(ltc->conf));
+	memcpy(ltc->pc2conf, lt->pc2conf, sizeof(ltc->pc2conf));
+}
+
 static int
-nvkm_dp_train_links(struct nvkm_dp *dp)
+nvkm_dp_train_links(struct nvkm_dp *dp, struct nvkm_dp_ltc *ltc)
 {
 	struct nvkm_ior *ior = dp->outp.ior;
 	struct nvkm_disp *disp = dp->outp.disp;
@@ -228,15 +272,14 @@ nvkm_dp_train_links(struct nvkm_dp *dp)
 	};
 	u32 lnkcmp;
 	u8 sink[2];
-	int ret;
+	int ret, i;
 
 	OUTP_DBG(&dp->outp, "training %d x %d MB/s",
 		 ior->dp.nr, ior->dp.bw * 27);
 
 	/* Intersect misc. capabilities of the OR and sink. */
-	if (disp->engine.subdev.device->chipset < 0xd0)
-		dp->dpcd[DPCD_RC02] &= ~DPCD_RC02_TPS3_SUPPORTED;
-	lt.pc2 = dp->dpcd[DPCD_RC02] & DPCD_RC02_TPS3_SUPPORTED;
+	if (disp->engine.subdev.device->chipset >= 0xd0)
+		lt.pc2 = dp->dpcd[DPCD_RC02] & DPCD_RC02_TPS3_SUPPORTED;
 
 	/* Set desired link configuration on the source. */
 	if ((lnkcmp = lt.dp->info.lnkcmp)) {
@@ -278,12 +321,24 @@ nvkm_dp_train_links(struct nvkm_dp *dp)
 	if (ret)
 		return ret;
 
-	/* Attempt to train the link in this configuration. */
+	/* Attempt to train the link in this configuration, starting from
+	 * the drive levels that worked last time if we have them.
+	 */
 	memset(lt.stat, 0x00, sizeof(lt.stat));
+	for (i = 0; ltc && i < ior->dp.nr; i++) {
+		u8 lpre = (ltc->conf[i] & DPCD_LC03_PRE_EMPHASIS_SET) >> 3;
+		u8 lvsw = (ltc->conf[i] & DPCD_LC03_VOLTAGE_SWING_SET);
+		u8 lpc2 = (ltc->pc2conf[i >> 1] >> ((i & 1) * 4)) & 0x3;
+		lt.stat[4 + (i >> 1)] |= ((lpre << 2) | lvsw) << ((i & 1) * 4);
+		lt.pc2stat |= lpc2 << (i * 2);
+	}
+
 	ret = nvkm_dp_train_cr(&lt);
 	if (ret == 0)
 		ret = nvkm_dp_train_eq(&lt);
 	nvkm_dp_train_pattern(&lt, 0);
+	if (ret == 0)
+		nvkm_dp_ltc_add(dp, &lt);
 	return ret;
 }
 
@@ -350,6 +405,7 @@ nvkm_dp_train(struct nvkm_dp *dp, u32 dataKBps)
 	const u8 outp_nr = dp->outp.info.dpconf.link_nr;
 	const u8 outp_bw = dp->outp.info.dpconf.link_bw;
 	const struct dp_rates *failsafe = NULL, *cfg;
+	struct nvkm_dp_ltc *ltc;
 	int ret = -EINVAL;
 	u8  pwr;
 
@@ -394,6 +450,29 @@ nvkm_dp_train(struct nvkm_dp *dp, u32 dataKBps)
 	OUTP_DBG(&dp->outp, "training (min: %d x %d MB/s)",
 		 failsafe->nr, failsafe->bw * 27);
 	nvkm_dp_train_init(dp);
+
+	/* Try the configuration that last trained with this sink first,
+	 * and only fall back to searching for one if it no longer works.
+	 */
+	if ((ltc = nvkm_dp_ltc_find(dp))) {
+		for (cfg = nvkm_dp_rates; cfg <= failsafe; cfg++) {
+			if (cfg->nr == ltc->nr && cfg->bw == ltc->bw &&
+			    cfg->nr <= outp_nr && cfg->bw <= outp_bw) {
+				OUTP_DBG(&dp->outp, "training (cached)");
+				ior->dp.mst = dp->lt.mst;
+				ior->dp.ef = dp->dpcd[DPCD_RC02] &
+					     DPCD_RC02_ENHANCED_FRAME_CAP;
+				ior->dp.bw = cfg->bw;
+				ior->dp.nr = cfg->nr;
+				ret = nvkm_dp_train_links(dp, ltc);
+				break;
+			}
+		}
+
+		if (ret < 0)
+			nvkm_dp_ltc_del(dp, ltc);
+	}
+
 	for (cfg = nvkm_dp_rates; ret < 0 && cfg <= failsafe; cfg++) {
 		/* Skip configurations not supported by both OR and sink. */
 		if ((cfg->nr > outp_nr || cfg->bw > outp_bw ||
@@ -408,7 +487,7 @@ nvkm_dp_train(struct nvkm_dp *dp, u32 dataKBps)
 		ior->dp.nr = cfg->nr;
 
 		/* Program selected link configuration. */
-		ret = nvkm_dp_train_links(dp);
+		ret = nvkm_dp_train_links(dp, NULL);
 	}
 	nvkm_dp_train_fini(dp);
 	if (ret < 0)
@@ -518,8 +597,12 @@ nvkm_dp_enable(struct nvkm_dp *dp, bool enable)
 		}
 
 		if (!nvkm_rdaux(aux, DPCD_RC00_DPCD_REV, dp->dpcd,
-				sizeof(dp->dpcd)))
+				sizeof(dp->dpcd))) {
+			if (nvkm_rdaux(aux, DPCD_SI00_IEEE_OUI, dp->sink,
+				       sizeof(dp->sink)))
+				memset(dp->sink, 0x00, sizeof(dp->sink));
 			return true;
+		}
 	}
 
 	if (dp->present) {
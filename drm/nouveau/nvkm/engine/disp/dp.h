@@ -22,12 +22,26 @@ struct nvkm_dp {
 	struct nvkm_notify hpd;
 	bool present;
 	u8 dpcd[16];
+	u8 sink[12];
 
 	struct mutex mutex;
 	struct {
 		atomic_t done;
 		bool mst;
 	} lt;
+
+	/* Link configurations that last trained successfully, keyed by the
+	 * identity of the sink they trained with, most-recent first.
+	 */
+	struct nvkm_dp_ltc {
+		u8 dpcd[16];
+		u8 sink[12];
+		u8 bw;
+		u8 nr;
+		u8 conf[4];
+		u8 pc2conf[2];
+	} ltc[4];
+	int ltc_nr;
 };
 
 int nvkm_dp_new(struct nvkm_disp *, int index, struct dcb_output *,
@@ -102,6 +116,9 @@ int nvkm_dp_new(struct nvkm_disp *, int index, struct dcb_output *,
 #define DPCD_LS0C_LANE1_POST_CURSOR2                                       0x0c
 #define DPCD_LS0C_LANE0_POST_CURSOR2                                       0x03
 
+/* DPCD Sink Identification */
+#define DPCD_SI00_IEEE_OUI                                              0x00400
+
 /* DPCD Sink Control */
 #define DPCD_SC00                                                       0x00600
 #define DPCD_SC00_SET_POWER                                                0x03
@@ -24,6 +24,7 @@
 #include "priv.h"
 
 #include <core/client.h>
+#include <core/gpuobj.h>
 #include <engine/fifo.h>
 
 #include <nvif/class.h>
@@ -89,10 +90,26 @@ nvkm_dma_oclass_fifo_get(struct nvkm_oclass *oclass, int index)
 	return count;
 }
 
+void
+nvkm_dma_ctx_prune(struct nvkm_dma *dma, bool all)
+{
+	struct nvkm_dma_ctx *ctx, *temp;
+
+	list_for_each_entry_safe(ctx, temp, &dma->ctx, head) {
+		if (all || kref_read(&ctx->gpuobj->memory->kref) == 1) {
+			list_del(&ctx->head);
+			nvkm_gpuobj_del(&ctx->gpuobj);
+			kfree(ctx);
+		}
+	}
+}
+
 static void *
 nvkm_dma_dtor(struct nvkm_engine *engine)
 {
-	return nvkm_dma(engine);
+	struct nvkm_dma *dma = nvkm_dma(engine);
+	nvkm_dma_ctx_prune(dma, true);
+	return dma;
 }
 
 static const struct nvkm_engine_func
@@ -111,6 +128,8 @@ nvkm_dma_new_(const struct nvkm_dma_func *func, struct nvkm_device *device,
 	if (!(dma = *pdma = kzalloc(sizeof(*dma), GFP_KERNEL)))
 		return -ENOMEM;
 	dma->func = func;
+	mutex_init(&dma->mutex);
+	INIT_LIST_HEAD(&dma->ctx);
 
 	return nvkm_engine_ctor(&nvkm_dma, device, index, true, &dma->engine);
 }
@@ -9,6 +9,16 @@ struct nvkm_dmaobj_func {
 		    struct nvkm_gpuobj **);
 };
 
+struct nvkm_dma_ctx {
+	struct list_head head;
+	struct nvkm_gpuobj *gpuobj;
+	int align;
+	int size;
+	u32 data[6];
+};
+
+void nvkm_dma_ctx_prune(struct nvkm_dma *, bool all);
+
 int nvkm_dma_new_(const struct nvkm_dma_func *, struct nvkm_device *,
 		  int index, struct nvkm_dma **);
 
@@ -44,6 +44,80 @@ nvkm_dmaobj_search(struct nvkm_client *client, u64 handle)
 	return nvkm_dmaobj(object);
 }
 
+static int
+nvkm_dmaobj_ctx_new(struct nvkm_dmaobj *dmaobj, struct nvkm_gpuobj *parent,
+		    int align, const u32 *data, int size,
+		    struct nvkm_gpuobj **pgpuobj)
+{
+	struct nvkm_device *device = dmaobj->dma->engine.subdev.device;
+	int ret, i;
+
+	ret = nvkm_gpuobj_new(device, size * 4, align, false, parent, pgpuobj);
+	if (ret)
+		return ret;
+
+	nvkm_kmap(*pgpuobj);
+	for (i = 0; i < size; i++)
+		nvkm_wo32(*pgpuobj, i * 4, data[i]);
+	nvkm_done(*pgpuobj);
+	return 0;
+}
+
+/* Builds the hardware context for a DMA object from the words given.
+ *
+ * Contexts that need to live inside a parent gpuobj (a channel's or
+ * display's instance block) are private to that parent, but ones that
+ * can go anywhere in instance memory are shared between every binding
+ * with identical contents, so many channels referencing the same VRAM
+ * or GART range all point at a single object.
+ */
+int
+nvkm_dmaobj_ctx(struct nvkm_dmaobj *dmaobj, struct nvkm_gpuobj *parent,
+		int align, const u32 *data, int size,
+		struct nvkm_gpuobj **pgpuobj)
+{
+	struct nvkm_dma *dma = dmaobj->dma;
+	struct nvkm_dma_ctx *ctx;
+	int ret;
+
+	if (parent || WARN_ON(size > ARRAY_SIZE(ctx->data)))
+		return nvkm_dmaobj_ctx_new(dmaobj, parent, align, data, size,
+					   pgpuobj);
+
+	mutex_lock(&dma->mutex);
+	list_for_each_entry(ctx, &dma->ctx, head) {
+		if (ctx->align == align && ctx->size == size &&
+		    !memcmp(ctx->data, data, size * 4)) {
+			list_move(&ctx->head, &dma->ctx);
+			goto done;
+		}
+	}
+
+	nvkm_dma_ctx_prune(dma, false);
+
+	if (!(ctx = kzalloc(sizeof(*ctx), GFP_KERNEL))) {
+		mutex_unlock(&dma->mutex);
+		return -ENOMEM;
+	}
+
+	ret = nvkm_dmaobj_ctx_new(dmaobj, NULL, align, data, size,
+				  &ctx->gpuobj);
+	if (ret) {
+		mutex_unlock(&dma->mutex);
+		kfree(ctx);
+		return ret;
+	}
+
+	ctx->align = align;
+	ctx->size = size;
+	memcpy(ctx->data, data, size * 4);
+	list_add(&ctx->head, &dma->ctx);
+done:
+	ret = nvkm_gpuobj_share(ctx->gpuobj, pgpuobj);
+	mutex_unlock(&dma->mutex);
+	return ret;
+}
+
 static int
 nvkm_dmaobj_bind(struct nvkm_object *base, struct nvkm_gpuobj *gpuobj,
 		 int align, struct nvkm_gpuobj **pgpuobj)
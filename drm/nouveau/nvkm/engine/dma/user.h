@@ -7,6 +7,8 @@
 int nvkm_dmaobj_ctor(const struct nvkm_dmaobj_func *, struct nvkm_dma *,
 		     const struct nvkm_oclass *, void **data, u32 *size,
 		     struct nvkm_dmaobj *);
+int nvkm_dmaobj_ctx(struct nvkm_dmaobj *, struct nvkm_gpuobj *parent,
+		    int align, const u32 *data, int size, struct nvkm_gpuobj **);
 
 int nv04_dmaobj_new(struct nvkm_dma *, const struct nvkm_oclass *, void *, u32,
 		    struct nvkm_dmaobj **);
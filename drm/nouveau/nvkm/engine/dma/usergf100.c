@@ -42,23 +42,17 @@ gf100_dmaobj_bind(struct nvkm_dmaobj *base, struct nvkm_gpuobj *parent,
 		  int align, struct nvkm_gpuobj **pgpuobj)
 {
 	struct gf100_dmaobj *dmaobj = gf100_dmaobj(base);
-	struct nvkm_device *device = dmaobj->base.dma->engine.subdev.device;
-	int ret;
-
-	ret = nvkm_gpuobj_new(device, 24, align, false, parent, pgpuobj);
-	if (ret == 0) {
-		nvkm_kmap(*pgpuobj);
-		nvkm_wo32(*pgpuobj, 0x00, dmaobj->flags0);
-		nvkm_wo32(*pgpuobj, 0x04, lower_32_bits(dmaobj->base.limit));
-		nvkm_wo32(*pgpuobj, 0x08, lower_32_bits(dmaobj->base.start));
-		nvkm_wo32(*pgpuobj, 0x0c, upper_32_bits(dmaobj->base.limit) << 24 |
-					  upper_32_bits(dmaobj->base.start));
-		nvkm_wo32(*pgpuobj, 0x10, 0x00000000);
-		nvkm_wo32(*pgpuobj, 0x14, dmaobj->flags5);
-		nvkm_done(*pgpuobj);
-	}
-
-	return ret;
+	const u32 data[6] = {
+		dmaobj->flags0,
+		lower_32_bits(dmaobj->base.limit),
+		lower_32_bits(dmaobj->base.start),
+		upper_32_bits(dmaobj->base.limit) << 24 |
+		upper_32_bits(dmaobj->base.start),
+		0x00000000,
+		dmaobj->flags5,
+	};
+
+	return nvkm_dmaobj_ctx(&dmaobj->base, parent, align, data, 6, pgpuobj);
 }
 
 static const struct nvkm_dmaobj_func
@@ -41,22 +41,13 @@ gf119_dmaobj_bind(struct nvkm_dmaobj *base, struct nvkm_gpuobj *parent,
 		  int align, struct nvkm_gpuobj **pgpuobj)
 {
 	struct gf119_dmaobj *dmaobj = gf119_dmaobj(base);
-	struct nvkm_device *device = dmaobj->base.dma->engine.subdev.device;
-	int ret;
-
-	ret = nvkm_gpuobj_new(device, 24, align, false, parent, pgpuobj);
-	if (ret == 0) {
-		nvkm_kmap(*pgpuobj);
-		nvkm_wo32(*pgpuobj, 0x00, dmaobj->flags0);
-		nvkm_wo32(*pgpuobj, 0x04, dmaobj->base.start >> 8);
-		nvkm_wo32(*pgpuobj, 0x08, dmaobj->base.limit >> 8);
-		nvkm_wo32(*pgpuobj, 0x0c, 0x00000000);
-		nvkm_wo32(*pgpuobj, 0x10, 0x00000000);
-		nvkm_wo32(*pgpuobj, 0x14, 0x00000000);
-		nvkm_done(*pgpuobj);
-	}
+	const u32 data[6] = {
+		dmaobj->flags0,
+		dmaobj->base.start >> 8,
+		dmaobj->base.limit >> 8,
+	};
 
-	return ret;
+	return nvkm_dmaobj_ctx(&dmaobj->base, parent, align, data, 6, pgpuobj);
 }
 
 static const struct nvkm_dmaobj_func
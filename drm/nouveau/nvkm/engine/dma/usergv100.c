@@ -39,23 +39,18 @@ gv100_dmaobj_bind(struct nvkm_dmaobj *base, struct nvkm_gpuobj *parent,
 		  int align, struct nvkm_gpuobj **pgpuobj)
 {
 	struct gv100_dmaobj *dmaobj = gv100_dmaobj(base);
-	struct nvkm_device *device = dmaobj->base.dma->engine.subdev.device;
 	u64 start = dmaobj->base.start >> 8;
 	u64 limit = dmaobj->base.limit >> 8;
-	int ret;
-
-	ret = nvkm_gpuobj_new(device, 24, align, false, parent, pgpuobj);
-	if (ret == 0) {
-		nvkm_kmap(*pgpuobj);
-		nvkm_wo32(*pgpuobj, 0x00, dmaobj->flags0);
-		nvkm_wo32(*pgpuobj, 0x04, lower_32_bits(start));
-		nvkm_wo32(*pgpuobj, 0x08, upper_32_bits(start));
-		nvkm_wo32(*pgpuobj, 0x0c, lower_32_bits(limit));
-		nvkm_wo32(*pgpuobj, 0x10, upper_32_bits(limit));
-		nvkm_done(*pgpuobj);
-	}
+	const u32 data[6] = {
+		dmaobj->flags0,
+		lower_32_bits(start),
+		upper_32_bits(start),
+		lower_32_bits(limit),
+		upper_32_bits(limit),
+		0x00000000,
+	};
 
-	return ret;
+	return nvkm_dmaobj_ctx(&dmaobj->base, parent, align, data, 6, pgpuobj);
 }
 
 static const struct nvkm_dmaobj_func
@@ -46,7 +46,7 @@ nv04_dmaobj_bind(struct nvkm_dmaobj *base, struct nvkm_gpuobj *parent,
 	u64 offset = dmaobj->base.start & 0xfffff000;
 	u64 adjust = dmaobj->base.start & 0x00000fff;
 	u32 length = dmaobj->base.limit - dmaobj->base.start;
-	int ret;
+	u32 data[4];
 
 	if (dmaobj->clone) {
 		struct nvkm_memory *pgt =
@@ -59,17 +59,11 @@ nv04_dmaobj_bind(struct nvkm_dmaobj *base, struct nvkm_gpuobj *parent,
 		nvkm_done(pgt);
 	}
 
-	ret = nvkm_gpuobj_new(device, 16, align, false, parent, pgpuobj);
-	if (ret == 0) {
-		nvkm_kmap(*pgpuobj);
-		nvkm_wo32(*pgpuobj, 0x00, dmaobj->flags0 | (adjust << 20));
-		nvkm_wo32(*pgpuobj, 0x04, length);
-		nvkm_wo32(*pgpuobj, 0x08, dmaobj->flags2 | offset);
-		nvkm_wo32(*pgpuobj, 0x0c, dmaobj->flags2 | offset);
-		nvkm_done(*pgpuobj);
-	}
-
-	return ret;
+	data[0] = dmaobj->flags0 | (adjust << 20);
+	data[1] = length;
+	data[2] = dmaobj->flags2 | offset;
+	data[3] = dmaobj->flags2 | offset;
+	return nvkm_dmaobj_ctx(&dmaobj->base, parent, align, data, 4, pgpuobj);
 }
 
 static const struct nvkm_dmaobj_func
@@ -1033,14 +1033,46 @@ gf100_gr_mmio(struct gf100_gr *gr, const struct gf100_gr_pack *p)
 	}
 }
 
+/* Waits for the ICMD interface to drain.  Bundles normally retire within
+ * a read or two, so the first few polls are back-to-back, and only then
+ * does it start backing off.
+ */
+static void
+gf100_gr_icmd_wait(struct gf100_gr *gr, u32 *polls)
+{
+	struct nvkm_device *device = gr->base.engine.subdev.device;
+	u32 delay = 1, spins = 0;
+
+	nvkm_msec(device, 2000,
+		(*polls)++;
+		if (!(nvkm_rd32(device, 0x400700) & 0x00000004))
+			break;
+		if (++spins > 8) {
+			udelay(delay);
+			delay = min(delay * 2, 16U);
+		}
+	);
+}
+
+/* Up to gr->icmd_depth bundles are submitted before checking that ICMD has
+ * gone idle.  It's not known whether a queued bundle latches the data
+ * register when its address is written or only once it executes, so the
+ * queue is drained before the data changes, as well as after a GO_IDLE
+ * bundle.  A depth of 1 is a busy check per bundle.
+ */
 void
 gf100_gr_icmd(struct gf100_gr *gr, const struct gf100_gr_pack *p)
 {
-	struct nvkm_device *device = gr->base.engine.subdev.device;
+	struct nvkm_subdev *subdev = &gr->base.engine.subdev;
+	struct nvkm_device *device = subdev->device;
 	const struct gf100_gr_pack *pack;
 	const struct gf100_gr_init *init;
-	u32 data = 0;
+	int depth = max(gr->icmd_depth, 1);
+	u32 data = 0, bundles = 0, polls = 0;
+	int queued = 0;
+	s64 time;
 
+	time = ktime_to_us(ktime_get());
 	nvkm_wr32(device, 0x400208, 0x80000000);
 
 	pack_for_each_init(init, pack, p) {
@@ -1048,27 +1080,40 @@ gf100_gr_icmd(struct gf100_gr *gr, const struct gf100_gr_pack *p)
 		u32 addr = init->addr;
 
 		if ((pack == p && init == p->init) || data != init->data) {
+			if (queued) {
+				gf100_gr_icmd_wait(gr, &polls);
+				queued = 0;
+			}
 			nvkm_wr32(device, 0x400204, init->data);
 			data = init->data;
 		}
 
 		while (addr < next) {
 			nvkm_wr32(device, 0x400200, addr);
+			bundles++;
 			/**
 			 * Wait for GR to go idle after submitting a
 			 * GO_IDLE bundle
 			 */
-			if ((addr & 0xffff) == 0xe100)
+			if ((addr & 0xffff) == 0xe100) {
 				gf100_gr_wait_idle(gr);
-			nvkm_msec(device, 2000,
-				if (!(nvkm_rd32(device, 0x400700) & 0x00000004))
-					break;
-			);
+				queued = depth;
+			}
+			if (++queued >= depth) {
+				gf100_gr_icmd_wait(gr, &polls);
+				queued = 0;
+			}
 			addr += init->pitch;
 		}
 	}
 
+	if (queued)
+		gf100_gr_icmd_wait(gr, &polls);
+
 	nvkm_wr32(device, 0x400208, 0x00000000);
+	time = ktime_to_us(ktime_get()) - time;
+	nvkm_debug(subdev, "icmd: %d bundles, %d polls, %lldus\n",
+		   bundles, polls, time);
 }
 
 void
@@ -2114,6 +2159,9 @@ gf100_gr_new_(const struct gf100_gr_fwif *fwif,
 
 	mutex_init(&gr->fecs.mutex);
 
+	gr->icmd_depth = nvkm_longopt(device->cfgopt, "NvGrIcmdDepth", 1);
+	gr->icmd_depth = clamp(gr->icmd_depth, 1, 32);
+
 	ret = nvkm_falcon_ctor(&gf100_gr_flcn, &gr->base.engine.subdev,
 			       "gpccs", 0x41a000, &gr->gpccs.falcon);
 	if (ret)
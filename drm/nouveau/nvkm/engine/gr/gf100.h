@@ -96,6 +96,9 @@ struct gf100_gr {
 
 	bool firmware;
 
+	/* ICMD bundles allowed in flight between busy checks */
+	int icmd_depth;
+
 	/*
 	 * Used if the register packs are loaded from NVIDIA fw instead of
 	 * using hardcoded arrays. To be allocated with vzalloc().
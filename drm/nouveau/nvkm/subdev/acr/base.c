@@ -211,6 +211,88 @@ nvkm_acr_cleanup(struct nvkm_acr *acr)
 	acr->wpr_fw = NULL;
 }
 
+/* Host-side staging buffer for WPR image construction.  The per-falcon
+ * sections are written here through the regular nvkm_memory accessors,
+ * and the result is then uploaded to the real WPR in a single copy.
+ */
+#define nvkm_acr_wpr(p) container_of((p), struct nvkm_acr_wpr, memory)
+
+struct nvkm_acr_wpr {
+	struct nvkm_memory memory;
+	u8 *data;
+	u32 size;
+};
+
+static u32
+nvkm_acr_wpr_rd32(struct nvkm_memory *memory, u64 offset)
+{
+	return *(u32 *)&nvkm_acr_wpr(memory)->data[offset];
+}
+
+static void
+nvkm_acr_wpr_wr32(struct nvkm_memory *memory, u64 offset, u32 data)
+{
+	*(u32 *)&nvkm_acr_wpr(memory)->data[offset] = data;
+}
+
+static const struct nvkm_memory_ptrs
+nvkm_acr_wpr_ptrs = {
+	.rd32 = nvkm_acr_wpr_rd32,
+	.wr32 = nvkm_acr_wpr_wr32,
+};
+
+static void
+nvkm_acr_wpr_release(struct nvkm_memory *memory)
+{
+}
+
+static void __iomem *
+nvkm_acr_wpr_acquire(struct nvkm_memory *memory)
+{
+	return nvkm_acr_wpr(memory)->data;
+}
+
+static u64
+nvkm_acr_wpr_size(struct nvkm_memory *memory)
+{
+	return nvkm_acr_wpr(memory)->size;
+}
+
+static void *
+nvkm_acr_wpr_dtor(struct nvkm_memory *memory)
+{
+	struct nvkm_acr_wpr *wpr = nvkm_acr_wpr(memory);
+	vfree(wpr->data);
+	return wpr;
+}
+
+static const struct nvkm_memory_func
+nvkm_acr_wpr_func = {
+	.dtor = nvkm_acr_wpr_dtor,
+	.size = nvkm_acr_wpr_size,
+	.acquire = nvkm_acr_wpr_acquire,
+	.release = nvkm_acr_wpr_release,
+};
+
+static int
+nvkm_acr_wpr_new(u32 size, struct nvkm_memory **pmemory)
+{
+	struct nvkm_acr_wpr *wpr;
+
+	if (!(wpr = kzalloc(sizeof(*wpr), GFP_KERNEL)))
+		return -ENOMEM;
+	*pmemory = &wpr->memory;
+
+	nvkm_memory_ctor(&nvkm_acr_wpr_func, &wpr->memory);
+	wpr->memory.ptrs = &nvkm_acr_wpr_ptrs;
+	wpr->size = size;
+
+	if (!(wpr->data = vzalloc(size)))
+		return -ENOMEM;
+
+	return 0;
+}
+
 static int
 nvkm_acr_oneinit(struct nvkm_subdev *subdev)
 {
@@ -219,8 +301,10 @@ nvkm_acr_oneinit(struct nvkm_subdev *subdev)
 	struct nvkm_acr_hsfw *hsfw;
 	struct nvkm_acr_lsfw *lsfw, *lsft;
 	struct nvkm_acr_lsf *lsf;
+	struct nvkm_memory *wpr = NULL;
 	u32 wpr_size = 0;
 	u64 falcons;
+	s64 time = ktime_to_ns(ktime_get());
 	int ret, i;
 
 	if (list_empty(&acr->hsfw)) {
@@ -295,28 +379,53 @@ nvkm_acr_oneinit(struct nvkm_subdev *subdev)
 	nvkm_debug(subdev, "WPR region is from 0x%llx-0x%llx (shadow 0x%llx)\n",
 		   acr->wpr_start, acr->wpr_end, acr->shadow_start);
 
-	/* Write WPR to ucode blob. */
-	nvkm_kmap(acr->wpr);
+	acr->time.layout = ktime_to_ns(ktime_get()) - time;
+	time = ktime_to_ns(ktime_get());
+
+	/* Construct WPR image in host memory. */
+	if (acr->wpr_fw)
+		wpr_size = max_t(u32, wpr_size, acr->wpr_fw->size);
+
+	ret = nvkm_acr_wpr_new(wpr_size, &wpr);
+	if (ret) {
+		nvkm_memory_unref(&wpr);
+		return ret;
+	}
+
+	swap(acr->wpr, wpr);
 	if (acr->wpr_fw && !acr->wpr_comp)
 		nvkm_wobj(acr->wpr, 0, acr->wpr_fw->data, acr->wpr_fw->size);
 
 	if (!acr->wpr_fw || acr->wpr_comp)
-		acr->func->wpr_build(acr, nvkm_acr_falcon(device));
-	acr->func->wpr_patch(acr, (s64)acr->wpr_start - acr->wpr_prev);
+		ret = acr->func->wpr_build(acr, nvkm_acr_falcon(device));
+	if (ret == 0)
+		acr->func->wpr_patch(acr, (s64)acr->wpr_start - acr->wpr_prev);
+	swap(acr->wpr, wpr);
 
-	if (acr->wpr_fw && acr->wpr_comp) {
-		nvkm_kmap(acr->wpr);
+	if (ret == 0 && acr->wpr_fw && acr->wpr_comp) {
 		for (i = 0; i < acr->wpr_fw->size; i += 4) {
-			u32 us = nvkm_ro32(acr->wpr, i);
+			u32 us = nvkm_ro32(wpr, i);
 			u32 fw = ((u32 *)acr->wpr_fw->data)[i/4];
 			if (fw != us) {
 				nvkm_warn(subdev, "%08x: %08x %08x\n",
 					  i, us, fw);
 			}
 		}
-		return -EINVAL;
+		ret = -EINVAL;
 	}
-	nvkm_done(acr->wpr);
+
+	acr->time.build = ktime_to_ns(ktime_get()) - time;
+	time = ktime_to_ns(ktime_get());
+
+	/* Upload WPR to ucode blob. */
+	if (ret == 0)
+		nvkm_wblk(acr->wpr, 0, nvkm_acr_wpr(wpr)->data, wpr_size);
+	nvkm_memory_unref(&wpr);
+	if (ret)
+		return ret;
+
+	acr->time.upload = ktime_to_ns(ktime_get()) - time;
+	time = ktime_to_ns(ktime_get());
 
 	/* Allocate instance block for ACR-related stuff. */
 	ret = nvkm_memory_new(device, NVKM_MEM_TARGET_INST, 0x1000, 0, true,
@@ -342,6 +451,13 @@ nvkm_acr_oneinit(struct nvkm_subdev *subdev)
 			return ret;
 	}
 
+	acr->time.hsfw = ktime_to_ns(ktime_get()) - time;
+	nvkm_debug(subdev, "lsfw %lldus layout %lldus build %lldus "
+			   "upload %lldus hsfw %lldus\n",
+		   acr->time.lsfw / 1000, acr->time.layout / 1000,
+		   acr->time.build / 1000, acr->time.upload / 1000,
+		   acr->time.hsfw / 1000);
+
 	/* Kill temporary data. */
 	nvkm_acr_cleanup(acr);
 	return 0;
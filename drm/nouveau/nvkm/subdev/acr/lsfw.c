@@ -92,6 +92,7 @@ nvkm_acr_lsfw_load_sig_image_desc_(struct nvkm_subdev *subdev,
 {
 	struct nvkm_acr *acr = subdev->device->acr;
 	struct nvkm_acr_lsfw *lsfw;
+	s64 time = ktime_to_ns(ktime_get());
 	int ret;
 
 	if (IS_ERR((lsfw = nvkm_acr_lsfw_add(func, acr, falcon, id))))
@@ -107,6 +108,7 @@ nvkm_acr_lsfw_load_sig_image_desc_(struct nvkm_subdev *subdev,
 
 	ret = nvkm_firmware_load_name(subdev, path, "desc", ver, pdesc);
 done:
+	acr->time.lsfw += ktime_to_ns(ktime_get()) - time;
 	if (ret) {
 		nvkm_acr_lsfw_del(lsfw);
 		return ERR_PTR(ret);
@@ -189,6 +191,7 @@ nvkm_acr_lsfw_load_bl_inst_data_sig(struct nvkm_subdev *subdev,
 	const struct nvfw_bin_hdr *hdr;
 	const struct nvfw_bl_desc *desc;
 	u32 *bldata;
+	s64 time = ktime_to_ns(ktime_get());
 	int ret;
 
 	if (IS_ERR((lsfw = nvkm_acr_lsfw_add(func, acr, falcon, id))))
@@ -244,6 +247,7 @@ nvkm_acr_lsfw_load_bl_inst_data_sig(struct nvkm_subdev *subdev,
 			  lsfw->ucode_size;
 
 done:
+	acr->time.lsfw += ktime_to_ns(ktime_get()) - time;
 	if (ret)
 		nvkm_acr_lsfw_del(lsfw);
 	nvkm_firmware_put(data);
@@ -200,5 +200,7 @@ nvkm_bios_new(struct nvkm_device *device, int index, struct nvkm_bios **pbios)
 	nvkm_info(&bios->subdev, "version %02x.%02x.%02x.%02x.%02x\n",
 		  bios->version.major, bios->version.chip,
 		  bios->version.minor, bios->version.micro, bios->version.patch);
+
+	nvbios_index(bios);
 	return 0;
 }
@@ -27,6 +27,16 @@
 int
 bit_entry(struct nvkm_bios *bios, u8 id, struct bit_entry *bit)
 {
+	if (bios->index.valid && id && id < ARRAY_SIZE(bios->index.bit)) {
+		if (bios->index.bit[id].id != id)
+			return bios->bit_offset ? -ENOENT : -EINVAL;
+		bit->id      = bios->index.bit[id].id;
+		bit->version = bios->index.bit[id].version;
+		bit->length  = bios->index.bit[id].length;
+		bit->offset  = bios->index.bit[id].offset;
+		return 0;
+	}
+
 	if (likely(bios->bit_offset)) {
 		u8  entries = nvbios_rd08(bios, bios->bit_offset + 10);
 		u32 entry   = bios->bit_offset + 12;
@@ -31,6 +31,9 @@ dcb_table(struct nvkm_bios *bios, u8 *ver, u8 *hdr, u8 *cnt, u8 *len)
 	struct nvkm_device *device = subdev->device;
 	u16 dcb = 0x0000;
 
+	if (bios->index.valid)
+		return nvbios_index_table(&bios->index.dcb, ver, hdr, cnt, len);
+
 	if (device->card_type > NV_04)
 		dcb = nvbios_rd16(bios, 0x36);
 	if (!dcb) {
@@ -30,7 +30,12 @@ u16
 dcb_gpio_table(struct nvkm_bios *bios, u8 *ver, u8 *hdr, u8 *cnt, u8 *len)
 {
 	u16 data = 0x0000;
-	u16 dcb = dcb_table(bios, ver, hdr, cnt, len);
+	u16 dcb;
+
+	if (bios->index.valid)
+		return nvbios_index_table(&bios->index.gpio, ver, hdr, cnt, len);
+
+	dcb = dcb_table(bios, ver, hdr, cnt, len);
 	if (dcb) {
 		if (*ver >= 0x30 && *hdr >= 0x0c)
 			data = nvbios_rd16(bios, dcb + 0x0a);
@@ -122,10 +127,15 @@ dcb_gpio_match(struct nvkm_bios *bios, int idx, u8 func, u8 line,
 	u8  hdr, cnt, i = 0;
 	u16 data;
 
-	while ((data = dcb_gpio_parse(bios, idx, i++, ver, len, gpio))) {
-		if ((line == 0xff || line == gpio->line) &&
-		    (func == 0xff || func == gpio->func))
-			return data;
+	if (bios->index.valid && idx == 0 && line == 0xff && func != 0xff) {
+		if ((i = bios->index.gpio_func[func]))
+			return dcb_gpio_parse(bios, idx, i - 1, ver, len, gpio);
+	} else {
+		while ((data = dcb_gpio_parse(bios, idx, i++, ver, len, gpio))) {
+			if ((line == 0xff || line == gpio->line) &&
+			    (func == 0xff || func == gpio->func))
+				return data;
+		}
 	}
 
 	/* DCB 2.2, fixed TVDAC GPIO data */
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "priv.h"
+
+#include <subdev/bios/bit.h>
+#include <subdev/bios/dcb.h>
+#include <subdev/bios/gpio.h>
+#include <subdev/bios/perf.h>
+#include <subdev/bios/pll.h>
+#include <subdev/bios/vmap.h>
+#include <subdev/bios/volt.h>
+
+static void
+nvbios_index_bit(struct nvkm_bios *bios)
+{
+	u8  entries = nvbios_rd08(bios, bios->bit_offset + 10);
+	u32 entry   = bios->bit_offset + 12;
+
+	while (entries--) {
+		u8 id = nvbios_rd08(bios, entry + 0);
+		if (id && id < ARRAY_SIZE(bios->index.bit) &&
+		    !bios->index.bit[id].id) {
+			bios->index.bit[id].id      = id;
+			bios->index.bit[id].version = nvbios_rd08(bios, entry + 1);
+			bios->index.bit[id].length  = nvbios_rd16(bios, entry + 2);
+			bios->index.bit[id].offset  = nvbios_rd16(bios, entry + 4);
+		}
+
+		entry += nvbios_rd08(bios, bios->bit_offset + 9);
+	}
+}
+
+static void
+nvbios_index_gpio(struct nvkm_bios *bios)
+{
+	struct nvbios_index_table *gpio = &bios->index.gpio;
+	struct dcb_gpio_func func;
+	u8  ver, len;
+	int i;
+
+	gpio->data = dcb_gpio_table(bios, &gpio->ver, &gpio->hdr,
+				    &gpio->cnt, &gpio->len);
+	if (!gpio->data)
+		return;
+
+	/* First entry for each function, as found by dcb_gpio_match(). */
+	for (i = 0; i < gpio->cnt; i++) {
+		if (!dcb_gpio_parse(bios, 0, i, &ver, &len, &func))
+			break;
+		if (!bios->index.gpio_func[func.func])
+			bios->index.gpio_func[func.func] = i + 1;
+	}
+}
+
+static void
+nvbios_index_pll(struct nvkm_bios *bios)
+{
+	struct nvbios_index_table *pll = &bios->index.pll;
+	u32 data;
+	int i;
+
+	pll->data = nvbios_pll_table(bios, &pll->ver, &pll->hdr,
+				     &pll->cnt, &pll->len);
+	if (!pll->data || pll->ver < 0x30 ||
+	    pll->cnt > ARRAY_SIZE(bios->index.pll_map))
+		return;
+
+	for (i = 0, data = pll->data + pll->hdr; i < pll->cnt; i++) {
+		bios->index.pll_map[i].type = nvbios_rd08(bios, data + 0);
+		bios->index.pll_map[i].reg  = nvbios_rd32(bios, data + 3);
+		data += pll->len;
+	}
+}
+
+void
+nvbios_index(struct nvkm_bios *bios)
+{
+	struct nvbios_index_table *table;
+
+	memset(&bios->index, 0x00, sizeof(bios->index));
+
+	if (bios->bit_offset)
+		nvbios_index_bit(bios);
+
+	table = &bios->index.dcb;
+	table->data = dcb_table(bios, &table->ver, &table->hdr,
+				&table->cnt, &table->len);
+
+	nvbios_index_gpio(bios);
+	nvbios_index_pll(bios);
+
+	table = &bios->index.perf;
+	table->data = nvbios_perf_table(bios, &table->ver, &table->hdr,
+					&table->cnt, &table->len,
+					&bios->index.perf_snr,
+					&bios->index.perf_ssz);
+
+	table = &bios->index.vmap;
+	table->data = nvbios_vmap_table(bios, &table->ver, &table->hdr,
+					&table->cnt, &table->len);
+
+	table = &bios->index.volt;
+	table->data = nvbios_volt_table(bios, &table->ver, &table->hdr,
+					&table->cnt, &table->len);
+
+	bios->index.valid = true;
+}
@@ -33,6 +33,12 @@ nvbios_perf_table(struct nvkm_bios *bios, u8 *ver, u8 *hdr,
 	struct bit_entry bit_P;
 	u32 perf = 0;
 
+	if (bios->index.valid) {
+		*snr = bios->index.perf_snr;
+		*ssz = bios->index.perf_ssz;
+		return nvbios_index_table(&bios->index.perf, ver, hdr, cnt, len);
+	}
+
 	if (!bit_entry(bios, 'P', &bit_P)) {
 		if (bit_P.version <= 2) {
 			perf = nvbios_rd32(bios, bit_P.offset + 0);
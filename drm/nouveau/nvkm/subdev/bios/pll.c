@@ -77,12 +77,15 @@ g84_pll_mapping[] = {
 	{}
 };
 
-static u32
-pll_limits_table(struct nvkm_bios *bios, u8 *ver, u8 *hdr, u8 *cnt, u8 *len)
+u32
+nvbios_pll_table(struct nvkm_bios *bios, u8 *ver, u8 *hdr, u8 *cnt, u8 *len)
 {
 	struct bit_entry bit_C;
 	u32 data = 0x0000;
 
+	if (bios->index.valid)
+		return nvbios_index_table(&bios->index.pll, ver, hdr, cnt, len);
+
 	if (!bit_entry(bios, 'C', &bit_C)) {
 		if (bit_C.version == 1 && bit_C.length >= 10)
 			data = nvbios_rd16(bios, bit_C.offset + 8);
@@ -146,10 +149,21 @@ pll_map_reg(struct nvkm_bios *bios, u32 reg, u32 *type, u8 *ver, u8 *len)
 	struct pll_mapping *map;
 	u8  hdr, cnt;
 	u32 data;
+	int i;
 
-	data = pll_limits_table(bios, ver, &hdr, &cnt, len);
+	data = nvbios_pll_table(bios, ver, &hdr, &cnt, len);
 	if (data && *ver >= 0x30) {
 		data += hdr;
+		if (bios->index.valid && cnt <= ARRAY_SIZE(bios->index.pll_map)) {
+			for (i = 0; i < cnt; i++, data += *len) {
+				if (bios->index.pll_map[i].reg == reg) {
+					*type = bios->index.pll_map[i].type;
+					return data;
+				}
+			}
+			return 0x0000;
+		}
+
 		while (cnt--) {
 			if (nvbios_rd32(bios, data + 3) == reg) {
 				*type = nvbios_rd08(bios, data + 0);
@@ -188,10 +202,24 @@ pll_map_type(struct nvkm_bios *bios, u8 type, u32 *reg, u8 *ver, u8 *len)
 	struct pll_mapping *map;
 	u8  hdr, cnt;
 	u32 data;
+	int i;
 
-	data = pll_limits_table(bios, ver, &hdr, &cnt, len);
+	data = nvbios_pll_table(bios, ver, &hdr, &cnt, len);
 	if (data && *ver >= 0x30) {
 		data += hdr;
+		if (bios->index.valid && cnt <= ARRAY_SIZE(bios->index.pll_map)) {
+			for (i = 0; i < cnt; i++, data += *len) {
+				if (bios->index.pll_map[i].type == type) {
+					if (*ver < 0x50)
+						*reg = bios->index.pll_map[i].reg;
+					else
+						*reg = 0;
+					return data;
+				}
+			}
+			return 0x0000;
+		}
+
 		while (cnt--) {
 			if (nvbios_rd08(bios, data + 0) == type) {
 				if (*ver < 0x50)
@@ -31,6 +31,9 @@ nvbios_vmap_table(struct nvkm_bios *bios, u8 *ver, u8 *hdr, u8 *cnt, u8 *len)
 	struct bit_entry bit_P;
 	u32 vmap = 0;
 
+	if (bios->index.valid)
+		return nvbios_index_table(&bios->index.vmap, ver, hdr, cnt, len);
+
 	if (!bit_entry(bios, 'P', &bit_P)) {
 		if (bit_P.version == 2) {
 			vmap = nvbios_rd32(bios, bit_P.offset + 0x20);
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "pll.h"
+
+#include <subdev/bios.h>
+#include <subdev/bios/pll.h>
+
+/* Results of the PLL coefficient solvers, keyed by every input that can
+ * affect them.  The cache is shared between devices, as boards of the same
+ * type end up asking for the same frequencies against the same limits, and
+ * is direct-mapped - a colliding entry simply replaces the previous one.
+ */
+#define NVKM_PLL_CACHE_BITS 8
+
+static struct nvkm_pll_cache {
+	struct nvkm_pll_key key;
+	int val[6];
+	bool valid;
+} nvkm_pll_cache[1 << NVKM_PLL_CACHE_BITS];
+static DEFINE_MUTEX(nvkm_pll_cache_mutex);
+
+static struct nvkm_pll_cache *
+nvkm_pll_cache_slot(const struct nvkm_pll_key *key)
+{
+	const u32 *data = (const u32 *)key;
+	u64 hash = 0xcbf29ce484222325ULL;
+	int i;
+
+	for (i = 0; i < sizeof(*key) / sizeof(*data); i++)
+		hash = (hash ^ data[i]) * 0x100000001b3ULL;
+
+	return &nvkm_pll_cache[hash_64(hash, NVKM_PLL_CACHE_BITS)];
+}
+
+void
+nvkm_pll_key(struct nvkm_subdev *subdev, struct nvbios_pll *info,
+	     enum nvkm_pll_type type, u32 freq, struct nvkm_pll_key *key)
+{
+	struct nvkm_bios *bios = subdev->device->bios;
+	int i;
+
+	key->type = type;
+	key->freq = freq;
+	key->bios = bios ? (bios->version.major << 8) | bios->version.chip : 0;
+	key->refclk = info->refclk;
+	key->p = (info->min_p << 16) | (info->max_p << 8) | info->max_p_usable;
+
+	for (i = 0; i < 2; i++) {
+		typeof(info->vco1) *vco = i ? &info->vco2 : &info->vco1;
+		key->vco[i][0] = vco->min_freq;
+		key->vco[i][1] = vco->max_freq;
+		key->vco[i][2] = vco->min_inputfreq;
+		key->vco[i][3] = vco->max_inputfreq;
+		key->vco[i][4] = (vco->max_n << 24) | (vco->min_n << 16) |
+				 (vco->max_m <<  8) | (vco->min_m << 0);
+	}
+}
+
+bool
+nvkm_pll_cache_get(const struct nvkm_pll_key *key, int *val, int nr)
+{
+	struct nvkm_pll_cache *slot = nvkm_pll_cache_slot(key);
+	bool hit = false;
+
+	mutex_lock(&nvkm_pll_cache_mutex);
+	if (slot->valid && !memcmp(&slot->key, key, sizeof(*key))) {
+		memcpy(val, slot->val, nr * sizeof(*val));
+		hit = true;
+	}
+	mutex_unlock(&nvkm_pll_cache_mutex);
+	return hit;
+}
+
+void
+nvkm_pll_cache_put(const struct nvkm_pll_key *key, const int *val, int nr)
+{
+	struct nvkm_pll_cache *slot = nvkm_pll_cache_slot(key);
+
+	if (WARN_ON(nr > ARRAY_SIZE(slot->val)))
+		return;
+
+	mutex_lock(&nvkm_pll_cache_mutex);
+	slot->key = *key;
+	memcpy(slot->val, val, nr * sizeof(*val));
+	slot->valid = true;
+	mutex_unlock(&nvkm_pll_cache_mutex);
+}
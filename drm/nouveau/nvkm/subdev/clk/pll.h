@@ -5,6 +5,27 @@
 struct nvkm_subdev;
 struct nvbios_pll;
 
+enum nvkm_pll_type {
+	NVKM_PLL_NV04_SINGLE,
+	NVKM_PLL_NV04,
+	NVKM_PLL_GT215,
+	NVKM_PLL_GT215_FRAC,
+};
+
+struct nvkm_pll_key {
+	u32 type;
+	u32 freq;
+	u32 bios;
+	u32 refclk;
+	u32 p;
+	u32 vco[2][5];
+};
+
+void nvkm_pll_key(struct nvkm_subdev *, struct nvbios_pll *,
+		  enum nvkm_pll_type, u32 freq, struct nvkm_pll_key *);
+bool nvkm_pll_cache_get(const struct nvkm_pll_key *, int *val, int nr);
+void nvkm_pll_cache_put(const struct nvkm_pll_key *, const int *val, int nr);
+
 int nv04_pll_calc(struct nvkm_subdev *, struct nvbios_pll *, u32 freq,
 		  int *N1, int *M1, int *N2, int *M2, int *P);
 int gt215_pll_calc(struct nvkm_subdev *, struct nvbios_pll *, u32 freq,
@@ -26,9 +26,9 @@
 #include <subdev/bios.h>
 #include <subdev/bios/pll.h>
 
-int
-gt215_pll_calc(struct nvkm_subdev *subdev, struct nvbios_pll *info,
-	       u32 freq, int *pN, int *pfN, int *pM, int *P)
+static int
+gt215_pll_calc_(struct nvkm_subdev *subdev, struct nvbios_pll *info,
+		u32 freq, int *pN, int *pfN, int *pM, int *P)
 {
 	u32 best_err = ~0, err;
 	int M, lM, hM, N, fN;
@@ -85,3 +85,34 @@ gt215_pll_calc(struct nvkm_subdev *subdev, struct nvbios_pll *info,
 
 	return info->refclk * *pN / *pM / *P;
 }
+
+int
+gt215_pll_calc(struct nvkm_subdev *subdev, struct nvbios_pll *info,
+	       u32 freq, int *pN, int *pfN, int *pM, int *P)
+{
+	struct nvkm_pll_key key;
+	int val[5], ret;
+
+	nvkm_pll_key(subdev, info, pfN ? NVKM_PLL_GT215_FRAC : NVKM_PLL_GT215,
+		     freq, &key);
+	if (nvkm_pll_cache_get(&key, val, ARRAY_SIZE(val))) {
+		*pN = val[0];
+		if (pfN)
+			*pfN = val[1];
+		*pM = val[2];
+		*P = val[3];
+		return val[4];
+	}
+
+	ret = gt215_pll_calc_(subdev, info, freq, pN, pfN, pM, P);
+	if (ret >= 0) {
+		val[0] = *pN;
+		val[1] = pfN ? *pfN : 0;
+		val[2] = *pM;
+		val[3] = *P;
+		val[4] = ret;
+		nvkm_pll_cache_put(&key, val, ARRAY_SIZE(val));
+	}
+
+	return ret;
+}
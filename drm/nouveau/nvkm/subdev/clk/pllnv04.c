@@ -223,9 +223,9 @@ getMNP_double(struct nvkm_subdev *subdev, struct nvbios_pll *info, int clk,
 	return bestclk;
 }
 
-int
-nv04_pll_calc(struct nvkm_subdev *subdev, struct nvbios_pll *info, u32 freq,
-	      int *N1, int *M1, int *N2, int *M2, int *P)
+static int
+nv04_pll_calc_(struct nvkm_subdev *subdev, struct nvbios_pll *info, u32 freq,
+	       int *N1, int *M1, int *N2, int *M2, int *P)
 {
 	int ret;
 
@@ -243,3 +243,37 @@ nv04_pll_calc(struct nvkm_subdev *subdev, struct nvbios_pll *info, u32 freq,
 		nvkm_error(subdev, "unable to compute acceptable pll values\n");
 	return ret;
 }
+
+int
+nv04_pll_calc(struct nvkm_subdev *subdev, struct nvbios_pll *info, u32 freq,
+	      int *N1, int *M1, int *N2, int *M2, int *P)
+{
+	struct nvkm_pll_key key;
+	int val[6], ret;
+
+	nvkm_pll_key(subdev, info, N2 ? NVKM_PLL_NV04 : NVKM_PLL_NV04_SINGLE,
+		     freq, &key);
+	if (nvkm_pll_cache_get(&key, val, ARRAY_SIZE(val))) {
+		*N1 = val[0];
+		*M1 = val[1];
+		if (N2) {
+			*N2 = val[2];
+			*M2 = val[3];
+		}
+		*P = val[4];
+		return val[5];
+	}
+
+	ret = nv04_pll_calc_(subdev, info, freq, N1, M1, N2, M2, P);
+	if (ret) {
+		val[0] = *N1;
+		val[1] = *M1;
+		val[2] = N2 ? *N2 : 0;
+		val[3] = N2 ? *M2 : 0;
+		val[4] = *P;
+		val[5] = ret;
+		nvkm_pll_cache_put(&key, val, ARRAY_SIZE(val));
+	}
+
+	return ret;
+}
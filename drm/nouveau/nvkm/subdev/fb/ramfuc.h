@@ -67,6 +67,29 @@ ramfuc_init(struct ramfuc *ram, struct nvkm_fb *fb)
 	return 0;
 }
 
+/* Replays the script last built for this transition, if none of the
+ * registers it read have changed since.
+ */
+static inline int
+ramfuc_cached(struct ramfuc *ram, struct nvkm_fb *fb, u32 from, u32 to,
+	      u32 band)
+{
+	int ret = nvkm_memx_cached(fb->subdev.device->pmu, from, to, band,
+				   &ram->memx);
+	if (ret)
+		return ret;
+
+	ram->sequence++;
+	ram->fb = fb;
+	return 0;
+}
+
+static inline void
+ramfuc_key(struct ramfuc *ram, u32 from, u32 to, u32 band)
+{
+	nvkm_memx_key(ram->memx, from, to, band);
+}
+
 static inline int
 ramfuc_exec(struct ramfuc *ram, bool exec)
 {
@@ -82,8 +105,10 @@ static inline u32
 ramfuc_rd32(struct ramfuc *ram, struct ramfuc_reg *reg)
 {
 	struct nvkm_device *device = ram->fb->subdev.device;
-	if (reg->sequence != ram->sequence)
+	if (reg->sequence != ram->sequence) {
 		reg->data = nvkm_rd32(device, reg->addr);
+		nvkm_memx_input(ram->memx, reg->addr, reg->data);
+	}
 	return reg->data;
 }
 
@@ -162,6 +187,8 @@ ramfuc_unblock(struct ramfuc *ram)
 }
 
 #define ram_init(s,p)        ramfuc_init(&(s)->base, (p))
+#define ram_cached(s,p,f,t,b) ramfuc_cached(&(s)->base, (p), (f), (t), (b))
+#define ram_key(s,f,t,b)     ramfuc_key(&(s)->base, (f), (t), (b))
 #define ram_exec(s,e)        ramfuc_exec(&(s)->base, (e))
 #define ram_have(s,r)        ((s)->r_##r.addr != 0x000000)
 #define ram_rd32(s,r)        ramfuc_rd32(&(s)->base, &(s)->r_##r)
@@ -347,16 +347,16 @@ gt215_link_train_fini(struct gt215_ram *ram)
 static int
 gt215_ram_timing_calc(struct gt215_ram *ram, u32 *timing)
 {
+	struct gt215_ramfuc *fuc = &ram->fuc;
 	struct nvbios_ramcfg *cfg = &ram->base.target.bios;
 	struct nvkm_subdev *subdev = &ram->base.fb->subdev;
-	struct nvkm_device *device = subdev->device;
 	int tUNK_base, tUNK_40_0, prevCL;
 	u32 cur2, cur3, cur7, cur8;
 
-	cur2 = nvkm_rd32(device, 0x100228);
-	cur3 = nvkm_rd32(device, 0x10022c);
-	cur7 = nvkm_rd32(device, 0x10023c);
-	cur8 = nvkm_rd32(device, 0x100240);
+	cur2 = ram_rd32(fuc, 0x100220[2]);
+	cur3 = ram_rd32(fuc, 0x100220[3]);
+	cur7 = ram_rd32(fuc, 0x100220[7]);
+	cur8 = ram_rd32(fuc, 0x100220[8]);
 
 
 	switch ((!T(CWL)) * ram->base.type) {
@@ -504,6 +504,7 @@ gt215_ram_calc(struct nvkm_ram *base, u32 freq)
 	u32 data;
 	u32 r004018, r100760, r100da0, r111100, ctrl;
 	u32 unk714, unk718, unk71c;
+	u32 band;
 	int ret, i;
 	u32 timing[9];
 	bool pll2pll;
@@ -554,12 +555,24 @@ gt215_ram_calc(struct nvkm_ram *base, u32 freq)
 		return ret;
 	}
 
-	gt215_ram_timing_calc(ram, timing);
+	/* The script is a function of the registers it reads, which memx
+	 * tracks, and of the state below.
+	 */
+	band = (train->state == NVA3_TRAIN_DONE) |
+	       (nvkm_gpio_get(gpio, 0, 0x18, DCB_GPIO_UNUSED) ==
+		next->bios.ramcfg_FBVDDQ) << 1;
+
+	ret = ram_cached(fuc, ram->base.fb, ram->base.freq, freq, band);
+	if (ret == 0)
+		return 0;
 
 	ret = ram_init(fuc, ram->base.fb);
 	if (ret)
 		return ret;
 
+	ram_key(fuc, ram->base.freq, freq, band);
+	gt215_ram_timing_calc(ram, timing);
+
 	/* Determine ram-specific MR values */
 	ram->base.mr[0] = ram_rd32(fuc, mr[0]);
 	ram->base.mr[1] = ram_rd32(fuc, mr[1]);
@@ -659,8 +672,7 @@ gt215_ram_calc(struct nvkm_ram *base, u32 freq)
 
 	/* Alter FBVDD/Q, apparently must be done with PLL disabled, thus
 	 * set it to bypass */
-	if (nvkm_gpio_get(gpio, 0, 0x18, DCB_GPIO_UNUSED) ==
-			next->bios.ramcfg_FBVDDQ) {
+	if (band & 2) {
 		data = ram_rd32(fuc, 0x004000) & 0x9;
 
 		if (data == 0x1)
@@ -890,7 +902,8 @@ gt215_ram_prog(struct nvkm_ram *base)
 	if (exec) {
 		nvkm_mask(device, 0x001534, 0x2, 0x2);
 
-		ram_exec(fuc, true);
+		if (ram_exec(fuc, true) == 0)
+			ram->base.freq = ram->base.next->freq;
 
 		/* Post-processing, avoids flicker */
 		nvkm_mask(device, 0x002504, 0x1, 0x0);
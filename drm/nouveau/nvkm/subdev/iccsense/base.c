@@ -23,11 +23,13 @@
  */
 #include "priv.h"
 
+#include <core/option.h>
 #include <subdev/bios.h>
 #include <subdev/bios/extdev.h>
 #include <subdev/bios/iccsense.h>
 #include <subdev/bios/power_budget.h>
 #include <subdev/i2c.h>
+#include <subdev/timer.h>
 
 static bool
 nvkm_iccsense_validate_device(struct i2c_adapter *i2c, u8 addr,
@@ -46,54 +48,126 @@ nvkm_iccsense_validate_device(struct i2c_adapter *i2c, u8 addr,
 }
 
 static int
-nvkm_iccsense_poll_lane(struct i2c_adapter *i2c, u8 addr, u8 shunt_reg,
-			u8 shunt_shift, u8 bus_reg, u8 bus_shift, u8 shunt,
-			u16 lsb)
+nvkm_iccsense_rail_power(struct nvkm_iccsense_rail *rail, int vshunt, int vbus)
 {
-	int vshunt = nv_rd16i2cr(i2c, addr, shunt_reg);
-	int vbus = nv_rd16i2cr(i2c, addr, bus_reg);
+	vshunt >>= rail->shunt_shift;
+	vbus >>= rail->bus_shift;
+
+	return vbus * vshunt * rail->lsb / rail->mohm;
+}
+
+static int
+nvkm_iccsense_rail_read(struct nvkm_iccsense_rail *rail)
+{
+	struct nvkm_iccsense_sensor *sensor = rail->sensor;
+	int vshunt = nv_rd16i2cr(sensor->i2c, sensor->addr, rail->shunt_reg);
+	int vbus = nv_rd16i2cr(sensor->i2c, sensor->addr, rail->bus_reg);
 
 	if (vshunt < 0 || vbus < 0)
 		return -EINVAL;
 
-	vshunt >>= shunt_shift;
-	vbus >>= bus_shift;
-
-	return vbus * vshunt * lsb / shunt;
+	return nvkm_iccsense_rail_power(rail, vshunt, vbus);
 }
 
+/* Reads the shunt and bus registers of every rail behind an I2C bus in
+ * a single transfer, so a sampling pass acquires each bus once.
+ */
 static int
-nvkm_iccsense_ina2x9_read(struct nvkm_iccsense *iccsense,
-                          struct nvkm_iccsense_rail *rail,
-			  u8 shunt_reg, u8 bus_reg)
+nvkm_iccsense_xfer(struct nvkm_iccsense *iccsense, struct i2c_adapter *i2c)
 {
-	return nvkm_iccsense_poll_lane(rail->sensor->i2c, rail->sensor->addr,
-				       shunt_reg, 0, bus_reg, 3, rail->mohm,
-				       10 * 4);
+	struct nvkm_iccsense_rail *rail;
+	struct i2c_msg *msg = iccsense->msg;
+	int num = 0, i;
+
+	list_for_each_entry(rail, &iccsense->rails, head) {
+		if (rail->sensor->i2c != i2c)
+			continue;
+
+		rail->reg[0] = rail->shunt_reg;
+		rail->reg[1] = rail->bus_reg;
+		for (i = 0; i < 2; i++) {
+			msg[num].addr = rail->sensor->addr;
+			msg[num].flags = 0;
+			msg[num].len = 1;
+			msg[num++].buf = &rail->reg[i];
+			msg[num].addr = rail->sensor->addr;
+			msg[num].flags = I2C_M_RD;
+			msg[num].len = 2;
+			msg[num++].buf = rail->val[i];
+		}
+	}
+
+	if (i2c_transfer(i2c, msg, num) != num)
+		return -EIO;
+	return 0;
 }
 
-static int
-nvkm_iccsense_ina209_read(struct nvkm_iccsense *iccsense,
-			  struct nvkm_iccsense_rail *rail)
+static void
+nvkm_iccsense_sample_locked(struct nvkm_iccsense *iccsense, u64 time)
 {
-	return nvkm_iccsense_ina2x9_read(iccsense, rail, 3, 4);
+	struct nvkm_subdev *subdev = &iccsense->subdev;
+	struct nvkm_iccsense_rail *rail;
+	struct i2c_adapter *i2c = NULL;
+	int power = 0, error = 0, ret = 0;
+
+	list_for_each_entry(rail, &iccsense->rails, head) {
+		int res;
+
+		if (rail->sensor->i2c != i2c) {
+			i2c = rail->sensor->i2c;
+			ret = nvkm_iccsense_xfer(iccsense, i2c);
+		}
+
+		/* A failed batch is retried rail by rail, and a rail that
+		 * still can't be read reports its previous value rather
+		 * than failing the whole reading.
+		 */
+		if (ret == 0) {
+			res = nvkm_iccsense_rail_power(rail,
+					rail->val[0][0] << 8 | rail->val[0][1],
+					rail->val[1][0] << 8 | rail->val[1][1]);
+		} else {
+			res = nvkm_iccsense_rail_read(rail);
+		}
+
+		if (res >= 0)
+			rail->power = res;
+		else
+			nvkm_trace(subdev, "extdev %i idx %i: %d\n",
+				   rail->sensor->id, rail->idx, res);
+
+		if (rail->power >= 0)
+			power += rail->power;
+		else if (!error)
+			error = rail->power;
+	}
+
+	iccsense->power = error ? error : power;
+	iccsense->time = time;
 }
 
-static int
-nvkm_iccsense_ina219_read(struct nvkm_iccsense *iccsense,
-			  struct nvkm_iccsense_rail *rail)
+int
+nvkm_iccsense_sample(struct nvkm_iccsense *iccsense)
 {
-	return nvkm_iccsense_ina2x9_read(iccsense, rail, 1, 2);
+	struct nvkm_timer *tmr = iccsense->subdev.device->timer;
+	int power;
+
+	mutex_lock(&iccsense->mutex);
+	nvkm_iccsense_sample_locked(iccsense, nvkm_timer_read(tmr));
+	power = iccsense->power;
+	mutex_unlock(&iccsense->mutex);
+	return power;
 }
 
-static int
-nvkm_iccsense_ina3221_read(struct nvkm_iccsense *iccsense,
-			   struct nvkm_iccsense_rail *rail)
+static void
+nvkm_iccsense_rail_lane(struct nvkm_iccsense_rail *rail, u8 shunt_reg,
+			u8 shunt_shift, u8 bus_reg, u8 bus_shift, u16 lsb)
 {
-	return nvkm_iccsense_poll_lane(rail->sensor->i2c, rail->sensor->addr,
-				       1 + (rail->idx * 2), 3,
-				       2 + (rail->idx * 2), 3, rail->mohm,
-				       40 * 8);
+	rail->shunt_reg = shunt_reg;
+	rail->shunt_shift = shunt_shift;
+	rail->bus_reg = bus_reg;
+	rail->bus_shift = bus_shift;
+	rail->lsb = lsb;
 }
 
 static void
@@ -108,23 +182,21 @@ nvkm_iccsense_sensor_config(struct nvkm_iccsense *iccsense,
 int
 nvkm_iccsense_read_all(struct nvkm_iccsense *iccsense)
 {
-	int result = 0;
-	struct nvkm_iccsense_rail *rail;
+	struct nvkm_timer *tmr;
+	u64 time;
+	int power;
 
 	if (!iccsense)
 		return -EINVAL;
 
-	list_for_each_entry(rail, &iccsense->rails, head) {
-		int res;
-		if (!rail->read)
-			return -ENODEV;
-
-		res = rail->read(iccsense, rail);
-		if (res < 0)
-			return res;
-		result += res;
-	}
-	return result;
+	tmr = iccsense->subdev.device->timer;
+	mutex_lock(&iccsense->mutex);
+	time = nvkm_timer_read(tmr);
+	if (!iccsense->time || time - iccsense->time >= iccsense->period)
+		nvkm_iccsense_sample_locked(iccsense, time);
+	power = iccsense->power;
+	mutex_unlock(&iccsense->mutex);
+	return power;
 }
 
 static void *
@@ -143,6 +215,7 @@ nvkm_iccsense_dtor(struct nvkm_subdev *subdev)
 		kfree(rail);
 	}
 
+	kfree(iccsense->msg);
 	return iccsense;
 }
 
@@ -219,7 +292,7 @@ nvkm_iccsense_oneinit(struct nvkm_subdev *subdev)
 	struct nvkm_bios *bios = subdev->device->bios;
 	struct nvbios_power_budget budget;
 	struct nvbios_iccsense stbl;
-	int i, ret;
+	int nr_rail = 0, i, ret;
 
 	if (!bios)
 		return 0;
@@ -257,40 +330,56 @@ nvkm_iccsense_oneinit(struct nvkm_subdev *subdev)
 			nvkm_error(subdev, "config mismatch found for extdev %i\n", pwr_rail->extdev_id);
 
 		for (r = 0; r < pwr_rail->resistor_count; ++r) {
-			struct nvkm_iccsense_rail *rail;
+			struct nvkm_iccsense_rail *rail, *prev;
+			struct list_head *head = iccsense->rails.prev;
 			struct pwr_rail_resistor_t *res = &pwr_rail->resistors[r];
-			int (*read)(struct nvkm_iccsense *,
-				    struct nvkm_iccsense_rail *);
 
 			if (!res->mohm || !res->enabled)
 				continue;
 
-			switch (sensor->type) {
-			case NVBIOS_EXTDEV_INA209:
-				read = nvkm_iccsense_ina209_read;
-				break;
-			case NVBIOS_EXTDEV_INA219:
-				read = nvkm_iccsense_ina219_read;
-				break;
-			case NVBIOS_EXTDEV_INA3221:
-				read = nvkm_iccsense_ina3221_read;
-				break;
-			default:
+			if (sensor->type != NVBIOS_EXTDEV_INA209 &&
+			    sensor->type != NVBIOS_EXTDEV_INA219 &&
+			    sensor->type != NVBIOS_EXTDEV_INA3221)
 				continue;
-			}
 
 			rail = kmalloc(sizeof(*rail), GFP_KERNEL);
 			if (!rail)
 				return -ENOMEM;
 
-			rail->read = read;
 			rail->sensor = sensor;
 			rail->idx = r;
 			rail->mohm = res->mohm;
+			rail->power = -ENODATA;
+			switch (sensor->type) {
+			case NVBIOS_EXTDEV_INA209:
+				nvkm_iccsense_rail_lane(rail, 3, 0, 4, 3, 10 * 4);
+				break;
+			case NVBIOS_EXTDEV_INA219:
+				nvkm_iccsense_rail_lane(rail, 1, 0, 2, 3, 10 * 4);
+				break;
+			default:
+				nvkm_iccsense_rail_lane(rail, 1 + (r * 2), 3,
+							2 + (r * 2), 3, 40 * 8);
+				break;
+			}
 			nvkm_debug(subdev, "create rail for extdev %i: { idx: %i, mohm: %i }\n", pwr_rail->extdev_id, r, rail->mohm);
-			list_add_tail(&rail->head, &iccsense->rails);
+
+			/* keep rails grouped by bus, for nvkm_iccsense_xfer() */
+			list_for_each_entry(prev, &iccsense->rails, head) {
+				if (prev->sensor->i2c == sensor->i2c)
+					head = &prev->head;
+			}
+			list_add(&rail->head, head);
+			nr_rail++;
 		}
 	}
+
+	if (nr_rail) {
+		iccsense->msg = kcalloc(nr_rail * 4, sizeof(*iccsense->msg),
+					GFP_KERNEL);
+		if (!iccsense->msg)
+			return -ENOMEM;
+	}
 	return 0;
 }
 
@@ -304,10 +393,21 @@ nvkm_iccsense_init(struct nvkm_subdev *subdev)
 	return 0;
 }
 
+static int
+nvkm_iccsense_fini(struct nvkm_subdev *subdev, bool suspend)
+{
+	struct nvkm_iccsense *iccsense = nvkm_iccsense(subdev);
+	mutex_lock(&iccsense->mutex);
+	iccsense->time = 0;
+	mutex_unlock(&iccsense->mutex);
+	return 0;
+}
+
 static const struct nvkm_subdev_func
 iccsense_func = {
 	.oneinit = nvkm_iccsense_oneinit,
 	.init = nvkm_iccsense_init,
+	.fini = nvkm_iccsense_fini,
 	.dtor = nvkm_iccsense_dtor,
 };
 
@@ -315,7 +415,12 @@ void
 nvkm_iccsense_ctor(struct nvkm_device *device, int index,
 		   struct nvkm_iccsense *iccsense)
 {
+	long period = nvkm_longopt(device->cfgopt, "NvSensorPeriod", 1000);
+
 	nvkm_subdev_ctor(&iccsense_func, device, index, &iccsense->subdev);
+	mutex_init(&iccsense->mutex);
+	/* Clamped as therm does, so both agree on the sampling period. */
+	iccsense->period = clamp(period, 0L, 4000L) * 1000000ULL;
 }
 
 int
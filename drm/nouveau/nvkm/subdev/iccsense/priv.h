@@ -16,10 +16,20 @@ struct nvkm_iccsense_sensor {
 
 struct nvkm_iccsense_rail {
 	struct list_head head;
-	int (*read)(struct nvkm_iccsense *, struct nvkm_iccsense_rail *);
 	struct nvkm_iccsense_sensor *sensor;
 	u8 idx;
 	u8 mohm;
+
+	u8 shunt_reg;
+	u8 shunt_shift;
+	u8 bus_reg;
+	u8 bus_shift;
+	u16 lsb;
+
+	/* transfer buffers, and the last successful reading */
+	u8 reg[2];
+	u8 val[2][2];
+	int power;
 };
 
 void nvkm_iccsense_ctor(struct nvkm_device *, int, struct nvkm_iccsense *);
@@ -28,51 +28,194 @@
 /******************************************************************************
  * instmem object base implementation
  *****************************************************************************/
+/* Suspend shadows are kept per page.  Pages of all-zeroes aren't stored,
+ * and pages with identical contents (across all objects) are shared.
+ */
+#define NVKM_INSTOBJ_PAGES 1024
+
+struct nvkm_instobj_page {
+	struct list_head head;
+	u64 hash;
+	u32 size;
+	int refs;
+	u32 data[];
+};
+
+static struct nvkm_instobj_page *
+nvkm_instobj_page_get(struct nvkm_instmem *imem, const u32 *data, u32 size)
+{
+	struct nvkm_instobj_page *page;
+	struct list_head *list;
+	u64 hash = 0xcbf29ce484222325ULL;
+	u32 bits = 0;
+	int i;
+
+	for (i = 0; i < size / 4; i++) {
+		hash = (hash ^ data[i]) * 0x00000100000001b3ULL;
+		bits |= data[i];
+	}
+
+	if (!bits) {
+		imem->sr.zero += size;
+		return NULL;
+	}
+
+	list = &imem->pages[hash % NVKM_INSTOBJ_PAGES];
+	spin_lock(&imem->lock);
+	list_for_each_entry(page, list, head) {
+		if (page->hash == hash && page->size == size &&
+		    !memcmp(page->data, data, size)) {
+			page->refs++;
+			spin_unlock(&imem->lock);
+			imem->sr.shared += size;
+			return page;
+		}
+	}
+	spin_unlock(&imem->lock);
+
+	page = kvmalloc(sizeof(*page) + size, GFP_KERNEL);
+	if (!page)
+		return ERR_PTR(-ENOMEM);
+
+	page->hash = hash;
+	page->size = size;
+	page->refs = 1;
+	memcpy(page->data, data, size);
+
+	spin_lock(&imem->lock);
+	list_add(&page->head, list);
+	spin_unlock(&imem->lock);
+	imem->sr.stored += size;
+	return page;
+}
+
+static void
+nvkm_instobj_page_put(struct nvkm_instmem *imem, struct nvkm_instobj_page *page)
+{
+	if (page) {
+		spin_lock(&imem->lock);
+		if (--page->refs)
+			page = NULL;
+		else
+			list_del(&page->head);
+		spin_unlock(&imem->lock);
+		kvfree(page);
+	}
+}
+
+static void
+nvkm_instobj_drop(struct nvkm_instmem *imem, struct nvkm_instobj *iobj)
+{
+	const u64 size = nvkm_memory_size(&iobj->memory);
+	u32 i;
+
+	if (iobj->suspend) {
+		for (i = 0; i < DIV_ROUND_UP(size, PAGE_SIZE); i++)
+			nvkm_instobj_page_put(imem, iobj->suspend[i]);
+		kvfree(iobj->suspend);
+		iobj->suspend = NULL;
+	}
+}
+
 static void
-nvkm_instobj_load(struct nvkm_instobj *iobj)
+nvkm_instobj_load(struct nvkm_instmem *imem, struct nvkm_instobj *iobj)
 {
 	struct nvkm_memory *memory = &iobj->memory;
 	const u64 size = nvkm_memory_size(memory);
-	void __iomem *map;
-	int i;
+	struct nvkm_instobj_page *page;
+	u8 __iomem *map;
+	u64 offset;
+	u32 len, i;
+
+	/* A CPU-only object that's still dirty wasn't reached by the save
+	 * (ie. a failed suspend being rolled back), so what's in it now is
+	 * newer than any shadow left over from a previous cycle.
+	 */
+	if (iobj->cpu && iobj->dirty) {
+		nvkm_instobj_drop(imem, iobj);
+		return;
+	}
 
-	if (!(map = nvkm_kmap(memory))) {
-		for (i = 0; i < size; i += 4)
-			nvkm_wo32(memory, i, iobj->suspend[i / 4]);
-	} else {
-		memcpy_toio(map, iobj->suspend, size);
+	map = nvkm_kmap(memory);
+	for (offset = 0; offset < size; offset += len) {
+		len = min_t(u64, size - offset, PAGE_SIZE);
+		page = iobj->suspend[offset / PAGE_SIZE];
+		if (map) {
+			if (page)
+				memcpy_toio(map + offset, page->data, len);
+			else
+				memset_io(map + offset, 0x00, len);
+		} else
+		if (page) {
+			nvkm_wobj(memory, offset, page->data, len);
+		} else {
+			for (i = 0; i < len; i += 4)
+				nvkm_wo32(memory, offset + i, 0x00000000);
+		}
 	}
 	nvkm_done(memory);
+	imem->sr.written += size;
 
-	kvfree(iobj->suspend);
-	iobj->suspend = NULL;
+	/* The GPU may write anything but CPU-only objects, so only those
+	 * can keep their shadow to skip the next save if left untouched.
+	 */
+	iobj->dirty = false;
+	if (!iobj->cpu)
+		nvkm_instobj_drop(imem, iobj);
 }
 
 static int
-nvkm_instobj_save(struct nvkm_instobj *iobj)
+nvkm_instobj_save(struct nvkm_instmem *imem, struct nvkm_instobj *iobj,
+		  u32 *data)
 {
 	struct nvkm_memory *memory = &iobj->memory;
 	const u64 size = nvkm_memory_size(memory);
-	void __iomem *map;
-	int i;
+	struct nvkm_instobj_page *page;
+	u8 __iomem *map;
+	u64 offset;
+	u32 len;
+	int ret = 0;
+
+	if (iobj->suspend && iobj->cpu && !iobj->dirty) {
+		imem->sr.clean += size;
+		return 0;
+	}
 
-	iobj->suspend = kvmalloc(size, GFP_KERNEL);
+	nvkm_instobj_drop(imem, iobj);
+	iobj->suspend = kvcalloc(DIV_ROUND_UP(size, PAGE_SIZE),
+				 sizeof(*iobj->suspend), GFP_KERNEL);
 	if (!iobj->suspend)
 		return -ENOMEM;
 
-	if (!(map = nvkm_kmap(memory))) {
-		for (i = 0; i < size; i += 4)
-			iobj->suspend[i / 4] = nvkm_ro32(memory, i);
-	} else {
-		memcpy_fromio(iobj->suspend, map, size);
+	map = nvkm_kmap(memory);
+	for (offset = 0; offset < size; offset += len) {
+		len = min_t(u64, size - offset, PAGE_SIZE);
+		if (map)
+			memcpy_fromio(data, map + offset, len);
+		else
+			nvkm_robj(memory, offset, data, len);
+		imem->sr.read += len;
+
+		page = nvkm_instobj_page_get(imem, data, len);
+		if (IS_ERR(page)) {
+			ret = PTR_ERR(page);
+			break;
+		}
+
+		iobj->suspend[offset / PAGE_SIZE] = page;
 	}
 	nvkm_done(memory);
-	return 0;
+	iobj->dirty = false;
+
+	if (ret)
+		nvkm_instobj_drop(imem, iobj);
+	return ret;
 }
 
 void
 nvkm_instobj_dtor(struct nvkm_instmem *imem, struct nvkm_instobj *iobj)
 {
+	nvkm_instobj_drop(imem, iobj);
 	spin_lock(&imem->lock);
 	list_del(&iobj->head);
 	spin_unlock(&imem->lock);
@@ -84,6 +227,8 @@ nvkm_instobj_ctor(const struct nvkm_memory_func *func,
 {
 	nvkm_memory_ctor(func, &iobj->memory);
 	iobj->suspend = NULL;
+	iobj->cpu = false;
+	iobj->dirty = true;
 	spin_lock(&imem->lock);
 	list_add_tail(&iobj->head, &imem->list);
 	spin_unlock(&imem->lock);
@@ -91,10 +236,11 @@ nvkm_instobj_ctor(const struct nvkm_memory_func *func,
 
 int
 nvkm_instobj_new(struct nvkm_instmem *imem, u32 size, u32 align, bool zero,
-		 struct nvkm_memory **pmemory)
+		 bool cpu, struct nvkm_memory **pmemory)
 {
 	struct nvkm_subdev *subdev = &imem->subdev;
 	struct nvkm_memory *memory = NULL;
+	struct nvkm_instobj *iobj;
 	u32 offset;
 	int ret;
 
@@ -118,6 +264,20 @@ nvkm_instobj_new(struct nvkm_instmem *imem, u32 size, u32 align, bool zero,
 		nvkm_done(memory);
 	}
 
+	/* Not every backend's objects are nvkm_instobjs (gk20a), so find
+	 * the one just created on the list rather than casting to it.
+	 */
+	if (cpu) {
+		spin_lock(&imem->lock);
+		list_for_each_entry_reverse(iobj, &imem->list, head) {
+			if (&iobj->memory == memory) {
+				iobj->cpu = true;
+				break;
+			}
+		}
+		spin_unlock(&imem->lock);
+	}
+
 done:
 	if (ret)
 		nvkm_memory_unref(&memory);
@@ -161,27 +321,54 @@ nvkm_instmem_fini(struct nvkm_subdev *subdev, bool suspend)
 {
 	struct nvkm_instmem *imem = nvkm_instmem(subdev);
 	struct nvkm_instobj *iobj;
+	u32 *data = NULL;
+	int ret = 0, i;
 
 	if (suspend) {
+		s64 time = ktime_to_us(ktime_get());
+
+		if (!imem->pages) {
+			imem->pages = kvcalloc(NVKM_INSTOBJ_PAGES,
+					       sizeof(*imem->pages),
+					       GFP_KERNEL);
+			if (!imem->pages)
+				return -ENOMEM;
+			for (i = 0; i < NVKM_INSTOBJ_PAGES; i++)
+				INIT_LIST_HEAD(&imem->pages[i]);
+		}
+
+		if (!(data = kvmalloc(PAGE_SIZE, GFP_KERNEL)))
+			return -ENOMEM;
+
+		memset(&imem->sr, 0x00, sizeof(imem->sr));
+		imem->suspended = true;
+
 		list_for_each_entry(iobj, &imem->list, head) {
-			int ret = nvkm_instobj_save(iobj);
-			if (ret)
-				return ret;
+			if ((ret = nvkm_instobj_save(imem, iobj, data)))
+				goto done;
 		}
 
 		nvkm_bar_bar2_fini(subdev->device);
 
 		list_for_each_entry(iobj, &imem->boot, head) {
-			int ret = nvkm_instobj_save(iobj);
-			if (ret)
-				return ret;
+			if ((ret = nvkm_instobj_save(imem, iobj, data)))
+				goto done;
 		}
+
+		imem->sr.save_us = ktime_to_us(ktime_get()) - time;
+		nvkm_debug(subdev, "saved %lld bytes (%lld clean, %lld zero, "
+				   "%lld shared, %lld stored) in %lldus\n",
+			   imem->sr.read + imem->sr.clean, imem->sr.clean,
+			   imem->sr.zero, imem->sr.shared, imem->sr.stored,
+			   imem->sr.save_us);
 	}
 
 	if (imem->func->fini)
 		imem->func->fini(imem);
 
-	return 0;
+done:
+	kvfree(data);
+	return ret;
 }
 
 static int
@@ -189,17 +376,27 @@ nvkm_instmem_init(struct nvkm_subdev *subdev)
 {
 	struct nvkm_instmem *imem = nvkm_instmem(subdev);
 	struct nvkm_instobj *iobj;
+	s64 time = ktime_to_us(ktime_get());
 
-	list_for_each_entry(iobj, &imem->boot, head) {
-		if (iobj->suspend)
-			nvkm_instobj_load(iobj);
+	if (imem->suspended) {
+		list_for_each_entry(iobj, &imem->boot, head) {
+			if (iobj->suspend)
+				nvkm_instobj_load(imem, iobj);
+		}
 	}
 
 	nvkm_bar_bar2_init(subdev->device);
 
-	list_for_each_entry(iobj, &imem->list, head) {
-		if (iobj->suspend)
-			nvkm_instobj_load(iobj);
+	if (imem->suspended) {
+		list_for_each_entry(iobj, &imem->list, head) {
+			if (iobj->suspend)
+				nvkm_instobj_load(imem, iobj);
+		}
+
+		imem->suspended = false;
+		imem->sr.load_us = ktime_to_us(ktime_get()) - time;
+		nvkm_debug(subdev, "restored %lld bytes in %lldus\n",
+			   imem->sr.written, imem->sr.load_us);
 	}
 
 	return 0;
@@ -218,6 +415,7 @@ static void *
 nvkm_instmem_dtor(struct nvkm_subdev *subdev)
 {
 	struct nvkm_instmem *imem = nvkm_instmem(subdev);
+	kvfree(imem->pages);
 	if (imem->func->dtor)
 		return imem->func->dtor(imem);
 	return imem;
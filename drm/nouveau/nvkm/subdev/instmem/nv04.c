@@ -74,6 +74,7 @@ nv04_instobj_acquire(struct nvkm_memory *memory)
 {
 	struct nv04_instobj *iobj = nv04_instobj(memory);
 	struct nvkm_device *device = iobj->imem->base.subdev.device;
+	nvkm_instobj_dirty(&iobj->base);
 	return device->pri + 0x700000 + iobj->node->offset;
 }
 
@@ -74,6 +74,7 @@ static void __iomem *
 nv40_instobj_acquire(struct nvkm_memory *memory)
 {
 	struct nv40_instobj *iobj = nv40_instobj(memory);
+	nvkm_instobj_dirty(&iobj->base);
 	return iobj->imem->iomem + iobj->node->offset;
 }
 
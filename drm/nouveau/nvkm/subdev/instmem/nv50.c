@@ -220,6 +220,8 @@ nv50_instobj_acquire(struct nvkm_memory *memory)
 	struct nvkm_vmm *vmm;
 	void __iomem *map = NULL;
 
+	nvkm_instobj_dirty(&iobj->base);
+
 	/* Already mapped? */
 	if (refcount_inc_not_zero(&iobj->maps))
 		return iobj->map;
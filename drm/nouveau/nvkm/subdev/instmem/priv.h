@@ -24,10 +24,18 @@ void nvkm_instmem_boot(struct nvkm_instmem *);
 struct nvkm_instobj {
 	struct nvkm_memory memory;
 	struct list_head head;
-	u32 *suspend;
+	struct nvkm_instobj_page **suspend;
+	bool cpu;   /* only written by the CPU, shadow is kept after resume */
+	bool dirty; /* acquired since the last save/load */
 };
 
 void nvkm_instobj_ctor(const struct nvkm_memory_func *func,
 		       struct nvkm_instmem *, struct nvkm_instobj *);
 void nvkm_instobj_dtor(struct nvkm_instmem *, struct nvkm_instobj *);
+
+static inline void
+nvkm_instobj_dirty(struct nvkm_instobj *iobj)
+{
+	iobj->dirty = true;
+}
 #endif
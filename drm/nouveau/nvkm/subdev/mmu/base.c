@@ -204,7 +204,7 @@ nvkm_mmu_ptc_get(struct nvkm_mmu *mmu, u32 size, u32 align, bool zero)
 	pt->ptc = ptc;
 	pt->sub = false;
 
-	ret = nvkm_memory_new(mmu->subdev.device, NVKM_MEM_TARGET_INST,
+	ret = nvkm_memory_new(mmu->subdev.device, NVKM_MEM_TARGET_INST_CPU,
 			      size, align, zero, &pt->memory);
 	if (ret) {
 		kfree(pt);
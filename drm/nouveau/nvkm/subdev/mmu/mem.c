@@ -27,12 +27,22 @@
 #include <nvif/if000a.h>
 #include <nvif/unpack.h>
 
+/* Host memory is allocated in naturally-aligned chunks of up to this size,
+ * which lets the VMM map it with large pages where it supports that.
+ */
+#define NVKM_MEM_CHUNK_SHIFT 21
+
 struct nvkm_mem {
 	struct nvkm_memory memory;
 	enum nvkm_memory_target target;
 	struct nvkm_mmu *mmu;
 	u64 pages;
-	struct page **mem;
+	u8  page;	/* smallest chunk, as a page shift */
+	u64 chunks;
+	struct nvkm_mem_chunk {
+		struct page *page;
+		u8 order;
+	} *chunk;
 	union {
 		struct scatterlist *sgl;
 		dma_addr_t *dma;
@@ -48,14 +58,14 @@ nvkm_mem_target(struct nvkm_memory *memory)
 static u8
 nvkm_mem_page(struct nvkm_memory *memory)
 {
-	return PAGE_SHIFT;
+	return nvkm_mem(memory)->page;
 }
 
 static u64
 nvkm_mem_addr(struct nvkm_memory *memory)
 {
 	struct nvkm_mem *mem = nvkm_mem(memory);
-	if (mem->pages == 1 && mem->mem)
+	if (mem->pages == 1 && mem->chunk)
 		return mem->dma[0];
 	return ~0ULL;
 }
@@ -83,15 +93,18 @@ static void *
 nvkm_mem_dtor(struct nvkm_memory *memory)
 {
 	struct nvkm_mem *mem = nvkm_mem(memory);
-	if (mem->mem) {
-		while (mem->pages--) {
+	if (mem->chunk) {
+		while (mem->chunks--) {
+			struct nvkm_mem_chunk *chunk = &mem->chunk[mem->chunks];
+			mem->pages -= 1ULL << chunk->order;
 			dma_unmap_page(mem->mmu->subdev.device->dev,
-				       mem->dma[mem->pages], PAGE_SIZE,
+				       mem->dma[mem->pages],
+				       PAGE_SIZE << chunk->order,
 				       DMA_BIDIRECTIONAL);
-			__free_page(mem->mem[mem->pages]);
+			__free_pages(chunk->page, chunk->order);
 		}
 		kvfree(mem->dma);
-		kvfree(mem->mem);
+		kvfree(mem->chunk);
 	}
 	return mem;
 }
@@ -133,11 +146,22 @@ int
 nvkm_mem_map_host(struct nvkm_memory *memory, void **pmap)
 {
 	struct nvkm_mem *mem = nvkm_mem(memory);
-	if (mem->mem) {
-		*pmap = vmap(mem->mem, mem->pages, VM_MAP, PAGE_KERNEL);
-		return *pmap ? 0 : -EFAULT;
+	struct page **pages;
+	u64 c, i, n = 0;
+
+	if (!mem->chunk)
+		return -EINVAL;
+
+	if (!(pages = kvmalloc_array(mem->pages, sizeof(*pages), GFP_KERNEL)))
+		return -ENOMEM;
+	for (c = 0; c < mem->chunks; c++) {
+		for (i = 0; i < (1ULL << mem->chunk[c].order); i++)
+			pages[n++] = nth_page(mem->chunk[c].page, i);
 	}
-	return -EINVAL;
+
+	*pmap = vmap(pages, mem->pages, VM_MAP, PAGE_KERNEL);
+	kvfree(pages);
+	return *pmap ? 0 : -EFAULT;
 }
 
 static int
@@ -149,7 +173,7 @@ nvkm_mem_new_host(struct nvkm_mmu *mmu, int type, u8 page, u64 size,
 		struct nvif_mem_ram_vn vn;
 		struct nvif_mem_ram_v0 v0;
 	} *args = argv;
-	int ret = -ENOSYS;
+	int ret = -ENOSYS, order, i;
 	enum nvkm_memory_target target;
 	struct nvkm_mem *mem;
 	gfp_t gfp = GFP_USER | __GFP_ZERO;
@@ -167,6 +191,7 @@ nvkm_mem_new_host(struct nvkm_mmu *mmu, int type, u8 page, u64 size,
 		return -ENOMEM;
 	mem->target = target;
 	mem->mmu = mmu;
+	mem->page = PAGE_SHIFT;
 	*pmemory = &mem->memory;
 
 	if (!(ret = nvif_unpack(ret, &argv, &argc, args->v0, 0, 0, false))) {
@@ -191,7 +216,8 @@ nvkm_mem_new_host(struct nvkm_mmu *mmu, int type, u8 page, u64 size,
 	nvkm_memory_ctor(&nvkm_mem_dma, &mem->memory);
 	size = ALIGN(size, PAGE_SIZE) >> PAGE_SHIFT;
 
-	if (!(mem->mem = kvmalloc_array(size, sizeof(*mem->mem), GFP_KERNEL)))
+	if (!(mem->chunk = kvmalloc_array(size, sizeof(*mem->chunk),
+					  GFP_KERNEL)))
 		return -ENOMEM;
 	if (!(mem->dma = kvmalloc_array(size, sizeof(*mem->dma), GFP_KERNEL)))
 		return -ENOMEM;
@@ -201,20 +227,49 @@ nvkm_mem_new_host(struct nvkm_mmu *mmu, int type, u8 page, u64 size,
 	else
 		gfp |= GFP_DMA32;
 
-	for (mem->pages = 0; size; size--, mem->pages++) {
-		struct page *p = alloc_page(gfp);
-		if (!p)
-			return -ENOMEM;
-
-		mem->dma[mem->pages] = dma_map_page(mmu->subdev.device->dev,
-						    p, 0, PAGE_SIZE,
-						    DMA_BIDIRECTIONAL);
-		if (dma_mapping_error(dev, mem->dma[mem->pages])) {
-			__free_page(p);
-			return -ENOMEM;
+	/* Chunks only ever get smaller, so each one stays aligned to its
+	 * own size within the object, and the whole object can be mapped
+	 * at the smallest chunk size.  Once an order has failed, it's not
+	 * tried again for the rest of the object.
+	 */
+	order = min_t(int, fls64(size | 1) - 1,
+		      NVKM_MEM_CHUNK_SHIFT - PAGE_SHIFT);
+	mem->page = PAGE_SHIFT + order;
+
+	for (mem->pages = 0; size; ) {
+		struct nvkm_mem_chunk *chunk = &mem->chunk[mem->chunks];
+		dma_addr_t addr;
+		struct page *p;
+
+		while ((1ULL << order) > size)
+			order--;
+
+		p = alloc_pages(order ? gfp | __GFP_NOWARN | __GFP_NORETRY :
+					gfp, order);
+		if (!p) {
+			if (!order--)
+				return -ENOMEM;
+			continue;
 		}
 
-		mem->mem[mem->pages] = p;
+		addr = dma_map_page(dev, p, 0, PAGE_SIZE << order,
+				    DMA_BIDIRECTIONAL);
+		if (dma_mapping_error(dev, addr)) {
+			/* A large chunk may not fit in a bounce buffer. */
+			__free_pages(p, order);
+			if (!order--)
+				return -ENOMEM;
+			continue;
+		}
+
+		chunk->page = p;
+		chunk->order = order;
+		mem->chunks++;
+
+		for (i = 0; i < (1 << order); i++)
+			mem->dma[mem->pages++] = addr + ((u64)i << PAGE_SHIFT);
+		size -= 1ULL << order;
+		mem->page = min_t(u8, mem->page, PAGE_SHIFT + order);
 	}
 
 	return 0;
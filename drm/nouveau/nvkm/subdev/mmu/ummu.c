@@ -129,6 +129,63 @@ nvkm_ummu_kind(struct nvkm_ummu *ummu, void *argv, u32 argc)
 	return 0;
 }
 
+static int
+nvkm_ummu_info(struct nvkm_ummu *ummu, void *argv, u32 argc)
+{
+	struct nvkm_mmu *mmu = ummu->mmu;
+	union {
+		struct nvif_mmu_info_v0 v0;
+	} *args = argv;
+	const u8 *kind = NULL;
+	int ret = -ENOSYS, count = 0, i;
+	u8 kind_inv = 0, *data;
+
+	if (mmu->func->kind)
+		kind = mmu->func->kind(mmu, &count, &kind_inv);
+
+	if (!(ret = nvif_unpack(ret, &argv, &argc, args->v0, 0, 0, true))) {
+		if (args->v0.heap_nr != mmu->heap_nr ||
+		    args->v0.type_nr != mmu->type_nr ||
+		    args->v0.kind_nr != count)
+			return -EINVAL;
+		if (argc != mmu->heap_nr * sizeof(u64) + mmu->type_nr * 2 +
+			    count)
+			return -EINVAL;
+
+		data = args->v0.data;
+		for (i = 0; i < mmu->heap_nr; i++, data += sizeof(u64))
+			memcpy(data, &mmu->heap[i].size, sizeof(u64));
+
+		for (i = 0; i < mmu->type_nr; i++) {
+			u8 type = mmu->type[i].type, flags = 0;
+			if (type & NVKM_MEM_VRAM)
+				flags |= NVIF_MMU_INFO_V0_TYPE_VRAM;
+			if (type & NVKM_MEM_HOST)
+				flags |= NVIF_MMU_INFO_V0_TYPE_HOST;
+			if (type & NVKM_MEM_COMP)
+				flags |= NVIF_MMU_INFO_V0_TYPE_COMP;
+			if (type & NVKM_MEM_DISP)
+				flags |= NVIF_MMU_INFO_V0_TYPE_DISP;
+			if (type & NVKM_MEM_KIND)
+				flags |= NVIF_MMU_INFO_V0_TYPE_KIND;
+			if (type & NVKM_MEM_MAPPABLE)
+				flags |= NVIF_MMU_INFO_V0_TYPE_MAPPABLE;
+			if (type & NVKM_MEM_COHERENT)
+				flags |= NVIF_MMU_INFO_V0_TYPE_COHERENT;
+			if (type & NVKM_MEM_UNCACHED)
+				flags |= NVIF_MMU_INFO_V0_TYPE_UNCACHED;
+			*data++ = mmu->type[i].heap;
+			*data++ = flags;
+		}
+
+		args->v0.kind_inv = kind_inv;
+		memcpy(data, kind, count);
+	} else
+		return ret;
+
+	return 0;
+}
+
 static int
 nvkm_ummu_mthd(struct nvkm_object *object, u32 mthd, void *argv, u32 argc)
 {
@@ -137,6 +194,7 @@ nvkm_ummu_mthd(struct nvkm_object *object, u32 mthd, void *argv, u32 argc)
 	case NVIF_MMU_V0_HEAP: return nvkm_ummu_heap(ummu, argv, argc);
 	case NVIF_MMU_V0_TYPE: return nvkm_ummu_type(ummu, argv, argc);
 	case NVIF_MMU_V0_KIND: return nvkm_ummu_kind(ummu, argv, argc);
+	case NVIF_MMU_V0_INFO: return nvkm_ummu_info(ummu, argv, argc);
 	default:
 		break;
 	}
@@ -105,10 +105,209 @@ nvkm_uvmm_mthd_pfnmap(struct nvkm_uvmm *uvmm, void *argv, u32 argc)
 	return ret;
 }
 
+/* Looks up the mapped region starting at 'addr', for unmap.
+ * Must be called with vmm->mutex held.
+ */
+static struct nvkm_vma *
+nvkm_uvmm_vma_unmap(struct nvkm_uvmm *uvmm, u64 addr)
+{
+	struct nvkm_client *client = uvmm->object.client;
+	struct nvkm_vmm *vmm = uvmm->vmm;
+	struct nvkm_vma *vma;
+
+	vma = nvkm_vmm_node_search(vmm, addr);
+	if (!vma || vma->addr != addr) {
+		VMM_DEBUG(vmm, "lookup %016llx: %016llx",
+			  addr, vma ? vma->addr : ~0ULL);
+		return ERR_PTR(-ENOENT);
+	}
+
+	if ((!vma->user && !client->super) || vma->busy) {
+		VMM_DEBUG(vmm, "denied %016llx: %d %d %d", addr,
+			  vma->user, !client->super, vma->busy);
+		return ERR_PTR(-ENOENT);
+	}
+
+	if (!vma->memory) {
+		VMM_DEBUG(vmm, "unmapped");
+		return ERR_PTR(-EINVAL);
+	}
+
+	return vma;
+}
+
+/* Looks up the region to map at 'addr', splitting it from a larger one
+ * as necessary.  With 'remap', the region must already be mapped, with
+ * the same address and size.  Must be called with vmm->mutex held.
+ */
+static struct nvkm_vma *
+nvkm_uvmm_vma_map(struct nvkm_uvmm *uvmm, u64 addr, u64 size, bool remap)
+{
+	struct nvkm_client *client = uvmm->object.client;
+	struct nvkm_vmm *vmm = uvmm->vmm;
+	struct nvkm_vma *vma;
+
+	if (!(vma = nvkm_vmm_node_search(vmm, addr))) {
+		VMM_DEBUG(vmm, "lookup %016llx", addr);
+		return ERR_PTR(-ENOENT);
+	}
+
+	if ((!vma->user && !client->super) || vma->busy) {
+		VMM_DEBUG(vmm, "denied %016llx: %d %d %d", addr,
+			  vma->user, !client->super, vma->busy);
+		return ERR_PTR(-ENOENT);
+	}
+
+	if (vma->mapped && !vma->memory) {
+		VMM_DEBUG(vmm, "pfnmap %016llx", addr);
+		return ERR_PTR(-EINVAL);
+	}
+
+	if (remap && (!vma->memory || vma->addr != addr || vma->size != size)) {
+		VMM_DEBUG(vmm, "remap %d %016llx %016llx %016llx %016llx",
+			  !!vma->memory, addr, size, vma->addr, (u64)vma->size);
+		return ERR_PTR(-EINVAL);
+	}
+
+	if (vma->addr != addr || vma->size != size) {
+		if (addr + size > vma->addr + vma->size || vma->memory ||
+		    (vma->refd == NVKM_VMA_PAGE_NONE && !vma->mapref)) {
+			VMM_DEBUG(vmm, "split %d %d %d "
+				       "%016llx %016llx %016llx %016llx",
+				  !!vma->memory, vma->refd, vma->mapref,
+				  addr, size, vma->addr, (u64)vma->size);
+			return ERR_PTR(-EINVAL);
+		}
+
+		vma = nvkm_vmm_node_split(vmm, vma, addr, size);
+		if (!vma)
+			return ERR_PTR(-ENOMEM);
+	}
+
+	return vma;
+}
+
+/* Executes a single operation of a batched bind, with vmm->mutex held.
+ * On entry, '*pmemory' holds a reference to the memory being mapped, if
+ * any.  On return, it holds a reference to the memory that was mapped
+ * before, which the TLB may still point at until the batch is flushed.
+ */
 static int
-nvkm_uvmm_mthd_unmap(struct nvkm_uvmm *uvmm, void *argv, u32 argc)
+nvkm_uvmm_bind_op(struct nvkm_uvmm *uvmm, struct nvif_vmm_bind_op_v0 *op,
+		  struct nvkm_memory **pmemory, void *argv, u32 argc)
+{
+	struct nvkm_vmm *vmm = uvmm->vmm;
+	struct nvkm_memory *prev;
+	struct nvkm_vma *vma;
+	int ret;
+
+	if (op->op == NVIF_VMM_BIND_V0_UNMAP) {
+		vma = nvkm_uvmm_vma_unmap(uvmm, op->addr);
+		if (IS_ERR(vma))
+			return PTR_ERR(vma);
+
+		*pmemory = nvkm_memory_ref(vma->memory);
+		nvkm_vmm_unmap_locked(vmm, vma, false);
+		return 0;
+	}
+
+	vma = nvkm_uvmm_vma_map(uvmm, op->addr, op->size,
+				op->op == NVIF_VMM_BIND_V0_REMAP);
+	if (IS_ERR(vma))
+		return PTR_ERR(vma);
+
+	prev = nvkm_memory_ref(vma->memory);
+	vma->busy = true;
+	vma->locked = true;
+	ret = nvkm_memory_map(*pmemory, op->offset, vmm, vma, argv, argc);
+	vma->locked = false;
+	vma->busy = false;
+	if (ret) {
+		/* A failed map leaves any previous mapping untouched. */
+		if (!prev)
+			nvkm_vmm_unmap_region(vmm, vma);
+		nvkm_memory_unref(&prev);
+		return ret;
+	}
+
+	nvkm_memory_unref(pmemory);
+	*pmemory = prev;
+	return 0;
+}
+
+static int
+nvkm_uvmm_mthd_bind(struct nvkm_uvmm *uvmm, void *argv, u32 argc)
 {
 	struct nvkm_client *client = uvmm->object.client;
+	union {
+		struct nvif_vmm_bind_v0 v0;
+	} *args = argv;
+	struct nvkm_vmm *vmm = uvmm->vmm;
+	struct nvif_vmm_bind_op_v0 *op;
+	struct nvkm_memory **memory;
+	int ret = -ENOSYS;
+	u32 count, i;
+
+	if (!(ret = nvif_unpack(ret, &argv, &argc, args->v0, 0, 0, true))) {
+		count = args->v0.count;
+		op = args->v0.op;
+		if (argc < (u64)count * sizeof(*op))
+			return -EINVAL;
+		argv = op + count;
+		argc = argc - count * sizeof(*op);
+	} else
+		return ret;
+
+	if (!count)
+		return 0;
+
+	if (!(memory = kvcalloc(count, sizeof(*memory), GFP_KERNEL)))
+		return -ENOMEM;
+
+	/* Decode the entire batch before touching the VMM, so a malformed
+	 * one is rejected without any of it having been applied.
+	 */
+	for (i = 0; i < count; i++) {
+		switch (op[i].op) {
+		case NVIF_VMM_BIND_V0_MAP:
+		case NVIF_VMM_BIND_V0_REMAP:
+			memory[i] = nvkm_umem_search(client, op[i].memory);
+			if (IS_ERR(memory[i])) {
+				VMM_DEBUG(vmm, "memory %016llx %ld\n",
+					  op[i].memory, PTR_ERR(memory[i]));
+				ret = op[i].status = PTR_ERR(memory[i]);
+				memory[i] = NULL;
+				goto done;
+			}
+			break;
+		case NVIF_VMM_BIND_V0_UNMAP:
+			break;
+		default:
+			VMM_DEBUG(vmm, "op %d: %d", i, op[i].op);
+			ret = op[i].status = -EINVAL;
+			goto done;
+		}
+	}
+
+	mutex_lock(&vmm->mutex);
+	nvkm_vmm_bind_begin(vmm);
+	for (i = 0; i < count; i++) {
+		op[i].status = nvkm_uvmm_bind_op(uvmm, &op[i], &memory[i],
+						 argv, argc);
+	}
+	nvkm_vmm_bind_end(vmm);
+	mutex_unlock(&vmm->mutex);
+	ret = 0;
+done:
+	for (i = 0; i < count; i++)
+		nvkm_memory_unref(&memory[i]);
+	kvfree(memory);
+	return ret;
+}
+
+static int
+nvkm_uvmm_mthd_unmap(struct nvkm_uvmm *uvmm, void *argv, u32 argc)
+{
 	union {
 		struct nvif_vmm_unmap_v0 v0;
 	} *args = argv;
@@ -123,21 +322,9 @@ nvkm_uvmm_mthd_unmap(struct nvkm_uvmm *uvmm, void *argv, u32 argc)
 		return ret;
 
 	mutex_lock(&vmm->mutex);
-	vma = nvkm_vmm_node_search(vmm, addr);
-	if (ret = -ENOENT, !vma || vma->addr != addr) {
-		VMM_DEBUG(vmm, "lookup %016llx: %016llx",
-			  addr, vma ? vma->addr : ~0ULL);
-		goto done;
-	}
-
-	if (ret = -ENOENT, (!vma->user && !client->super) || vma->busy) {
-		VMM_DEBUG(vmm, "denied %016llx: %d %d %d", addr,
-			  vma->user, !client->super, vma->busy);
-		goto done;
-	}
-
-	if (ret = -EINVAL, !vma->memory) {
-		VMM_DEBUG(vmm, "unmapped");
+	vma = nvkm_uvmm_vma_unmap(uvmm, addr);
+	if (IS_ERR(vma)) {
+		ret = PTR_ERR(vma);
 		goto done;
 	}
 
@@ -176,38 +363,11 @@ nvkm_uvmm_mthd_map(struct nvkm_uvmm *uvmm, void *argv, u32 argc)
 	}
 
 	mutex_lock(&vmm->mutex);
-	if (ret = -ENOENT, !(vma = nvkm_vmm_node_search(vmm, addr))) {
-		VMM_DEBUG(vmm, "lookup %016llx", addr);
-		goto fail;
-	}
-
-	if (ret = -ENOENT, (!vma->user && !client->super) || vma->busy) {
-		VMM_DEBUG(vmm, "denied %016llx: %d %d %d", addr,
-			  vma->user, !client->super, vma->busy);
+	vma = nvkm_uvmm_vma_map(uvmm, addr, size, false);
+	if (IS_ERR(vma)) {
+		ret = PTR_ERR(vma);
 		goto fail;
 	}
-
-	if (ret = -EINVAL, vma->mapped && !vma->memory) {
-		VMM_DEBUG(vmm, "pfnmap %016llx", addr);
-		goto fail;
-	}
-
-	if (ret = -EINVAL, vma->addr != addr || vma->size != size) {
-		if (addr + size > vma->addr + vma->size || vma->memory ||
-		    (vma->refd == NVKM_VMA_PAGE_NONE && !vma->mapref)) {
-			VMM_DEBUG(vmm, "split %d %d %d "
-				       "%016llx %016llx %016llx %016llx",
-				  !!vma->memory, vma->refd, vma->mapref,
-				  addr, size, vma->addr, (u64)vma->size);
-			goto fail;
-		}
-
-		vma = nvkm_vmm_node_split(vmm, vma, addr, size);
-		if (!vma) {
-			ret = -ENOMEM;
-			goto fail;
-		}
-	}
 	vma->busy = true;
 	mutex_unlock(&vmm->mutex);
 
@@ -341,6 +501,7 @@ nvkm_uvmm_mthd(struct nvkm_object *object, u32 mthd, void *argv, u32 argc)
 	case NVIF_VMM_V0_UNMAP : return nvkm_uvmm_mthd_unmap (uvmm, argv, argc);
 	case NVIF_VMM_V0_PFNMAP: return nvkm_uvmm_mthd_pfnmap(uvmm, argv, argc);
 	case NVIF_VMM_V0_PFNCLR: return nvkm_uvmm_mthd_pfnclr(uvmm, argv, argc);
+	case NVIF_VMM_V0_BIND  : return nvkm_uvmm_mthd_bind  (uvmm, argv, argc);
 	case NVIF_VMM_V0_MTHD(0x00) ... NVIF_VMM_V0_MTHD(0x7f):
 		if (uvmm->vmm->func->mthd) {
 			return uvmm->vmm->func->mthd(uvmm->vmm,
@@ -582,6 +582,11 @@ nvkm_vmm_iter(struct nvkm_vmm *vmm, const struct nvkm_vmm_page *page,
 		}
 	}
 
+	if (vmm->bind.defer) {
+		vmm->bind.flush = min(vmm->bind.flush, it.flush);
+		it.flush = NVKM_VMM_LEVELS_MAX;
+	}
+
 	nvkm_vmm_flush(&it);
 	return ~0ULL;
 
@@ -1482,7 +1487,7 @@ nvkm_vmm_map_locked(struct nvkm_vmm *vmm, struct nvkm_vma *vma,
 		func = map->page->desc->func->sgl;
 	} else {
 		map->dma += map->offset >> PAGE_SHIFT;
-		map->off  = map->offset & PAGE_MASK;
+		map->off  = map->offset & (PAGE_SIZE - 1);
 		func = map->page->desc->func->dma;
 	}
 
@@ -1509,14 +1514,40 @@ int
 nvkm_vmm_map(struct nvkm_vmm *vmm, struct nvkm_vma *vma, void *argv, u32 argc,
 	     struct nvkm_vmm_map *map)
 {
+	const bool locked = vma->locked;
 	int ret;
-	mutex_lock(&vmm->mutex);
+	if (!locked)
+		mutex_lock(&vmm->mutex);
 	ret = nvkm_vmm_map_locked(vmm, vma, argv, argc, map);
 	vma->busy = false;
-	mutex_unlock(&vmm->mutex);
+	if (!locked)
+		mutex_unlock(&vmm->mutex);
 	return ret;
 }
 
+/* Updates made between bind_begin() and bind_end() skip the TLB flush
+ * at the end of each operation, and a single flush covering all of them
+ * is done by bind_end().  Flushes that guard the freeing of page tables
+ * still happen immediately.  Must be called with vmm->mutex held.
+ */
+void
+nvkm_vmm_bind_begin(struct nvkm_vmm *vmm)
+{
+	vmm->bind.defer = true;
+	vmm->bind.flush = NVKM_VMM_LEVELS_MAX;
+}
+
+void
+nvkm_vmm_bind_end(struct nvkm_vmm *vmm)
+{
+	vmm->bind.defer = false;
+	if (vmm->bind.flush != NVKM_VMM_LEVELS_MAX) {
+		if (vmm->func->flush)
+			vmm->func->flush(vmm, vmm->bind.flush);
+		vmm->bind.flush = NVKM_VMM_LEVELS_MAX;
+	}
+}
+
 static void
 nvkm_vmm_put_region(struct nvkm_vmm *vmm, struct nvkm_vma *vma)
 {
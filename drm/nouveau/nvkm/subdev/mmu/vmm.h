@@ -172,6 +172,8 @@ int nvkm_vmm_get_locked(struct nvkm_vmm *, bool getref, bool mapref,
 void nvkm_vmm_put_locked(struct nvkm_vmm *, struct nvkm_vma *);
 void nvkm_vmm_unmap_locked(struct nvkm_vmm *, struct nvkm_vma *, bool pfn);
 void nvkm_vmm_unmap_region(struct nvkm_vmm *, struct nvkm_vma *);
+void nvkm_vmm_bind_begin(struct nvkm_vmm *);
+void nvkm_vmm_bind_end(struct nvkm_vmm *);
 
 #define NVKM_VMM_PFN_ADDR                                 0xfffffffffffff000ULL
 #define NVKM_VMM_PFN_ADDR_SHIFT                                              12
@@ -310,9 +312,14 @@ int tu102_vmm_new(struct nvkm_mmu *, bool, u64, u64, void *, u32,
 		     ((u64)MAP->mem->offset << NVKM_RAM_MM_SHIFT),             \
 		     ((u64)MAP->mem->length << NVKM_RAM_MM_SHIFT),             \
 		     (MAP->mem = MAP->mem->next))
+/* The DMA array has an entry per PAGE_SIZE, which for larger pages are
+ * guaranteed contiguous by nvkm_memory_page(), so only the first is used.
+ */
 #define VMM_MAP_ITER_DMA(VMM,PT,PTEI,PTEN,MAP,FILL)                            \
 	VMM_MAP_ITER(VMM,PT,PTEI,PTEN,MAP,FILL,                                \
-		     *MAP->dma, PAGE_SIZE, MAP->dma++)
+		     *MAP->dma, max_t(u64, PAGE_SIZE, 1ULL << MAP->page->shift),\
+		     (MAP->dma += MAP->page->shift > PAGE_SHIFT ?              \
+				  1ULL << (MAP->page->shift - PAGE_SHIFT) : 1))
 #define VMM_MAP_ITER_SGL(VMM,PT,PTEI,PTEN,MAP,FILL)                            \
 	VMM_MAP_ITER(VMM,PT,PTEI,PTEN,MAP,FILL,                                \
 		     sg_dma_address(MAP->sgl), sg_dma_len(MAP->sgl),           \
@@ -91,6 +91,11 @@ nvkm_pmu_fini(struct nvkm_subdev *subdev, bool suspend)
 	nvkm_falcon_cmdq_fini(pmu->lpq);
 	nvkm_falcon_cmdq_fini(pmu->hpq);
 	pmu->initmsg_received = false;
+
+	/* MEMX scripts live wherever the PMU firmware says, and it's about
+	 * to be reloaded.
+	 */
+	nvkm_memx_cache_fini(pmu);
 	return 0;
 }
 
@@ -143,6 +148,7 @@ static void *
 nvkm_pmu_dtor(struct nvkm_subdev *subdev)
 {
 	struct nvkm_pmu *pmu = nvkm_pmu(subdev);
+	nvkm_memx_cache_fini(pmu);
 	nvkm_falcon_msgq_del(&pmu->msgq);
 	nvkm_falcon_cmdq_del(&pmu->lpq);
 	nvkm_falcon_cmdq_del(&pmu->hpq);
@@ -170,6 +176,8 @@ nvkm_pmu_ctor(const struct nvkm_pmu_fwif *fwif, struct nvkm_device *device,
 
 	INIT_WORK(&pmu->recv.work, nvkm_pmu_recv);
 	init_waitqueue_head(&pmu->recv.wait);
+	mutex_init(&pmu->memx.mutex);
+	INIT_LIST_HEAD(&pmu->memx.cache);
 
 	fwif = nvkm_firmware_load(&pmu->subdev, fwif, "Pmu", pmu);
 	if (IS_ERR(fwif))
@@ -3,6 +3,31 @@
 #define __NVKM_PMU_MEMX_H__
 #include "priv.h"
 
+/* Scripts are built on the host and uploaded to the PMU in one transfer
+ * when they're executed.
+ *
+ * A script built under a key (from, to, band) is kept once it has been
+ * executed, along with the value of every register that was read while
+ * building it.  If those registers still hold the same values the next
+ * time the same transition is requested, the script is replayed as-is.
+ * Anything else a script depends on must be part of its key, which must
+ * be set before the script reads any registers.
+ */
+#define MEMX_INPUTS 64
+#define MEMX_CACHE  16
+
+struct nvkm_memx_script {
+	struct list_head head;
+	u32 from;
+	u32 to;
+	u32 band;
+	u32 base;
+	u32 size;
+	int inputs;
+	int words;
+	u32 data[]; /* inputs (addr, data pairs), then the script */
+};
+
 struct nvkm_memx {
 	struct nvkm_pmu *pmu;
 	u32 base;
@@ -12,18 +37,41 @@ struct nvkm_memx {
 		u32 size;
 		u32 data[64];
 	} c;
+
+	u32 *data;
+	int words;
+	bool overflow;
+
+	struct {
+		bool valid;
+		u32 from;
+		u32 to;
+		u32 band;
+	} key;
+	u32 input[MEMX_INPUTS][2];
+	int inputs;
+	bool cached;
 };
 
 static void
 memx_out(struct nvkm_memx *memx)
 {
-	struct nvkm_device *device = memx->pmu->subdev.device;
 	int i;
 
 	if (memx->c.mthd) {
-		nvkm_wr32(device, 0x10a1c4, (memx->c.size << 16) | memx->c.mthd);
-		for (i = 0; i < memx->c.size; i++)
-			nvkm_wr32(device, 0x10a1c4, memx->c.data[i]);
+		if ((memx->words + 1 + memx->c.size) * 4 > memx->size) {
+			if (!memx->overflow) {
+				nvkm_error(&memx->pmu->subdev,
+					   "script exceeds %d bytes\n",
+					   memx->size);
+			}
+			memx->overflow = true;
+		} else {
+			memx->data[memx->words++] = (memx->c.size << 16) |
+						    memx->c.mthd;
+			for (i = 0; i < memx->c.size; i++)
+				memx->data[memx->words++] = memx->c.data[i];
+		}
 		memx->c.mthd = 0;
 		memx->c.size = 0;
 	}
@@ -40,11 +88,184 @@ memx_cmd(struct nvkm_memx *memx, u32 mthd, u32 size, u32 data[])
 	memx->c.mthd  = mthd;
 }
 
+static struct nvkm_memx *
+memx_new(struct nvkm_pmu *pmu, u32 base, u32 size)
+{
+	struct nvkm_memx *memx;
+
+	if (!(memx = kzalloc(sizeof(*memx), GFP_KERNEL)))
+		return NULL;
+	memx->pmu = pmu;
+	memx->base = base;
+	memx->size = size;
+
+	memx->data = kvmalloc(size, GFP_KERNEL);
+	if (!memx->data) {
+		kfree(memx);
+		return NULL;
+	}
+
+	return memx;
+}
+
+static void
+memx_del(struct nvkm_memx **pmemx)
+{
+	struct nvkm_memx *memx = *pmemx;
+	if (memx) {
+		kvfree(memx->data);
+		kfree(memx);
+		*pmemx = NULL;
+	}
+}
+
+/* Called with pmu->memx.mutex held. */
+static void
+memx_cache_put(struct nvkm_memx *memx)
+{
+	struct nvkm_pmu *pmu = memx->pmu;
+	struct nvkm_memx_script *script;
+	int i = 0;
+
+	list_for_each_entry(script, &pmu->memx.cache, head) {
+		if (script->from == memx->key.from &&
+		    script->to == memx->key.to &&
+		    script->band == memx->key.band) {
+			list_del(&script->head);
+			kvfree(script);
+			break;
+		}
+	}
+
+	list_for_each_entry(script, &pmu->memx.cache, head) {
+		if (++i == MEMX_CACHE) {
+			list_del(&script->head);
+			kvfree(script);
+			break;
+		}
+	}
+
+	script = kvmalloc(struct_size(script, data, memx->inputs * 2 +
+				      memx->words), GFP_KERNEL);
+	if (!script)
+		return;
+
+	script->from = memx->key.from;
+	script->to = memx->key.to;
+	script->band = memx->key.band;
+	script->base = memx->base;
+	script->size = memx->size;
+	script->inputs = memx->inputs;
+	script->words = memx->words;
+	memcpy(script->data, memx->input, memx->inputs * 2 * sizeof(u32));
+	memcpy(script->data + memx->inputs * 2, memx->data,
+	       memx->words * sizeof(u32));
+	list_add(&script->head, &pmu->memx.cache);
+}
+
+void
+nvkm_memx_cache_fini(struct nvkm_pmu *pmu)
+{
+	struct nvkm_memx_script *script, *temp;
+
+	mutex_lock(&pmu->memx.mutex);
+	list_for_each_entry_safe(script, temp, &pmu->memx.cache, head) {
+		list_del(&script->head);
+		kvfree(script);
+	}
+	mutex_unlock(&pmu->memx.mutex);
+}
+
 int
-nvkm_memx_init(struct nvkm_pmu *pmu, struct nvkm_memx **pmemx)
+nvkm_memx_cached(struct nvkm_pmu *pmu, u32 from, u32 to, u32 band,
+		 struct nvkm_memx **pmemx)
 {
-	struct nvkm_device *device = pmu->subdev.device;
+	struct nvkm_device *device;
+	struct nvkm_memx_script *script;
 	struct nvkm_memx *memx;
+	int ret = -ENOENT, i;
+
+	if (!pmu)
+		return -ENODEV;
+	device = pmu->subdev.device;
+
+	mutex_lock(&pmu->memx.mutex);
+	list_for_each_entry(script, &pmu->memx.cache, head) {
+		if (script->from == from && script->to == to &&
+		    script->band == band)
+			break;
+	}
+
+	if (&script->head == &pmu->memx.cache)
+		goto done;
+
+	for (i = 0; i < script->inputs; i++) {
+		const u32 addr = script->data[i * 2 + 0];
+		const u32 data = script->data[i * 2 + 1];
+		if (nvkm_rd32(device, addr) != data) {
+			nvkm_debug(&pmu->subdev, "script %d->%d/%d stale, "
+				   "R[%06x] != %08x\n", from, to, band,
+				   addr, data);
+			list_del(&script->head);
+			kvfree(script);
+			goto done;
+		}
+	}
+
+	memx = memx_new(pmu, script->base, script->size);
+	if (!memx) {
+		ret = -ENOMEM;
+		goto done;
+	}
+
+	memcpy(memx->data, script->data + script->inputs * 2,
+	       script->words * sizeof(u32));
+	memx->words = script->words;
+	memx->cached = true;
+	list_move(&script->head, &pmu->memx.cache);
+	*pmemx = memx;
+	ret = 0;
+done:
+	mutex_unlock(&pmu->memx.mutex);
+	return ret;
+}
+
+void
+nvkm_memx_key(struct nvkm_memx *memx, u32 from, u32 to, u32 band)
+{
+	memx->key.valid = true;
+	memx->key.from = from;
+	memx->key.to = to;
+	memx->key.band = band;
+}
+
+/* Records a register value that the script being built depends on. */
+void
+nvkm_memx_input(struct nvkm_memx *memx, u32 addr, u32 data)
+{
+	int i;
+
+	if (!memx->key.valid)
+		return;
+
+	for (i = 0; i < memx->inputs; i++) {
+		if (memx->input[i][0] == addr && memx->input[i][1] == data)
+			return;
+	}
+
+	if (memx->inputs == ARRAY_SIZE(memx->input)) {
+		memx->key.valid = false;
+		return;
+	}
+
+	memx->input[memx->inputs][0] = addr;
+	memx->input[memx->inputs][1] = data;
+	memx->inputs++;
+}
+
+int
+nvkm_memx_init(struct nvkm_pmu *pmu, struct nvkm_memx **pmemx)
+{
 	u32 reply[2];
 	int ret;
 
@@ -53,18 +274,10 @@ nvkm_memx_init(struct nvkm_pmu *pmu, struct nvkm_memx **pmemx)
 	if (ret)
 		return ret;
 
-	memx = *pmemx = kzalloc(sizeof(*memx), GFP_KERNEL);
-	if (!memx)
+	*pmemx = memx_new(pmu, reply[0], reply[1]);
+	if (!*pmemx)
 		return -ENOMEM;
-	memx->pmu = pmu;
-	memx->base = reply[0];
-	memx->size = reply[1];
-
-	/* acquire data segment access */
-	do {
-		nvkm_wr32(device, 0x10a580, 0x00000003);
-	} while (nvkm_rd32(device, 0x10a580) != 0x00000003);
-	nvkm_wr32(device, 0x10a1c0, 0x01000000 | memx->base);
+
 	return 0;
 }
 
@@ -76,24 +289,41 @@ nvkm_memx_fini(struct nvkm_memx **pmemx, bool exec)
 	struct nvkm_subdev *subdev = &pmu->subdev;
 	struct nvkm_device *device = subdev->device;
 	u32 finish, reply[2];
+	int ret = 0;
 
 	/* flush the cache... */
 	memx_out(memx);
+	if (memx->overflow) {
+		ret = -ENOSPC;
+		goto done;
+	}
 
-	/* release data segment access */
-	finish = nvkm_rd32(device, 0x10a1c0) & 0x00ffffff;
-	nvkm_wr32(device, 0x10a580, 0x00000000);
-
-	/* call MEMX process to execute the script, and wait for reply */
 	if (exec) {
-		nvkm_pmu_send(pmu, reply, PROC_MEMX, MEMX_MSG_EXEC,
-			      memx->base, finish);
-		nvkm_debug(subdev, "Exec took %uns, PMU_IN %08x\n",
-			   reply[0], reply[1]);
+		/* upload the script, holding data segment access */
+		do {
+			nvkm_wr32(device, 0x10a580, 0x00000003);
+		} while (nvkm_rd32(device, 0x10a580) != 0x00000003);
+		nvkm_falcon_load_dmem(&pmu->falcon, memx->data, memx->base,
+				      memx->words * 4, 0);
+		nvkm_wr32(device, 0x10a580, 0x00000000);
+		finish = memx->base + memx->words * 4;
+
+		/* call MEMX process to execute the script, and wait for reply */
+		ret = nvkm_pmu_send(pmu, reply, PROC_MEMX, MEMX_MSG_EXEC,
+				    memx->base, finish);
+		nvkm_debug(subdev, "Exec%s took %uns, PMU_IN %08x\n",
+			   memx->cached ? " (cached)" : "", reply[0], reply[1]);
+
+		if (ret == 0 && memx->key.valid && !memx->cached) {
+			mutex_lock(&pmu->memx.mutex);
+			memx_cache_put(memx);
+			mutex_unlock(&pmu->memx.mutex);
+		}
 	}
 
-	kfree(memx);
-	return 0;
+done:
+	memx_del(pmemx);
+	return ret;
 }
 
 void
@@ -131,10 +361,12 @@ nvkm_memx_wait_vblank(struct nvkm_memx *memx)
 
 	if (device->chipset < 0xd0) {
 		heads = nvkm_rd32(device, 0x610050);
+		nvkm_memx_input(memx, 0x610050, heads);
 		for (i = 0; i < 2; i++) {
 			/* Heuristic: sync to head with biggest resolution */
 			if (heads & (2 << (i << 3))) {
 				x = nvkm_rd32(device, 0x610b40 + (0x540 * i));
+				nvkm_memx_input(memx, 0x610b40 + (0x540 * i), x);
 				y = (x & 0xffff0000) >> 16;
 				x &= 0x0000ffff;
 				if ((x * y) > px) {
@@ -26,21 +26,13 @@
 #include <core/option.h>
 #include <subdev/pmu.h>
 
-int
-nvkm_therm_temp_get(struct nvkm_therm *therm)
-{
-	if (therm->func->temp_get)
-		return therm->func->temp_get(therm);
-	return -ENODEV;
-}
-
 static int
 nvkm_therm_update_trip(struct nvkm_therm *therm)
 {
 	struct nvbios_therm_trip_point *trip = therm->fan->bios.trip,
 				       *cur_trip = NULL,
 				       *last_trip = therm->last_trip;
-	u8  temp = therm->func->temp_get(therm);
+	u8  temp = nvkm_therm_temp_get(therm);
 	u16 duty, i;
 
 	/* look for the trip point corresponding to the current temperature */
@@ -70,7 +62,7 @@ static int
 nvkm_therm_compute_linear_duty(struct nvkm_therm *therm, u8 linear_min_temp,
                                u8 linear_max_temp)
 {
-	u8  temp = therm->func->temp_get(therm);
+	u8  temp = nvkm_therm_temp_get(therm);
 	u16 duty;
 
 	/* handle the non-linear part first */
@@ -200,7 +192,7 @@ nvkm_therm_fan_mode(struct nvkm_therm *therm, int mode)
 	/* do not allow automatic fan management if the thermal sensor is
 	 * not available */
 	if (mode == NVKM_THERM_CTRL_AUTO &&
-	    therm->func->temp_get(therm) < 0)
+	    nvkm_therm_temp_get(therm) < 0)
 		return -EINVAL;
 
 	if (therm->mode == mode)
@@ -345,6 +337,8 @@ nvkm_therm_fini(struct nvkm_subdev *subdev, bool suspend)
 {
 	struct nvkm_therm *therm = nvkm_therm(subdev);
 
+	nvkm_therm_sample_fini(therm);
+
 	if (therm->func->fini)
 		therm->func->fini(therm);
 
@@ -390,6 +384,7 @@ nvkm_therm_init(struct nvkm_subdev *subdev)
 
 	nvkm_therm_sensor_init(therm);
 	nvkm_therm_fan_init(therm);
+	nvkm_therm_sample_init(therm);
 	return 0;
 }
 
@@ -407,6 +402,7 @@ static void *
 nvkm_therm_dtor(struct nvkm_subdev *subdev)
 {
 	struct nvkm_therm *therm = nvkm_therm(subdev);
+	flush_work(&therm->sample.work);
 	kfree(therm->fan);
 	return therm;
 }
@@ -430,6 +426,7 @@ nvkm_therm_ctor(struct nvkm_therm *therm, struct nvkm_device *device,
 	nvkm_alarm_init(&therm->alarm, nvkm_therm_alarm);
 	spin_lock_init(&therm->lock);
 	spin_lock_init(&therm->sensor.alarm_program_lock);
+	nvkm_therm_sample_ctor(therm);
 
 	therm->fan_get = nvkm_therm_fan_user_get;
 	therm->fan_set = nvkm_therm_fan_user_set;
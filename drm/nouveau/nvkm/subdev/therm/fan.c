@@ -121,7 +121,7 @@ nvkm_therm_fan_set(struct nvkm_therm *therm, bool immediate, int percent)
 }
 
 int
-nvkm_therm_fan_sense(struct nvkm_therm *therm)
+nvkm_therm_fan_tach(struct nvkm_therm *therm)
 {
 	struct nvkm_device *device = therm->subdev.device;
 	struct nvkm_timer *tmr = device->timer;
@@ -67,6 +67,11 @@ int nvkm_therm_fan_get(struct nvkm_therm *);
 int nvkm_therm_fan_set(struct nvkm_therm *, bool now, int percent);
 int nvkm_therm_fan_user_get(struct nvkm_therm *);
 int nvkm_therm_fan_user_set(struct nvkm_therm *, int percent);
+int nvkm_therm_fan_tach(struct nvkm_therm *);
+
+void nvkm_therm_sample_ctor(struct nvkm_therm *);
+void nvkm_therm_sample_init(struct nvkm_therm *);
+void nvkm_therm_sample_fini(struct nvkm_therm *);
 
 int  nvkm_therm_sensor_init(struct nvkm_therm *);
 int  nvkm_therm_sensor_fini(struct nvkm_therm *, bool suspend);
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "priv.h"
+
+#include <core/option.h>
+#include <subdev/iccsense.h>
+
+static void
+nvkm_therm_sample_set(struct nvkm_therm *therm,
+		      struct nvkm_therm_sample *sample, int value, u64 time)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&therm->sample.lock, flags);
+	sample->value = value;
+	sample->time = time;
+	spin_unlock_irqrestore(&therm->sample.lock, flags);
+}
+
+/* Serves a reading from the last sample while it's younger than the
+ * polling period, and only goes to the hardware otherwise.
+ */
+static int
+nvkm_therm_sample_get(struct nvkm_therm *therm,
+		      struct nvkm_therm_sample *sample,
+		      int (*read)(struct nvkm_therm *))
+{
+	struct nvkm_timer *tmr = therm->subdev.device->timer;
+	u64 time = nvkm_timer_read(tmr);
+	unsigned long flags;
+	int value;
+
+	spin_lock_irqsave(&therm->sample.lock, flags);
+	if (sample->time && time - sample->time < therm->sample.period) {
+		value = sample->value;
+		spin_unlock_irqrestore(&therm->sample.lock, flags);
+		return value;
+	}
+	spin_unlock_irqrestore(&therm->sample.lock, flags);
+
+	value = read(therm);
+	nvkm_therm_sample_set(therm, sample, value, time);
+	return value;
+}
+
+/* Good enough for fan control and reporting.  Threshold handling must use
+ * therm->func->temp_get() directly, as it acts on the reading.
+ */
+int
+nvkm_therm_temp_get(struct nvkm_therm *therm)
+{
+	if (!therm->func->temp_get)
+		return -ENODEV;
+
+	return nvkm_therm_sample_get(therm, &therm->sample.temp,
+				     therm->func->temp_get);
+}
+
+int
+nvkm_therm_fan_sense(struct nvkm_therm *therm)
+{
+	return nvkm_therm_sample_get(therm, &therm->sample.fan,
+				     nvkm_therm_fan_tach);
+}
+
+void
+nvkm_therm_sample(struct nvkm_therm *therm)
+{
+	struct nvkm_device *device = therm->subdev.device;
+	u64 time = nvkm_timer_read(device->timer);
+
+	if (therm->func->temp_get) {
+		nvkm_therm_sample_set(therm, &therm->sample.temp,
+				      therm->func->temp_get(therm), time);
+	}
+
+	/* Timing the tachometer GPIO takes up to 250ms, so fans without
+	 * a tach counter are only measured when someone asks.
+	 */
+	if (therm->func->fan_sense) {
+		nvkm_therm_sample_set(therm, &therm->sample.fan,
+				      therm->func->fan_sense(therm), time);
+	}
+
+	if (device->iccsense)
+		nvkm_iccsense_sample(device->iccsense);
+}
+
+static void
+nvkm_therm_sample_work(struct work_struct *work)
+{
+	struct nvkm_therm *therm =
+	       container_of(work, struct nvkm_therm, sample.work);
+	struct nvkm_timer *tmr = therm->subdev.device->timer;
+	unsigned long flags;
+
+	nvkm_therm_sample(therm);
+
+	spin_lock_irqsave(&therm->sample.lock, flags);
+	if (therm->sample.enabled)
+		nvkm_timer_alarm(tmr, therm->sample.period, &therm->sample.alarm);
+	spin_unlock_irqrestore(&therm->sample.lock, flags);
+}
+
+static void
+nvkm_therm_sample_alarm(struct nvkm_alarm *alarm)
+{
+	struct nvkm_therm *therm =
+	       container_of(alarm, struct nvkm_therm, sample.alarm);
+	schedule_work(&therm->sample.work);
+}
+
+void
+nvkm_therm_sample_init(struct nvkm_therm *therm)
+{
+	unsigned long flags;
+
+	if (!therm->sample.period)
+		return;
+
+	spin_lock_irqsave(&therm->sample.lock, flags);
+	therm->sample.enabled = true;
+	spin_unlock_irqrestore(&therm->sample.lock, flags);
+	schedule_work(&therm->sample.work);
+}
+
+void
+nvkm_therm_sample_fini(struct nvkm_therm *therm)
+{
+	struct nvkm_timer *tmr = therm->subdev.device->timer;
+	unsigned long flags;
+
+	spin_lock_irqsave(&therm->sample.lock, flags);
+	therm->sample.enabled = false;
+	spin_unlock_irqrestore(&therm->sample.lock, flags);
+
+	nvkm_timer_alarm(tmr, 0, &therm->sample.alarm);
+	flush_work(&therm->sample.work);
+
+	spin_lock_irqsave(&therm->sample.lock, flags);
+	therm->sample.temp.time = 0;
+	therm->sample.fan.time = 0;
+	spin_unlock_irqrestore(&therm->sample.lock, flags);
+}
+
+void
+nvkm_therm_sample_ctor(struct nvkm_therm *therm)
+{
+	struct nvkm_device *device = therm->subdev.device;
+	long period = nvkm_longopt(device->cfgopt, "NvSensorPeriod", 1000);
+
+	nvkm_alarm_init(&therm->sample.alarm, nvkm_therm_sample_alarm);
+	INIT_WORK(&therm->sample.work, nvkm_therm_sample_work);
+	spin_lock_init(&therm->sample.lock);
+	therm->sample.period = clamp(period, 0L, 4000L) * 1000000;
+}
@@ -23,12 +23,97 @@
  */
 #include "priv.h"
 
+static LIST_HEAD(nvkm_timer_sites);
+static DEFINE_SPINLOCK(nvkm_timer_sites_lock);
+
+int
+nvkm_timer_site(int index, struct nvkm_timer_site *copy)
+{
+	struct nvkm_timer_site *site;
+	unsigned long flags;
+	int ret = -ENOENT;
+
+	spin_lock_irqsave(&nvkm_timer_sites_lock, flags);
+	list_for_each_entry(site, &nvkm_timer_sites, head) {
+		if (index-- == 0) {
+			copy->file = site->file;
+			copy->cond = site->cond;
+			copy->line = site->line;
+			atomic64_set(&copy->calls, atomic64_read(&site->calls));
+			atomic64_set(&copy->reads, atomic64_read(&site->reads));
+			atomic64_set(&copy->time, atomic64_read(&site->time));
+			atomic64_set(&copy->time_max,
+				     atomic64_read(&site->time_max));
+			atomic64_set(&copy->timeouts,
+				     atomic64_read(&site->timeouts));
+			ret = 0;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&nvkm_timer_sites_lock, flags);
+	return ret;
+}
+
+void
+nvkm_timer_site_reset(void)
+{
+	struct nvkm_timer_site *site;
+	unsigned long flags;
+
+	spin_lock_irqsave(&nvkm_timer_sites_lock, flags);
+	list_for_each_entry(site, &nvkm_timer_sites, head) {
+		atomic64_set(&site->calls, 0);
+		atomic64_set(&site->reads, 0);
+		atomic64_set(&site->time, 0);
+		atomic64_set(&site->time_max, 0);
+		atomic64_set(&site->timeouts, 0);
+	}
+	spin_unlock_irqrestore(&nvkm_timer_sites_lock, flags);
+}
+
+/* A wait that ended with 'break' evaluated its condition once more than
+ * it tested the timer.  Timeouts of NVKM_DELAY loops aren't counted.
+ *
+ * The registry lock is only taken the first time a site runs.
+ */
+void
+nvkm_timer_wait_fini(struct nvkm_timer_wait *wait, s64 taken, bool warn)
+{
+	struct nvkm_timer_site *site = wait->site;
+	s64 time = wait->tests ? wait->time1 - wait->time0 : 0;
+	unsigned long flags;
+	s64 prev, max;
+
+	if (!atomic_read(&site->registered) &&
+	    !atomic_xchg(&site->registered, 1)) {
+		spin_lock_irqsave(&nvkm_timer_sites_lock, flags);
+		list_add_tail(&site->head, &nvkm_timer_sites);
+		spin_unlock_irqrestore(&nvkm_timer_sites_lock, flags);
+	}
+
+	atomic64_inc(&site->calls);
+	atomic64_add(wait->tests + (taken >= 0), &site->reads);
+	atomic64_add(time, &site->time);
+	if (warn && taken < 0)
+		atomic64_inc(&site->timeouts);
+
+	max = atomic64_read(&site->time_max);
+	while (time > max) {
+		prev = atomic64_cmpxchg(&site->time_max, max, time);
+		if (prev == max)
+			break;
+		max = prev;
+	}
+}
+
 s64
 nvkm_timer_wait_test(struct nvkm_timer_wait *wait)
 {
 	struct nvkm_subdev *subdev = &wait->tmr->subdev;
 	u64 time = nvkm_timer_read(wait->tmr);
 
+	wait->tests++;
+
 	if (wait->reads == 0) {
 		wait->time0 = time;
 		wait->time1 = time;
@@ -52,11 +137,13 @@ nvkm_timer_wait_test(struct nvkm_timer_wait *wait)
 
 void
 nvkm_timer_wait_init(struct nvkm_device *device, u64 nsec,
-		     struct nvkm_timer_wait *wait)
+		     struct nvkm_timer_site *site, struct nvkm_timer_wait *wait)
 {
 	wait->tmr = device->timer;
+	wait->site = site;
 	wait->limit = nsec;
 	wait->reads = 0;
+	wait->tests = 0;
 }
 
 u64
@@ -44,14 +44,9 @@ u32
 nvkm_top_addr(struct nvkm_device *device, enum nvkm_devidx index)
 {
 	struct nvkm_top *top = device->top;
-	struct nvkm_top_device *info;
 
-	if (top) {
-		list_for_each_entry(info, &top->device, head) {
-			if (info->index == index)
-				return info->addr;
-		}
-	}
+	if (top && index >= 0 && index <= NVKM_SUBDEV_NR)
+		return top->index[index].addr;
 
 	return 0;
 }
@@ -60,14 +55,9 @@ u32
 nvkm_top_reset(struct nvkm_device *device, enum nvkm_devidx index)
 {
 	struct nvkm_top *top = device->top;
-	struct nvkm_top_device *info;
 
-	if (top) {
-		list_for_each_entry(info, &top->device, head) {
-			if (info->index == index && info->reset >= 0)
-				return BIT(info->reset);
-		}
-	}
+	if (top && index >= 0 && index <= NVKM_SUBDEV_NR)
+		return top->index[index].reset;
 
 	return 0;
 }
@@ -76,14 +66,9 @@ u32
 nvkm_top_intr_mask(struct nvkm_device *device, enum nvkm_devidx devidx)
 {
 	struct nvkm_top *top = device->top;
-	struct nvkm_top_device *info;
 
-	if (top) {
-		list_for_each_entry(info, &top->device, head) {
-			if (info->index == devidx && info->intr >= 0)
-				return BIT(info->intr);
-		}
-	}
+	if (top && devidx >= 0 && devidx <= NVKM_SUBDEV_NR)
+		return top->index[devidx].intr;
 
 	return 0;
 }
@@ -92,35 +77,26 @@ u32
 nvkm_top_intr(struct nvkm_device *device, u32 intr, u64 *psubdevs)
 {
 	struct nvkm_top *top = device->top;
-	struct nvkm_top_device *info;
 	u64 subdevs = 0;
 	u32 handled = 0;
 
 	if (top) {
-		list_for_each_entry(info, &top->device, head) {
-			if (info->index != NVKM_SUBDEV_NR && info->intr >= 0) {
-				if (intr & BIT(info->intr)) {
-					subdevs |= BIT_ULL(info->index);
-					handled |= BIT(info->intr);
-				}
-			}
-		}
+		handled = intr & top->intr_mask;
+		for (intr &= ~handled; handled; handled &= handled - 1)
+			subdevs |= top->intr[__ffs(handled)];
 	}
 
 	*psubdevs = subdevs;
-	return intr & ~handled;
+	return intr;
 }
 
 int
 nvkm_top_fault_id(struct nvkm_device *device, enum nvkm_devidx devidx)
 {
 	struct nvkm_top *top = device->top;
-	struct nvkm_top_device *info;
 
-	list_for_each_entry(info, &top->device, head) {
-		if (info->index == devidx && info->fault >= 0)
-			return info->fault;
-	}
+	if (devidx >= 0 && devidx <= NVKM_SUBDEV_NR)
+		return top->index[devidx].fault;
 
 	return -ENOENT;
 }
@@ -131,6 +107,9 @@ nvkm_top_fault(struct nvkm_device *device, int fault)
 	struct nvkm_top *top = device->top;
 	struct nvkm_top_device *info;
 
+	if (fault >= 0 && fault < ARRAY_SIZE(top->fault))
+		return top->fault[fault];
+
 	list_for_each_entry(info, &top->device, head) {
 		if (info->fault == fault)
 			return info->index;
@@ -146,6 +125,15 @@ nvkm_top_engine(struct nvkm_device *device, int index, int *runl, int *engn)
 	struct nvkm_top_device *info;
 	int n = 0;
 
+	if (index >= 0 && index < ARRAY_SIZE(top->engine)) {
+		if (index >= top->engine_nr)
+			return -ENODEV;
+		info = top->engine[index];
+		*runl = info->runlist;
+		*engn = info->engine;
+		return info->index;
+	}
+
 	list_for_each_entry(info, &top->device, head) {
 		if (info->engine >= 0 && info->runlist >= 0 && n++ == index) {
 			*runl = info->runlist;
@@ -157,11 +145,65 @@ nvkm_top_engine(struct nvkm_device *device, int index, int *runl, int *engn)
 	return -ENODEV;
 }
 
+/* Builds the per-devidx, per-fault-id, per-engine and per-intr-bit
+ * lookup tables.  Entries are visited in table order, and the first
+ * to match wins, the same as a walk of the device list would.
+ */
+static void
+nvkm_top_index(struct nvkm_top *top)
+{
+	struct nvkm_top_device *info;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(top->index); i++) {
+		top->index[i].addr = 0;
+		top->index[i].reset = 0;
+		top->index[i].intr = 0;
+		top->index[i].fault = -ENOENT;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(top->fault); i++)
+		top->fault[i] = NVKM_SUBDEV_NR;
+
+	top->engine_nr = 0;
+	top->intr_mask = 0;
+	memset(top->intr, 0x00, sizeof(top->intr));
+
+	list_for_each_entry_reverse(info, &top->device, head) {
+		if (info->index < 0 || info->index > NVKM_SUBDEV_NR)
+			continue;
+
+		top->index[info->index].addr = info->addr;
+		if (info->reset >= 0)
+			top->index[info->index].reset = BIT(info->reset);
+		if (info->intr >= 0)
+			top->index[info->index].intr = BIT(info->intr);
+		if (info->fault >= 0)
+			top->index[info->index].fault = info->fault;
+		if (info->fault >= 0 && info->fault < ARRAY_SIZE(top->fault))
+			top->fault[info->fault] = info->index;
+	}
+
+	list_for_each_entry(info, &top->device, head) {
+		if (info->engine >= 0 && info->runlist >= 0 &&
+		    top->engine_nr < ARRAY_SIZE(top->engine))
+			top->engine[top->engine_nr++] = info;
+
+		if (info->index != NVKM_SUBDEV_NR && info->intr >= 0) {
+			top->intr[info->intr] |= BIT_ULL(info->index);
+			top->intr_mask |= BIT(info->intr);
+		}
+	}
+}
+
 static int
 nvkm_top_oneinit(struct nvkm_subdev *subdev)
 {
 	struct nvkm_top *top = nvkm_top(subdev);
-	return top->func->oneinit(top);
+	int ret = top->func->oneinit(top);
+	if (ret == 0)
+		nvkm_top_index(top);
+	return ret;
 }
 
 static void *
@@ -194,5 +236,6 @@ nvkm_top_new_(const struct nvkm_top_func *func, struct nvkm_device *device,
 	nvkm_subdev_ctor(&nvkm_top, device, index, &top->subdev);
 	top->func = func;
 	INIT_LIST_HEAD(&top->device);
+	nvkm_top_index(top);
 	return 0;
 }
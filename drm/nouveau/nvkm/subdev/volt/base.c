@@ -78,74 +78,92 @@ nvkm_volt_set(struct nvkm_volt *volt, u32 uv)
 	return ret;
 }
 
+static const struct nvbios_vmap_entry *
+nvkm_volt_map_entry(struct nvkm_volt *volt, u8 id, u8 *ver,
+		    struct nvbios_vmap_entry *info)
+{
+	struct nvkm_bios *bios = volt->subdev.device->bios;
+	u8 len;
+
+	if (volt->map) {
+		if (id >= volt->map_nr)
+			return NULL;
+		*ver = volt->map_ver;
+		return &volt->map[id];
+	}
+
+	if (nvbios_vmap_entry_parse(bios, id, ver, &len, info))
+		return info;
+	return NULL;
+}
+
 int
 nvkm_volt_map_min(struct nvkm_volt *volt, u8 id)
 {
-	struct nvkm_bios *bios = volt->subdev.device->bios;
-	struct nvbios_vmap_entry info;
-	u8  ver, len;
-	u32 vmap;
-
-	vmap = nvbios_vmap_entry_parse(bios, id, &ver, &len, &info);
-	if (vmap) {
-		if (info.link != 0xff) {
-			int ret = nvkm_volt_map_min(volt, info.link);
+	const struct nvbios_vmap_entry *info;
+	struct nvbios_vmap_entry entry;
+	u8  ver;
+
+	info = nvkm_volt_map_entry(volt, id, &ver, &entry);
+	if (info) {
+		u32 min = info->min;
+		if (info->link != 0xff) {
+			int ret = nvkm_volt_map_min(volt, info->link);
 			if (ret < 0)
 				return ret;
-			info.min += ret;
+			min += ret;
 		}
-		return info.min;
+		return min;
 	}
 
 	return id ? id * 10000 : -ENODEV;
 }
 
-int
-nvkm_volt_map(struct nvkm_volt *volt, u8 id, u8 temp)
+static int
+nvkm_volt_map_eval(struct nvkm_volt *volt, u8 id, u8 temp)
 {
-	struct nvkm_bios *bios = volt->subdev.device->bios;
-	struct nvbios_vmap_entry info;
-	u8  ver, len;
-	u32 vmap;
+	const struct nvbios_vmap_entry *info;
+	struct nvbios_vmap_entry entry;
+	u8  ver;
 
-	vmap = nvbios_vmap_entry_parse(bios, id, &ver, &len, &info);
-	if (vmap) {
+	info = nvkm_volt_map_entry(volt, id, &ver, &entry);
+	if (info) {
 		s64 result;
 
 		if (volt->speedo < 0)
 			return volt->speedo;
 
-		if (ver == 0x10 || (ver == 0x20 && info.mode == 0)) {
-			result  = div64_s64((s64)info.arg[0], 10);
-			result += div64_s64((s64)info.arg[1] * volt->speedo, 10);
-			result += div64_s64((s64)info.arg[2] * volt->speedo * volt->speedo, 100000);
+		if (ver == 0x10 || (ver == 0x20 && info->mode == 0)) {
+			result  = div64_s64((s64)info->arg[0], 10);
+			result += div64_s64((s64)info->arg[1] * volt->speedo, 10);
+			result += div64_s64((s64)info->arg[2] * volt->speedo * volt->speedo, 100000);
 		} else if (ver == 0x20) {
-			switch (info.mode) {
+			switch (info->mode) {
 			/* 0x0 handled above! */
 			case 0x1:
-				result =  ((s64)info.arg[0] * 15625) >> 18;
-				result += ((s64)info.arg[1] * volt->speedo * 15625) >> 18;
-				result += ((s64)info.arg[2] * temp * 15625) >> 10;
-				result += ((s64)info.arg[3] * volt->speedo * temp * 15625) >> 18;
-				result += ((s64)info.arg[4] * volt->speedo * volt->speedo * 15625) >> 30;
-				result += ((s64)info.arg[5] * temp * temp * 15625) >> 18;
+				result =  ((s64)info->arg[0] * 15625) >> 18;
+				result += ((s64)info->arg[1] * volt->speedo * 15625) >> 18;
+				result += ((s64)info->arg[2] * temp * 15625) >> 10;
+				result += ((s64)info->arg[3] * volt->speedo * temp * 15625) >> 18;
+				result += ((s64)info->arg[4] * volt->speedo * volt->speedo * 15625) >> 30;
+				result += ((s64)info->arg[5] * temp * temp * 15625) >> 18;
 				break;
 			case 0x3:
-				result = (info.min + info.max) / 2;
+				result = (info->min + info->max) / 2;
 				break;
 			case 0x2:
 			default:
-				result = info.min;
+				result = info->min;
 				break;
 			}
 		} else {
 			return -ENODEV;
 		}
 
-		result = min(max(result, (s64)info.min), (s64)info.max);
+		result = min(max(result, (s64)info->min), (s64)info->max);
 
-		if (info.link != 0xff) {
-			int ret = nvkm_volt_map(volt, info.link, temp);
+		if (info->link != 0xff) {
+			int ret = nvkm_volt_map_eval(volt, info->link, temp);
 			if (ret < 0)
 				return ret;
 			result += ret;
@@ -156,6 +174,48 @@ nvkm_volt_map(struct nvkm_volt *volt, u8 id, u8 temp)
 	return id ? id * 10000 : -ENODEV;
 }
 
+static void
+nvkm_volt_map_flush(struct nvkm_volt *volt)
+{
+	int i;
+
+	spin_lock(&volt->map_cache.lock);
+	for (i = 0; i < ARRAY_SIZE(volt->map_cache.entry); i++)
+		volt->map_cache.entry[i].valid = false;
+	spin_unlock(&volt->map_cache.lock);
+}
+
+int
+nvkm_volt_map(struct nvkm_volt *volt, u8 id, u8 temp)
+{
+	typeof(volt->map_cache.entry[0]) *entry;
+	int ret;
+
+	/* The clk subdev asks for the same handful of ids, for each cstate
+	 * of each pstate, every time the temperature changes.
+	 */
+	entry = &volt->map_cache.entry[(id * 31 + temp) %
+				       ARRAY_SIZE(volt->map_cache.entry)];
+
+	spin_lock(&volt->map_cache.lock);
+	if (entry->valid && entry->id == id && entry->temp == temp) {
+		ret = entry->uv;
+		spin_unlock(&volt->map_cache.lock);
+		return ret;
+	}
+	spin_unlock(&volt->map_cache.lock);
+
+	ret = nvkm_volt_map_eval(volt, id, temp);
+
+	spin_lock(&volt->map_cache.lock);
+	entry->valid = true;
+	entry->id = id;
+	entry->temp = temp;
+	entry->uv = ret;
+	spin_unlock(&volt->map_cache.lock);
+	return ret;
+}
+
 int
 nvkm_volt_set_id(struct nvkm_volt *volt, u8 id, u8 min_id, u8 temp,
 		 int condition)
@@ -229,6 +289,25 @@ nvkm_volt_parse_bios(struct nvkm_bios *bios, struct nvkm_volt *volt)
 	}
 }
 
+static void
+nvkm_volt_parse_vmap(struct nvkm_bios *bios, struct nvkm_volt *volt)
+{
+	u8  ver, hdr, cnt, len;
+	int i;
+
+	if (!nvbios_vmap_table(bios, &ver, &hdr, &cnt, &len) || !cnt)
+		return;
+
+	volt->map = kcalloc(cnt, sizeof(*volt->map), GFP_KERNEL);
+	if (!volt->map)
+		return;
+
+	for (i = 0; i < cnt; i++)
+		nvbios_vmap_entry_parse(bios, i, &ver, &len, &volt->map[i]);
+	volt->map_ver = ver;
+	volt->map_nr = cnt;
+}
+
 static int
 nvkm_volt_speedo_read(struct nvkm_volt *volt)
 {
@@ -257,6 +336,7 @@ nvkm_volt_oneinit(struct nvkm_subdev *subdev)
 	struct nvkm_volt *volt = nvkm_volt(subdev);
 
 	volt->speedo = nvkm_volt_speedo_read(volt);
+	nvkm_volt_map_flush(volt);
 	if (volt->speedo > 0)
 		nvkm_debug(&volt->subdev, "speedo %x\n", volt->speedo);
 
@@ -269,7 +349,9 @@ nvkm_volt_oneinit(struct nvkm_subdev *subdev)
 static void *
 nvkm_volt_dtor(struct nvkm_subdev *subdev)
 {
-	return nvkm_volt(subdev);
+	struct nvkm_volt *volt = nvkm_volt(subdev);
+	kfree(volt->map);
+	return volt;
 }
 
 static const struct nvkm_subdev_func
@@ -288,6 +370,7 @@ nvkm_volt_ctor(const struct nvkm_volt_func *func, struct nvkm_device *device,
 
 	nvkm_subdev_ctor(&nvkm_volt, device, index, &volt->subdev);
 	volt->func = func;
+	spin_lock_init(&volt->map_cache.lock);
 
 	/* Assuming the non-bios device should build the voltage table later */
 	if (bios) {
@@ -302,6 +385,7 @@ nvkm_volt_ctor(const struct nvkm_volt_func *func, struct nvkm_device *device,
 			volt->max0_id = vmap.max0;
 			volt->max1_id = vmap.max1;
 			volt->max2_id = vmap.max2;
+			nvkm_volt_parse_vmap(bios, volt);
 		} else {
 			volt->max0_id = 0xff;
 			volt->max1_id = 0xff;
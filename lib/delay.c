@@ -0,0 +1,135 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <nvif/os.h>
+
+#include "priv.h"
+
+/* Short delays spin on the monotonic clock, which is read from the vDSO
+ * (and so, on most systems, the TSC) without entering the kernel.  Longer
+ * ones sleep for all but the measured scheduler latency, and spin for the
+ * remainder.
+ */
+static pthread_once_t os_delay_once = PTHREAD_ONCE_INIT;
+static u64 os_delay_slack;
+
+static DEFINE_MUTEX(os_delay_mutex);
+static struct nvos_delay_site *os_delay_sites;
+
+static inline u64
+os_delay_now(void)
+{
+	return ktime_to_ns(ktime_get());
+}
+
+static inline void
+os_delay_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+
+static void
+os_delay_calibrate(void)
+{
+	const struct timespec ts = { .tv_nsec = 1000 };
+	u64 time, slack = 0;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		time = os_delay_now();
+		nanosleep(&ts, NULL);
+		time = os_delay_now() - time;
+		slack = max(slack, time);
+	}
+
+	os_delay_slack = clamp(slack, 10000ULL, 2000000ULL);
+}
+
+static void
+os_delay_account(struct nvos_delay_site *site, u64 nsec, u64 time)
+{
+	u64 late = time > nsec ? time - nsec : 0;
+	u64 prev;
+
+	if (!__sync_lock_test_and_set(&site->registered, 1)) {
+		mutex_lock(&os_delay_mutex);
+		site->next = os_delay_sites;
+		os_delay_sites = site;
+		mutex_unlock(&os_delay_mutex);
+	}
+
+	__sync_fetch_and_add(&site->calls, 1);
+	__sync_fetch_and_add(&site->nsec_req, nsec);
+	__sync_fetch_and_add(&site->nsec_act, time);
+	while ((prev = site->nsec_max) < late &&
+	       !__sync_bool_compare_and_swap(&site->nsec_max, prev, late));
+}
+
+void
+nvos_delay(u64 nsec, struct nvos_delay_site *site)
+{
+	u64 time = os_delay_now(), stop = time + nsec;
+
+	pthread_once(&os_delay_once, os_delay_calibrate);
+
+	if (nsec > os_delay_slack * 2) {
+		const u64 sleep = nsec - os_delay_slack;
+		const struct timespec ts = {
+			.tv_sec = sleep / 1000000000,
+			.tv_nsec = sleep % 1000000000,
+		};
+		nanosleep(&ts, NULL);
+	}
+
+	while (os_delay_now() < stop)
+		os_delay_relax();
+
+	os_delay_account(site, nsec, os_delay_now() - time);
+}
+
+void
+os_delay_stats(void (*func)(const struct nvos_delay_site *, void *),
+	       void *priv)
+{
+	struct nvos_delay_site *site;
+
+	mutex_lock(&os_delay_mutex);
+	for (site = os_delay_sites; site; site = site->next)
+		func(site, priv);
+	mutex_unlock(&os_delay_mutex);
+}
+
+void
+os_delay_reset(void)
+{
+	struct nvos_delay_site *site;
+
+	mutex_lock(&os_delay_mutex);
+	for (site = os_delay_sites; site; site = site->next) {
+		site->calls = 0;
+		site->nsec_req = 0;
+		site->nsec_act = 0;
+		site->nsec_max = 0;
+	}
+	mutex_unlock(&os_delay_mutex);
+}
@@ -23,32 +23,94 @@
  */
 #include <nvif/os.h>
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "priv.h"
+
+/* Firmware images are mapped read-only and shared between every device and
+ * subdev that requests them, keyed by the path they were found at.  Entries
+ * stay mapped once their last reference is dropped, so that the next device
+ * to request the same image doesn't have to go back to the filesystem, and
+ * are only unmapped by os_firmware_fini().
+ */
+struct os_firmware {
+	struct firmware base;
+	struct list_head head;
+	size_t mapped;
+	int refs;
+	char path[];
+};
+
+static DEFINE_MUTEX(os_firmware_mutex);
+static LIST_HEAD(os_firmware_list);
+static struct os_firmware_stats os_firmware_stat;
+
+static void
+os_firmware_del(struct os_firmware *fw)
+{
+	if (fw->mapped)
+		munmap((void *)fw->base.data, fw->mapped);
+	list_del(&fw->head);
+	free(fw);
+}
+
 static int
 request_firmware_(const struct firmware **pfw, const char *prefix,
 		  const char *name, struct device *dev)
 {
-	struct firmware *fw = malloc(sizeof(*fw));
-	char *path;
-	int fd;
+	struct os_firmware *fw, *temp;
+	struct stat st;
+	void *data = NULL;
+	int fd, ret = 0;
 
-	if (!(path = malloc(strlen(prefix) + strlen(name) + 1))) {
-		free(fw);
+	if (!(fw = malloc(sizeof(*fw) + strlen(prefix) + strlen(name) + 1)))
 		return -ENOMEM;
+	sprintf(fw->path, "%s%s", prefix, name);
+
+	mutex_lock(&os_firmware_mutex);
+	list_for_each_entry(temp, &os_firmware_list, head) {
+		if (!strcmp(temp->path, fw->path)) {
+			os_firmware_stat.hits++;
+			free(fw);
+			fw = temp;
+			goto done;
+		}
 	}
-	sprintf(path, "%s%s", prefix, name);
-
-	fd = open(path, O_RDONLY);
-	free(path);
-	if (fd >= 0) {
-		off_t len = lseek(fd, 0, SEEK_END);
-		fw->data = malloc(len);
-		fw->size = pread(fd, (void *)fw->data, len, 0);
-		*pfw = fw;
-		return 0;
+
+	fd = open(fw->path, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st)) {
+		if (fd >= 0)
+			close(fd);
+		free(fw);
+		ret = -EINVAL;
+		goto unlock;
 	}
 
-	free(fw);
-	return -EINVAL;
+	if (st.st_size) {
+		data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			close(fd);
+			free(fw);
+			ret = -ENOMEM;
+			goto unlock;
+		}
+	}
+	close(fd);
+
+	fw->base.size = st.st_size;
+	fw->base.data = data;
+	fw->mapped = st.st_size;
+	fw->refs = 0;
+	list_add_tail(&fw->head, &os_firmware_list);
+	os_firmware_stat.misses++;
+	os_firmware_stat.mapped += fw->mapped;
+done:
+	fw->refs++;
+	*pfw = &fw->base;
+unlock:
+	mutex_unlock(&os_firmware_mutex);
+	return ret;
 }
 
 int
@@ -63,10 +125,33 @@ request_firmware(const struct firmware **pfw, const char *name,
 }
 
 void
-release_firmware(const struct firmware *fw)
+release_firmware(const struct firmware *base)
+{
+	if (base) {
+		struct os_firmware *fw = container_of(base, typeof(*fw), base);
+		mutex_lock(&os_firmware_mutex);
+		WARN_ON(--fw->refs < 0);
+		mutex_unlock(&os_firmware_mutex);
+	}
+}
+
+void
+os_firmware_stats(struct os_firmware_stats *stats)
 {
-	if (fw) {
-		free((void *)fw->data);
-		free((void *)fw);
+	mutex_lock(&os_firmware_mutex);
+	*stats = os_firmware_stat;
+	mutex_unlock(&os_firmware_mutex);
+}
+
+void
+os_firmware_fini(void)
+{
+	struct os_firmware *fw, *temp;
+
+	mutex_lock(&os_firmware_mutex);
+	list_for_each_entry_safe(fw, temp, &os_firmware_list, head) {
+		if (!fw->refs)
+			os_firmware_del(fw);
 	}
+	mutex_unlock(&os_firmware_mutex);
 }
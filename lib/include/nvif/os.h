@@ -71,6 +71,7 @@ typedef dma_addr_t resource_size_t;
 #define max_t(t,a,b) max((t)(a), (t)(b))
 #define min_t(t,a,b) min((t)(a), (t)(b))
 #define clamp(a,b,c) min(max((a), (b)), (c))
+#define swap(a,b) do { typeof(a) __t = (a); (a) = (b); (b) = __t; } while (0)
 #define roundup(a,b) ((((a) + ((b) - 1)) / (b)) * (b))
 #define round_up(a,b) roundup((a), (b))
 #define rounddown(a,b) ((a) / (b) * (b))
@@ -127,6 +128,9 @@ typedef dma_addr_t resource_size_t;
 #define __acquires(a)
 #define __releases(a)
 #define __printf(a,b)
+#ifndef __must_check
+#define __must_check __attribute__((warn_unused_result))
+#endif
 #define __user
 
 #if defined(CONFIG_ARM)
@@ -380,6 +384,17 @@ bitmap_clear(unsigned long *addr, unsigned int pos, unsigned int bits)
 	for ((bit) = find_next_bit((addr), (size), 0); (bit) < (size);         \
 	     (bit) = find_next_bit((addr), (size), (bit) + 1))
 
+/******************************************************************************
+ * hash
+ *****************************************************************************/
+#define GOLDEN_RATIO_64 0x61c8864680b583ebULL
+
+static inline u32
+hash_64(u64 val, unsigned int bits)
+{
+	return (val * GOLDEN_RATIO_64) >> (64 - bits);
+}
+
 /******************************************************************************
  * atomics
  *****************************************************************************/
@@ -413,6 +428,16 @@ atomic_inc_not_zero(atomic_t *a)
 	return v != 0;
 }
 
+typedef struct atomic64 {
+	s64 value;
+} atomic64_t;
+
+#define atomic64_read(a) __atomic_load_n(&(a)->value, __ATOMIC_RELAXED)
+#define atomic64_set(a,b) __atomic_store_n(&(a)->value, (b), __ATOMIC_RELAXED)
+#define atomic64_inc(a) ((void) __sync_fetch_and_add(&(a)->value, 1))
+#define atomic64_add(b,a) ((void) __sync_fetch_and_add(&(a)->value, (b)))
+#define atomic64_cmpxchg(a,b,c) __sync_val_compare_and_swap(&(a)->value, (b), (c))
+
 /******************************************************************************
  * refcount
  *****************************************************************************/
@@ -421,6 +446,7 @@ typedef struct refcount {
 } refcount_t;
 
 #define refcount_set(a,b) atomic_set(&(a)->atomic, (b))
+#define refcount_read(a) atomic_read(&(a)->atomic)
 #define refcount_inc(a) atomic_inc(&(a)->atomic)
 #define refcount_inc_not_zero(a) atomic_inc_not_zero(&(a)->atomic)
 #define refcount_dec_and_test(a) atomic_dec_and_test(&(a)->atomic)
@@ -444,6 +470,7 @@ struct kref {
 
 #define kref_init(a) refcount_set(&(a)->refcount, 1)
 #define kref_get(a) refcount_inc(&(a)->refcount)
+#define kref_read(a) refcount_read(&(a)->refcount)
 #define kref_put(a,b) if (refcount_dec_and_test(&(a)->refcount)) b(a)
 
 /******************************************************************************
@@ -528,11 +555,15 @@ kstrtoul(const char *s, unsigned int base, unsigned long *res)
 /******************************************************************************
  * memory
  *****************************************************************************/
+#include <sys/mman.h>
+
 #define GFP_KERNEL    1
 #define __GFP_ZERO    2
 #define GFP_DMA32     4
 #define GFP_USER      8
 #define GFP_HIGHUSER 16
+#define __GFP_NOWARN 32
+#define __GFP_NORETRY 64
 
 typedef unsigned gfp_t;
 
@@ -562,8 +593,49 @@ kmemdup(const void *src, size_t len, gfp_t gfp)
 }
 
 struct page {
+	void *addr;
 };
 
+/* alloc_page() always fails, which subdevs that only want a scratch page
+ * for the GPU to write to cope with.  alloc_pages() hands out real memory,
+ * which a device can only DMA to if it has 'dma_virt' set (see below).
+ */
+static inline struct page *
+alloc_pages(gfp_t gfp, unsigned int order)
+{
+	size_t size = (size_t)PAGE_SIZE << order, i;
+	struct page *page;
+	void *addr;
+
+	if (posix_memalign(&addr, size, size))
+		return NULL;
+	if (order >= 9)
+		madvise(addr, size, MADV_HUGEPAGE);
+	if (gfp & __GFP_ZERO)
+		memset(addr, 0x00, size);
+
+	if (!(page = calloc(1 << order, sizeof(*page)))) {
+		free(addr);
+		return NULL;
+	}
+
+	for (i = 0; i < (1 << order); i++)
+		page[i].addr = (u8 *)addr + i * PAGE_SIZE;
+	return page;
+}
+
+static inline void
+__free_pages(struct page *page, unsigned int order)
+{
+	if (page) {
+		free(page->addr);
+		free(page);
+	}
+}
+
+#define nth_page(p,n) ((p) + (n))
+#define page_address(p) ((p)->addr)
+
 static inline struct page *
 alloc_page(gfp_t gfp)
 {
@@ -744,6 +816,30 @@ typedef struct rwlock_t {
 #define write_lock_irq(a) pthread_rwlock_wrlock(&(a)->lock)
 #define write_unlock_irq(a) pthread_rwlock_unlock(&(a)->lock)
 
+/******************************************************************************
+ * rw semaphores
+ *****************************************************************************/
+struct rw_semaphore {
+	pthread_rwlock_t lock;
+};
+
+static inline void
+init_rwsem(struct rw_semaphore *sem)
+{
+	pthread_rwlockattr_t attr;
+
+	pthread_rwlockattr_init(&attr);
+	pthread_rwlockattr_setkind_np(&attr,
+			PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+	pthread_rwlock_init(&sem->lock, &attr);
+	pthread_rwlockattr_destroy(&attr);
+}
+
+#define down_read(a) pthread_rwlock_rdlock(&(a)->lock)
+#define up_read(a) pthread_rwlock_unlock(&(a)->lock)
+#define down_write(a) pthread_rwlock_wrlock(&(a)->lock)
+#define up_write(a) pthread_rwlock_unlock(&(a)->lock)
+
 /******************************************************************************
  * mutexes
  *****************************************************************************/
@@ -834,6 +930,7 @@ void  nvos_iounmap(void __iomem *ptr);
 #define memcpy_fromio memcpy
 #define memcpy_toio memcpy
 #define wmb()
+#define mb() __sync_synchronize()
 
 static inline int
 arch_phys_wc_add(u64 base, u64 size)
@@ -903,6 +1000,10 @@ struct device {
 	struct device_driver *driver;
 	char name[64];
 	void *pm_domain;
+	/* No bus behind the device (benchmarks, simulation), so a page's
+	 * CPU address may stand in as its DMA address.
+	 */
+	bool dma_virt;
 };
 
 #define dev_name(d) (d)->name
@@ -1074,18 +1175,22 @@ dev_iommu_fwspec_get(struct device *dev)
  *****************************************************************************/
 #define DMA_BIT_MASK(a) (((a) == 64) ? ~0ULL : ((1ULL << (a)) - 1))
 
+#define DMA_MAPPING_ERROR (~(dma_addr_t)0)
+
 static inline dma_addr_t
 dma_map_page(struct device *pdev, struct page *page, int offset,
 	     int length, unsigned flags)
 {
-	return 0;
+	if (pdev->dma_virt && page)
+		return (unsigned long)page->addr + offset;
+	return DMA_MAPPING_ERROR;
 }
 
 
 static inline bool
 dma_mapping_error(struct device *pdev, dma_addr_t addr)
 {
-	return true;
+	return addr == DMA_MAPPING_ERROR;
 }
 
 static inline void
@@ -1600,8 +1705,31 @@ extern const struct i2c_algorithm i2c_bit_algo;
  *****************************************************************************/
 #include <unistd.h>
 
-#define udelay(a) usleep((a))
-#define mdelay(a) usleep((a) * 1000)
+/* Busy-waits are precise to well under a microsecond, rather than costing
+ * a trip through the scheduler, and are accounted per call site.
+ */
+struct nvos_delay_site {
+	const char *file;
+	int line;
+	struct nvos_delay_site *next;
+	int registered;
+
+	u64 calls;
+	u64 nsec_req;
+	u64 nsec_act;
+	u64 nsec_max;
+};
+
+void nvos_delay(u64 nsec, struct nvos_delay_site *);
+
+#define nvos_delay_(a) do {                                                    \
+	static struct nvos_delay_site _site = { __FILE__, __LINE__ };          \
+	nvos_delay((a), &_site);                                               \
+} while (0)
+
+#define ndelay(a) nvos_delay_((u64)(a))
+#define udelay(a) nvos_delay_((u64)(a) * 1000)
+#define mdelay(a) nvos_delay_((u64)(a) * 1000000)
 #define msleep(a) usleep((a) * 1000)
 #define usleep_range(a,b) usleep((a))
 
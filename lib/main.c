@@ -36,12 +36,14 @@
 #include "priv.h"
 
 static DEFINE_MUTEX(os_mutex);
+static DEFINE_MUTEX(os_device_mutex);
 static LIST_HEAD(os_device_list);
 static int os_client_nr = 0;
 
 bool os_device_detect = true;
 bool os_device_mmio = true;
 u64  os_device_subdev = ~0ULL;
+int  os_device_threads = 8;
 
 /******************************************************************************
  * horrific stuff to implement linux's ioremap interface on top of pciaccess
@@ -92,21 +94,34 @@ nvos_ioremap_bar(struct pci_device *pdev, int bar, u64 addr)
 void __iomem *
 nvos_ioremap(u64 addr, u64 size)
 {
+	struct pci_device *pdev = NULL;
 	struct os_device *odev;
 	int i;
 
+	/* Devices show up here before they've been probed, and their
+	 * regions aren't valid until pdev has been set.
+	 */
+	mutex_lock(&os_device_mutex);
 	list_for_each_entry(odev, &os_device_list, head) {
-		struct pci_device *pdev = odev->pdev.pdev;
-		for (i = 0; i < ARRAY_SIZE(pdev->regions); i++) {
-			if (addr        >= pdev->regions[i].base_addr &&
-			    addr + size <= pdev->regions[i].base_addr +
-					   pdev->regions[i].size) {
-				return nvos_ioremap_bar(pdev, i, addr);
+		if (!odev->pdev.pdev)
+			continue;
+
+		for (i = 0; i < ARRAY_SIZE(odev->pdev.pdev->regions); i++) {
+			struct pci_mem_region *region =
+				&odev->pdev.pdev->regions[i];
+			if (addr        >= region->base_addr &&
+			    addr + size <= region->base_addr + region->size) {
+				pdev = odev->pdev.pdev;
+				break;
 			}
 		}
+
+		if (pdev)
+			break;
 	}
+	mutex_unlock(&os_device_mutex);
 
-	return NULL;
+	return pdev ? nvos_ioremap_bar(pdev, i, addr) : NULL;
 }
 
 void
@@ -137,31 +152,70 @@ static void
 os_fini_device(struct os_device *odev)
 {
 	nvkm_device_del(&odev->device);
+	mutex_lock(&os_device_mutex);
 	list_del(&odev->head);
+	mutex_unlock(&os_device_mutex);
+	free(odev->cfg);
 	kfree(odev);
 }
 
-static int
-os_init_device(struct pci_device *pdev, const char *cfgopt, const char *dbg)
+struct os_init {
+	struct os_device **odev;
+	struct pci_device **pdev;
+	int *ret;
+	const char *dbg;
+};
+
+static void
+os_init_device(void *priv, int index)
 {
-	struct os_device *odev;
-	char cfg[512];
+	struct os_init *init = priv;
+	struct os_device *odev = init->odev[index];
+	struct pci_device *pdev = init->pdev[index];
 	int ret;
 
 	ret = pci_device_probe(pdev);
 	if (ret) {
 		fprintf(stderr, "pci_device_probe failed, %d\n", ret);
-		return ret;
+		init->ret[index] = ret;
+		return;
 	}
 
+	mutex_lock(&os_device_mutex);
+	odev->pdev.pdev = pdev;
+	mutex_unlock(&os_device_mutex);
+
+	ret = nvkm_device_pci_new(&odev->pdev, odev->cfg, init->dbg,
+				  os_device_detect, os_device_mmio,
+				  os_device_subdev, &odev->device);
+	if (ret)
+		fprintf(stderr, "failed to create device, %d\n", ret);
+	init->ret[index] = ret;
+}
+
+static struct os_device *
+os_device_new(struct pci_device *pdev, const char *cfgopt)
+{
+	const char *fmt = "%s,NvBar2Halve=1";
+	struct os_device *odev;
+	int size;
+
 	odev = calloc(1, sizeof(*odev));
 	if (!odev)
-		return -ENOMEM;
+		return NULL;
+
+	/* nvkm keeps a pointer to the config string. */
+	cfgopt = cfgopt ? cfgopt : "";
+	size = snprintf(NULL, 0, fmt, cfgopt) + 1;
+	if (!(odev->cfg = malloc(size))) {
+		free(odev);
+		return NULL;
+	}
+	snprintf(odev->cfg, size, fmt, cfgopt);
 
 	snprintf(odev->pdev.dev.name, sizeof(odev->pdev.dev.name),
 		 "%04x:%02x:%02x.%1x",
 		 pdev->domain, pdev->bus, pdev->dev, pdev->func);
-	odev->pdev.pdev = pdev;
 	odev->pdev.vendor = pdev->vendor_id;
 	odev->pdev.device = pdev->device_id;
 	odev->pdev.subsystem_vendor = pdev->subvendor_id;
@@ -170,28 +224,21 @@ os_init_device(struct pci_device *pdev, const char *cfgopt, const char *dbg)
 	odev->pdev._bus.number = pdev->bus;
 	odev->pdev.bus = &odev->pdev._bus;
 	odev->pdev.devfn = PCI_DEVFN(pdev->dev, pdev->func);
-	list_add_tail(&odev->head, &os_device_list);
-
-	snprintf(cfg, sizeof(cfg), "%s,NvBar2Halve=1", cfgopt ? cfgopt : "");
-
-	ret = nvkm_device_pci_new(&odev->pdev, cfg, dbg, os_device_detect,
-				  os_device_mmio, os_device_subdev,
-				  &odev->device);
-	if (ret) {
-		fprintf(stderr, "failed to create device, %d\n", ret);
-		os_fini_device(odev);
-		return ret;
-	}
-
-	return 0;
+	return odev;
 }
 
+/* Devices are put on os_device_list in PCI order up-front, and are then
+ * probed and constructed on up to os_device_threads threads at once, as
+ * most of the time goes on BIOS shadowing and the like, which is spent
+ * waiting on each GPU rather than the CPU.
+ */
 static int
 os_init(const char *cfg, const char *dbg)
 {
 	struct pci_device_iterator *iter;
-	struct pci_device *pdev;
-	int ret;
+	struct pci_device *pdev, **pdevs = NULL, **temp;
+	struct os_init init = { .dbg = dbg };
+	int ret, nr = 0, i;
 
 	ret = pci_system_init();
 	if (ret) {
@@ -206,9 +253,40 @@ os_init(const char *cfg, const char *dbg)
 		if (pdev->vendor_id != 0x10de)
 			continue;
 
-		os_init_device(pdev, cfg, dbg);
+		if (!(temp = realloc(pdevs, sizeof(*pdevs) * (nr + 1))))
+			break;
+		pdevs = temp;
+		pdevs[nr++] = pdev;
 	}
 	pci_iterator_destroy(iter);
+
+	init.pdev = pdevs;
+	init.odev = calloc(nr, sizeof(*init.odev));
+	init.ret = calloc(nr, sizeof(*init.ret));
+	if (nr && (!init.odev || !init.ret))
+		nr = 0;
+
+	for (i = 0; i < nr; i++) {
+		if (!(init.odev[i] = os_device_new(pdevs[i], cfg))) {
+			nr = i;
+			break;
+		}
+
+		mutex_lock(&os_device_mutex);
+		list_add_tail(&init.odev[i]->head, &os_device_list);
+		mutex_unlock(&os_device_mutex);
+	}
+
+	os_parallel(nr, os_device_threads, os_init_device, &init);
+
+	for (i = 0; i < nr; i++) {
+		if (init.ret[i])
+			os_fini_device(init.odev[i]);
+	}
+
+	free(init.ret);
+	free(init.odev);
+	free(pdevs);
 	return 0;
 }
 
@@ -221,6 +299,7 @@ os_fini(void)
 		os_fini_device(odev);
 	}
 
+	os_firmware_fini();
 	pci_system_cleanup();
 }
 
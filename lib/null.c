@@ -30,37 +30,83 @@
 #include <nvif/event.h>
 
 #include <core/ioctl.h>
+#include <core/option.h>
 #include <core/pci.h>
 
 #include "priv.h"
 
+/* One null device by default.  "NvNullDevices=N" creates N of them, on
+ * successive buses, in parallel like os_init() does for real GPUs, and
+ * "NvNullProbeDelay=us" has each one sleep for that long beforehand, as
+ * a stand-in for the time a real GPU spends waiting in its probe.
+ */
 static DEFINE_MUTEX(null_mutex);
 static int null_client_nr = 0;
-static struct nvkm_device *null_device;
-static struct pci_dev
-null_pci_dev = {
-	.dev = {
-		.name = "0000:00:00.0",
-	},
-	.pdev = &(struct pci_device) {
-	},
-	.bus = &null_pci_dev._bus,
+static struct null_device {
+	struct nvkm_device *device;
+	struct pci_device pdev;
+	struct pci_dev pci;
+} *null_device;
+static int null_device_nr;
+
+struct null_init {
+	const char *cfg;
+	const char *dbg;
+	long delay;
 };
 
 static void
 null_fini(void)
 {
-	nvkm_device_del(&null_device);
+	int i;
+
+	for (i = 0; i < null_device_nr; i++)
+		nvkm_device_del(&null_device[i].device);
+	free(null_device);
+	null_device = NULL;
+	null_device_nr = 0;
+	os_firmware_fini();
 }
 
 static void
-null_init(const char *cfg, const char *dbg, bool init)
+null_init_device(void *priv, int index)
 {
-	int ret = nvkm_device_pci_new(&null_pci_dev, cfg, dbg, os_device_detect,
-				      os_device_mmio, os_device_subdev,
-				      &null_device);
+	struct null_init *init = priv;
+	struct null_device *ndev = &null_device[index];
+	int ret;
+
+	snprintf(ndev->pci.dev.name, sizeof(ndev->pci.dev.name),
+		 "0000:%02x:00.0", index);
+	ndev->pci.pdev = &ndev->pdev;
+	ndev->pci._bus.number = index;
+	ndev->pci.bus = &ndev->pci._bus;
+
+	if (init->delay)
+		usleep(init->delay);
+
+	ret = nvkm_device_pci_new(&ndev->pci, init->cfg, init->dbg,
+				  os_device_detect, os_device_mmio,
+				  os_device_subdev, &ndev->device);
 	if (ret)
-		null_fini();
+		nvkm_device_del(&ndev->device);
+}
+
+static void
+null_init(const char *cfg, const char *dbg, bool init)
+{
+	struct null_init args = {
+		.cfg = cfg,
+		.dbg = dbg,
+		.delay = nvkm_longopt(cfg, "NvNullProbeDelay", 0),
+	};
+	int nr = clamp(nvkm_longopt(cfg, "NvNullDevices", 1), 1L, 256L);
+
+	null_device = calloc(nr, sizeof(*null_device));
+	if (!null_device)
+		return;
+	null_device_nr = nr;
+
+	os_parallel(null_device_nr, os_device_threads, null_init_device, &args);
 }
 
 static void
@@ -17,4 +17,19 @@ struct os_device {
 extern bool os_device_detect;
 extern bool os_device_mmio;
 extern u64  os_device_subdev;
+extern int  os_device_threads;
+
+void os_parallel(int nr, int threads, void (*)(void *, int), void *);
+
+struct os_firmware_stats {
+	u64 hits;
+	u64 misses;
+	u64 mapped;
+};
+
+void os_firmware_stats(struct os_firmware_stats *);
+void os_firmware_fini(void);
+
+void os_delay_stats(void (*)(const struct nvos_delay_site *, void *), void *);
+void os_delay_reset(void);
 #endif
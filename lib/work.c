@@ -105,3 +105,64 @@ fail_mutex:
 	free(work);
 	return false;
 }
+
+struct os_parallel {
+	pthread_mutex_t mutex;
+	int next;
+	int nr;
+	void (*func)(void *, int);
+	void *priv;
+};
+
+static void *
+os_parallel_thread(void *data)
+{
+	struct os_parallel *par = data;
+	int index;
+
+	for (;;) {
+		pthread_mutex_lock(&par->mutex);
+		index = par->next++;
+		pthread_mutex_unlock(&par->mutex);
+		if (index >= par->nr)
+			break;
+
+		par->func(par->priv, index);
+	}
+
+	return NULL;
+}
+
+/* Calls func() for each index in [0, nr) from up to 'threads' threads at
+ * once, the caller's included, and returns when they've all finished.
+ * Indices are handed out in order, but may complete in any order.
+ */
+void
+os_parallel(int nr, int threads, void (*func)(void *, int), void *priv)
+{
+	struct os_parallel par = {
+		.mutex = PTHREAD_MUTEX_INITIALIZER,
+		.nr = nr,
+		.func = func,
+		.priv = priv,
+	};
+	pthread_t *thread;
+	int i, n = 0;
+
+	if (nr <= 0)
+		return;
+
+	threads = clamp(threads, 1, nr);
+	thread = calloc(threads, sizeof(*thread));
+	for (i = 1; thread && i < threads; i++) {
+		if (!pthread_create(&thread[n], NULL, os_parallel_thread, &par))
+			n++;
+	}
+
+	os_parallel_thread(&par);
+
+	while (n--)
+		pthread_join(thread[n], NULL);
+	free(thread);
+	pthread_mutex_destroy(&par.mutex);
+}